@@ -60,6 +60,14 @@ def parse_args():
     p.add_argument("--df17-weight", type=float, default=1.0,
                    help="Weight for DF17 messages in the objective function")
 
+    p.add_argument("--evaluator",
+                   help="Path to the filter_eval tool (e.g. ../build/filter_eval). "
+                        "Loads the recording once and evaluates a whole population in parallel "
+                        "instead of spawning stream1090 for every candidate")
+
+    p.add_argument("--threads", type=int, default=0,
+                   help="Number of threads used by the evaluator (default: all cores)")
+
     return p.parse_args()
 
 
@@ -228,6 +236,62 @@ def parse_frames(out: bytes):
     return total, long_count, df_counts
 
 
+def parse_eval_line(line: str):
+    """
+    Parses a result line of filter_eval:
+    <total> <long> <DF 0 count> ... <DF 31 count>
+    """
+    values = [int(v) for v in line.split()]
+    total, long_count = values[0], values[1]
+    df_counts = {df: n for df, n in enumerate(values[2:]) if n > 0}
+    return total, long_count, df_counts
+
+# ============================================================
+#  In-process batch evaluator
+# ============================================================
+
+class BatchEvaluator:
+    """
+    Keeps a single filter_eval process alive. The recording is loaded once
+    and each batch of candidates is decoded in parallel.
+    """
+
+    def __init__(self, exe, data, fs, fs_up, threads):
+        cmd = [exe, "-i", data, "-s", str(fs / 1_000_000.0)]
+        if fs_up is not None:
+            cmd += ["-u", str(fs_up / 1_000_000.0)]
+        if threads > 0:
+            cmd += ["-j", str(threads)]
+        self.proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True)
+
+    def evaluate(self, candidates):
+        """
+        candidates is a list of tap vectors or the string "builtin".
+        Returns a list of (total, long_count, df_counts).
+        """
+        for c in candidates:
+            if isinstance(c, str):
+                self.proc.stdin.write(c + "\n")
+            else:
+                self.proc.stdin.write(",".join(repr(float(t)) for t in c) + "\n")
+        self.proc.stdin.write(".\n")
+        self.proc.stdin.flush()
+
+        results = []
+        for _ in candidates:
+            line = self.proc.stdout.readline()
+            if not line:
+                raise RuntimeError("filter_eval terminated unexpectedly")
+            results.append(parse_eval_line(line))
+        return results
+
+    def close(self):
+        self.proc.stdin.close()
+        self.proc.wait()
+
+
+evaluator = BatchEvaluator(args.evaluator, DATA_PATH, FS, FS_UP, args.threads) if args.evaluator else None
+
 # ============================================================
 #  Best-so-far tracking
 # ============================================================
@@ -263,30 +327,35 @@ def evaluate_builtin_filter():
     else:
         output_mhz = default_output_rate(input_mhz)
 
-    cmd = [
-        "bash", "-c",
-        f"cat {DATA_PATH} | {STREAM1090_EXE} "
-        f"-s {input_mhz} "
-        f"-u {output_mhz} "
-        f"-q"
-    ]
+    if evaluator is not None:
+        total, long_count, df_counts = evaluator.evaluate(["builtin"])[0]
+    else:
+        cmd = [
+            "bash", "-c",
+            f"cat {DATA_PATH} | {STREAM1090_EXE} "
+            f"-s {input_mhz} "
+            f"-u {output_mhz} "
+            f"-q"
+        ]
 
-    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE)
-    out, _ = proc.communicate()
+        proc = subprocess.Popen(cmd, stdout=subprocess.PIPE)
+        out, _ = proc.communicate()
 
-    total, long_count, df_counts = parse_frames(out)
-    df17 = df_counts.get(17, 0)
-    # score = total + args.df17_weight * df17
+        total, long_count, df_counts = parse_frames(out)
+
+    score = compute_score(total, long_count, df_counts)
+    return score, total, df_counts.get(17, 0)
+
+
+def compute_score(total, long_count, df_counts):
+    # score = total + args.df17_weight * df_counts.get(17, 0)
     score = total + long_count
     # score = total + df_counts.get(17, 0)
     #score = df_counts.get(17, 0) + df_counts.get(11, 0) * 0.25
-
-    return score, total, df17
+    return score
 
 
 def evaluate_filter(params):
-    global best_score, best_params, best_taps, best_total, best_df17, bounds
-
     h, freq, gain = build_lowpass_firwin2(params, K)
 
     if not is_lowpass(h):
@@ -315,12 +384,36 @@ def evaluate_filter(params):
     out, _ = proc.communicate()
 
     total, long_count, df_counts = parse_frames(out)
+    return record_result(params, h, total, long_count, df_counts)
+
+
+def evaluate_population(population):
+    """
+    Vectorized objective used together with the batch evaluator.
+    population has the shape (K, S), one column per candidate.
+    """
+    candidates = population.T
+    energies = np.full(len(candidates), 1e9)
+
+    taps, indices = [], []
+    for i, params in enumerate(candidates):
+        h, _, _ = build_lowpass_firwin2(params, K)
+        if is_lowpass(h):
+            taps.append(h)
+            indices.append(i)
+
+    for i, h, (total, long_count, df_counts) in zip(indices, taps, evaluator.evaluate(taps)):
+        energies[i] = record_result(candidates[i], h, total, long_count, df_counts)
+
+    return energies
+
+
+def record_result(params, h, total, long_count, df_counts):
+    global best_score, best_params, best_taps, best_total, best_df17, bounds
+
     df17 = df_counts.get(17, 0)
-    # score = total + args.df17_weight * df17
-    score = total + long_count
-    # score = total + df_counts.get(17, 0)
-    #score = df_counts.get(17, 0) + df_counts.get(11, 0) * 0.25
-    
+    score = compute_score(total, long_count, df_counts)
+
     print(score)
 
     if score > best_score:
@@ -396,17 +489,32 @@ with open(LOGFILE, "a") as f:
 while True:
     print("Starting Differential Evolution...")
 
-    result = differential_evolution(
-        evaluate_filter,
-        bounds,
-        maxiter=args.maxiter,
-        popsize=args.popsize,
-        mutation=(0.5, 1.0),
-        recombination=0.7,
-        polish=False,
-        workers=1,
-        x0=center,
-    )
+    if evaluator is not None:
+        # the whole population is evaluated in one batch
+        result = differential_evolution(
+            evaluate_population,
+            bounds,
+            maxiter=args.maxiter,
+            popsize=args.popsize,
+            mutation=(0.5, 1.0),
+            recombination=0.7,
+            polish=False,
+            updating="deferred",
+            vectorized=True,
+            x0=center,
+        )
+    else:
+        result = differential_evolution(
+            evaluate_filter,
+            bounds,
+            maxiter=args.maxiter,
+            popsize=args.popsize,
+            mutation=(0.5, 1.0),
+            recombination=0.7,
+            polish=False,
+            workers=1,
+            x0=center,
+        )
 
     print("\n================ END OF RUN ====================")
     print(f"Best params: {np.round(best_params, 6)}")
@@ -2,6 +2,7 @@
 import curses
 import os
 import signal
+import socket
 import argparse
 
 # -------------------------
@@ -46,6 +47,24 @@ def send_sighup(pid):
         print("Could not send SIGHUP:", e)
 
 
+# -------------------------
+# Control socket helper
+# -------------------------
+
+class ControlClient:
+    """Sends single settings to stream1090 --control <path>, see ControlSocket.hpp"""
+
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.file = self.sock.makefile("rw")
+
+    def send(self, command):
+        self.file.write(command + "\n")
+        self.file.flush()
+        return self.file.readline().strip()
+
+
 # -------------------------
 # Bar drawing helper
 # -------------------------
@@ -122,7 +141,7 @@ def show_help(stdscr):
 # Gain Mixer UI
 # -------------------------
 
-def mixer(stdscr, config_path, pid):
+def mixer(stdscr, config_path, pid, control):
     curses.curs_set(0)
     curses.start_color()
 
@@ -132,6 +151,9 @@ def mixer(stdscr, config_path, pid):
 
     bar_height = 12
     selected = 0
+    # with the control socket the file is only read once, the changes are sent directly
+    cfg = None
+    status = ""
 
     while True:
         h, w = stdscr.getmaxyx()
@@ -145,7 +167,8 @@ def mixer(stdscr, config_path, pid):
                 return
             continue
 
-        cfg = load_config(config_path)
+        if control is None or cfg is None:
+            cfg = load_config(config_path)
 
         if "rtlsdr" in cfg:
             dev = "rtlsdr"
@@ -197,11 +220,14 @@ def mixer(stdscr, config_path, pid):
         footer_y = h - 2
         footer = "←/→ select   ↑/↓ adjust   h help   s SIGHUP   q quit"
         stdscr.addstr(footer_y, 2, footer[:max(0, w - 4)])
+        if status:
+            stdscr.addstr(footer_y - 1, 2, status[:max(0, w - 4)])
 
         stdscr.refresh()
 
         key = stdscr.getch()
         changed = False
+        before = dict(s)
 
         if key == ord('q'):
             break
@@ -210,7 +236,7 @@ def mixer(stdscr, config_path, pid):
             show_help(stdscr)
             continue
 
-        if key == ord('s'):
+        if key == ord('s') and pid is not None:
             send_sighup(pid)
 
         if key == curses.KEY_RIGHT or key == ord('\t'):
@@ -268,7 +294,11 @@ def mixer(stdscr, config_path, pid):
                 s["bias_tee"] = "0" if bias_airspy else "1"
                 changed = True
 
-        if changed:
+        if changed and control is not None:
+            for k, v in s.items():
+                if before.get(k) != v:
+                    status = control.send(f"set {k} {v}")
+        elif changed:
             save_config(config_path, cfg)
             send_sighup(pid)
 
@@ -280,10 +310,14 @@ def mixer(stdscr, config_path, pid):
 def main():
     parser = argparse.ArgumentParser(description="Gain Mixer — interactive SDR gain control")
     parser.add_argument("--config", required=True, help="Path to SDR config INI file")
-    parser.add_argument("--pid", required=True, type=int, help="PID of running daemon")
+    parser.add_argument("--pid", type=int, help="PID of running daemon")
+    parser.add_argument("--socket", help="Control socket of the daemon (--control), instead of rewriting the INI file and SIGHUP")
     args = parser.parse_args()
+    if args.pid is None and args.socket is None:
+        parser.error("either --pid or --socket is required")
 
-    curses.wrapper(mixer, args.config, args.pid)
+    control = ControlClient(args.socket) if args.socket else None
+    curses.wrapper(mixer, args.config, args.pid, control)
 
 
 if __name__ == "__main__":
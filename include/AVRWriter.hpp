@@ -6,8 +6,13 @@
  */
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 
+#include "Bits128.hpp"
+
 namespace hex_detail {
     // LUT construction for byte => 2 hex digits
     consteval std::array<char, 512> make_hex_table() {
@@ -62,7 +67,24 @@ public:
 
     // Writes an AVR short frame with MLAT timestamp and RSSI
     void write_short_MLAT_RSSI(uint64_t ts, uint64_t frameShort, uint8_t rssi) {
-        char* p = m_buf;
+        const size_t n = encodeShort_MLAT_RSSI(m_buf, ts, frameShort, rssi);
+        m_out.write(m_buf, n);
+        m_out.flush();
+    }
+
+    // Writes an AVR long frame with MLAT timestamp and RSSI
+    void write_long_MLAT_RSSI(uint64_t ts, const Bits128& frame, uint8_t rssi) {
+        const size_t n = encodeLong_MLAT_RSSI(m_buf, ts, frame, rssi);
+        m_out.write(m_buf, n);
+        m_out.flush();
+    }
+
+    // longest line, a long frame with MLAT timestamp and RSSI
+    static constexpr size_t MaxEncodedSize = 1 + 12 + 2 + 28 + 2;
+
+    // Encodes an AVR short frame with MLAT timestamp and RSSI into out. Returns the number of bytes.
+    static size_t encodeShort_MLAT_RSSI(char* out, uint64_t ts, uint64_t frameShort, uint8_t rssi) {
+        char* p = out;
 
         *p++ = '<';
         p = write_hex_fixed<12>(p, ts & 0xffffffffffffull);
@@ -71,13 +93,12 @@ public:
         *p++ = ';';
         *p++ = '\n';
 
-        m_out.write(m_buf, p - m_buf);
-        m_out.flush();
+        return size_t(p - out);
     }
 
-    // Writes an AVR long frame with MLAT timestamp and RSSI
-    void write_long_MLAT_RSSI(uint64_t ts, const Bits128& frame, uint8_t rssi) {
-        char* p = m_buf;
+    // Encodes an AVR long frame with MLAT timestamp and RSSI into out. Returns the number of bytes.
+    static size_t encodeLong_MLAT_RSSI(char* out, uint64_t ts, const Bits128& frame, uint8_t rssi) {
+        char* p = out;
 
         *p++ = '<';
         p = write_hex_fixed<12>(p, ts & 0xffffffffffffull);
@@ -87,8 +108,7 @@ public:
         *p++ = ';';
         *p++ = '\n';
 
-        m_out.write(m_buf, p - m_buf);
-        m_out.flush();
+        return size_t(p - out);
     }
 
 private:
@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include "CRC.hpp"
+
+// Index for repairing single bit errors in frames with address parity
+// (DF 0, 4, 5, 16, 20, 21). The crc of such a frame is the address of the
+// transponder. With bit i flipped, it is the address xor the crc of the
+// error pattern, i.e. CRC::compute(encodeFixOp(1, i)).
+//
+// Instead of trying every trusted address for every frame, the index holds
+// address ^ syndrome for all candidate addresses and all bits. Looking up the
+// crc of a frame is then a single probe, no matter how many aircraft are
+// around. A crc that more than one candidate explains, including a candidate
+// without any error, is marked ambiguous and never repaired.
+class AddressParityIndex {
+public:
+	// candidates beyond this are ignored until the next rebuild
+	static constexpr size_t MaxAddresses { 512 };
+
+	// bits that may be flipped, everything except the DF field
+	static constexpr int NumBitsLong { 112 - 5 };
+	static constexpr int NumBitsShort { 56 - 5 };
+
+	// marks an entry of a candidate without error
+	static constexpr uint8_t NoError { 0xff };
+
+	// number of slots, a bit less than half of them are used when full
+	static constexpr uint32_t NumSlotBits { 17 };
+	static constexpr uint32_t NumSlots { 0x1u << NumSlotBits };
+
+	// the crc's of single bit errors, the ones of a short frame are the first NumBitsShort
+	static constexpr std::array<CRC::crc_t, NumBitsLong> Syndromes = [] {
+		std::array<CRC::crc_t, NumBitsLong> res{};
+		for (int i = 0; i < NumBitsLong; i++)
+			res[i] = CRC::compute(CRC::encodeFixOp(0x1, uint8_t(i)));
+		return res;
+	}();
+
+	// a candidate together with the bit to flip
+	struct Match {
+		// the key of the candidate given to add()
+		uint16_t key;
+
+		// the bit to flip, counted from the end of the frame
+		uint8_t bit;
+
+		constexpr bool valid() const noexcept {
+			return bit != NoError;
+		}
+	};
+
+	AddressParityIndex() {
+		m_slots = std::make_unique<Slot[]>(NumSlots);
+		clear();
+	}
+
+	void clear() noexcept {
+		std::fill(m_slots.get(), m_slots.get() + NumSlots, Slot{ 0, 0, 0, Empty });
+		m_numAddresses = 0;
+	}
+
+	// adds the crc's of all single bit errors of address. False if the index is full
+	bool add(uint32_t address, uint16_t key) noexcept {
+		if (m_numAddresses >= MaxAddresses)
+			return false;
+		m_numAddresses++;
+
+		insert(address, key, NoError);
+		for (int i = 0; i < NumBitsLong; i++)
+			insert(address ^ Syndromes[i], key, uint8_t(i));
+		return true;
+	}
+
+	// The candidate and bit that explain crc. Only bits below numBits are
+	// considered, use NumBitsShort or NumBitsLong
+	Match lookup(CRC::crc_t crc, int numBits) const noexcept {
+		for (uint32_t i = hash(crc); ; i = (i + 1) & (NumSlots - 1)) {
+			const auto& slot = m_slots[i];
+			if (slot.state == Empty)
+				return Match{ 0, NoError };
+			if (slot.crc != crc)
+				continue;
+			if ((slot.state == Ambiguous) || (slot.bit == NoError) || (slot.bit >= numBits))
+				return Match{ 0, NoError };
+			return Match{ slot.key, slot.bit };
+		}
+	}
+
+	size_t numAddresses() const noexcept {
+		return m_numAddresses;
+	}
+
+private:
+	enum State : uint8_t { Empty = 0, Used, Ambiguous };
+
+	struct Slot {
+		CRC::crc_t crc;
+		uint16_t key;
+		uint8_t bit;
+		State state;
+	};
+
+	static constexpr uint32_t hash(CRC::crc_t crc) noexcept {
+		return (crc * 0x9E3779B1u) >> (32 - NumSlotBits);
+	}
+
+	void insert(CRC::crc_t crc, uint16_t key, uint8_t bit) noexcept {
+		for (uint32_t i = hash(crc); ; i = (i + 1) & (NumSlots - 1)) {
+			auto& slot = m_slots[i];
+			if (slot.state == Empty) {
+				slot = Slot{ crc, key, bit, Used };
+				return;
+			}
+			if (slot.crc == crc) {
+				slot.state = Ambiguous;
+				return;
+			}
+		}
+	}
+
+	std::unique_ptr<Slot[]> m_slots;
+	size_t m_numAddresses { 0 };
+};
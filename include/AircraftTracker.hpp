@@ -0,0 +1,557 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bits128.hpp"
+#include "CRC.hpp"
+#include "CommB.hpp"
+#include "ModeS.hpp"
+#include "ICAOCache.hpp"
+
+namespace ModeS {
+
+    // the 56-bit ME field of an extended squitter
+    constexpr inline uint64_t extractME_Long(const Bits128& frameLong) {
+        return ((frameLong.high() & 0xffffull) << 40) | (frameLong.low() >> 24);
+    }
+
+    // the AC12 field of an airborne position has no M bit, insert it for decodeAltitude
+    constexpr inline uint16_t ac12ToAc13(uint16_t bits) {
+        return ((bits & 0xfc0) << 1) | (bits & 0x3f);
+    }
+
+} // end of namespace ModeS
+
+namespace CPR {
+
+    // 2^17, resolution of the airborne CPR encoding
+    constexpr double Scale = 131072.0;
+
+    // the latitudes where the number of longitude zones drops by one, NL(lat) = 59 - index
+    constexpr double NLThresholds[] = {
+        10.47047130, 14.82817437, 18.18626357, 21.02939493, 23.54504487, 25.82924707,
+        27.93898710, 29.91135686, 31.77209708, 33.53993436, 35.22899598, 36.85025108,
+        38.41241892, 39.92256684, 41.38651832, 42.80914012, 44.19454951, 45.54626723,
+        46.86733252, 48.16039128, 49.42776439, 50.67150166, 51.89342469, 53.09516153,
+        54.27817472, 55.44378444, 56.59318756, 57.72747354, 58.84763776, 59.95459277,
+        61.04917774, 62.13216659, 63.20427479, 64.26616523, 65.31845310, 66.36171008,
+        67.39646774, 68.42322022, 69.44242631, 70.45451075, 71.45986473, 72.45884545,
+        73.45177442, 74.43893416, 75.42056257, 76.39684391, 77.36789461, 78.33374083,
+        79.29428225, 80.24923213, 81.19801349, 82.13956981, 83.07199445, 83.99173563,
+        84.89166191, 85.75541621, 86.53536998, 87.00000000
+    };
+
+    // number of longitude zones at lat
+    inline int NL(double lat) {
+        lat = std::fabs(lat);
+        int i = 0;
+        for (; i < int(std::size(NLThresholds)); i++) {
+            if (lat < NLThresholds[i])
+                break;
+        }
+        return 59 - i;
+    }
+
+    // modulo that is always positive
+    inline double mod(double a, double b) {
+        return a - b * std::floor(a / b);
+    }
+
+    // Global decoding of an airborne even/odd pair. latest is the parity of the
+    // newer frame, the position is the one of that frame. Returns false if the
+    // two frames are in different longitude zones.
+    inline bool decodeGlobal(const uint32_t lat[2], const uint32_t lon[2], int latest, double& outLat, double& outLon) {
+        constexpr double dLat0 = 360.0 / 60.0;
+        constexpr double dLat1 = 360.0 / 59.0;
+
+        const double j = std::floor((59.0 * lat[0] - 60.0 * lat[1]) / Scale + 0.5);
+        double rlat0 = dLat0 * (mod(j, 60.0) + lat[0] / Scale);
+        double rlat1 = dLat1 * (mod(j, 59.0) + lat[1] / Scale);
+        if (rlat0 >= 270.0) rlat0 -= 360.0;
+        if (rlat1 >= 270.0) rlat1 -= 360.0;
+
+        if (NL(rlat0) != NL(rlat1))
+            return false;
+
+        const double rlat = latest ? rlat1 : rlat0;
+        const int nl = NL(rlat);
+        const int ni = std::max(nl - latest, 1);
+        const double m = std::floor((lon[0] * (nl - 1.0) - lon[1] * double(nl)) / Scale + 0.5);
+        double rlon = (360.0 / ni) * (mod(m, ni) + lon[latest] / Scale);
+        if (rlon >= 180.0) rlon -= 360.0;
+
+        outLat = rlat;
+        outLon = rlon;
+        return true;
+    }
+
+    // Local decoding of a single airborne frame relative to a position that is
+    // known to be within 180 NM.
+    inline void decodeLocal(uint32_t lat, uint32_t lon, int parity, double refLat, double refLon, double& outLat, double& outLon) {
+        const double dLat = 360.0 / (60.0 - parity);
+        const double j = std::floor(refLat / dLat) + std::floor(0.5 + mod(refLat, dLat) / dLat - lat / Scale);
+        const double rlat = dLat * (j + lat / Scale);
+
+        const int ni = std::max(NL(rlat) - parity, 1);
+        const double dLon = 360.0 / ni;
+        const double m = std::floor(refLon / dLon) + std::floor(0.5 + mod(refLon, dLon) / dLon - lon / Scale);
+        double rlon = dLon * (m + lon / Scale);
+        if (rlon >= 180.0) rlon -= 360.0;
+
+        outLat = rlat;
+        outLon = rlon;
+    }
+
+} // end of namespace CPR
+
+// The decoded state of one aircraft
+struct Aircraft {
+    enum : uint8_t {
+        HasCallsign = 0x1,
+        HasAltitude = 0x2,
+        HasSquawk   = 0x4,
+        HasVelocity = 0x8,
+        HasPosition = 0x10,
+        // from Comm-B replies
+        HasSelectedAltitude = 0x20,
+        HasTrackAndTurn     = 0x40,
+        HasHeadingAndSpeed  = 0x80
+    };
+
+    // 24-bit address, 0 if the slot is empty
+    uint32_t icao;
+    uint32_t numMessages;
+    uint8_t valid;
+    char callsign[9];
+    uint16_t squawk;
+    int32_t altitude;
+    int32_t verticalRate;
+    float groundSpeed;
+    float track;
+    double lat;
+    double lon;
+    // BDS 4,0
+    int32_t selectedAltitude;
+    // BDS 5,0
+    float roll;
+    float trueAirspeed;
+    // BDS 6,0
+    float magHeading;
+    float indicatedAirspeed;
+    float mach;
+    // MLAT timestamps (12 MHz) of the last frame and the last position
+    uint64_t lastSeen;
+    uint64_t lastPosition;
+    // the last even (0) and odd (1) CPR frame
+    uint32_t cprLat[2];
+    uint32_t cprLon[2];
+    uint64_t cprTime[2];
+};
+
+// Keeps the state of the aircraft seen recently. The table uses the same slots
+// as ICAOTable, i.e., the lower 16 bits of the address. The frames are decoded
+// one by one on the thread that calls handleShort/handleLong without any
+// allocations. Once per second (on the MLAT clock) the live aircraft are copied
+// into a snapshot that another thread may pick up with waitForSnapshot.
+class AircraftTracker {
+public:
+    static constexpr size_t Size = ICAOTable::Size;
+    static constexpr uint32_t HashMask = ICAOTable::HashMask;
+    static constexpr uint64_t TicksPerSecond = 12'000'000;
+    // aircraft not heard of for this long are not in the snapshot anymore
+    static constexpr uint64_t TimeoutTicks = 60 * TicksPerSecond;
+    // maximum time between an even and an odd frame for global decoding
+    static constexpr uint64_t CprPairTicks = 10 * TicksPerSecond;
+    // maximum age of the last position to use it as reference for local decoding
+    static constexpr uint64_t CprLocalTicks = 30 * TicksPerSecond;
+
+    AircraftTracker()
+        : m_table(std::make_unique<Aircraft[]>(Size)),
+          m_snapshot(std::make_unique<Aircraft[]>(Size))
+    {
+        std::fill(m_table.get(), m_table.get() + Size, Aircraft{});
+    }
+
+    void handleShort(uint64_t mlat, uint64_t frame) noexcept {
+        const uint8_t df = (frame >> 51) & 0x1f;
+        Aircraft* a = nullptr;
+        if (df == 11) {
+            a = claim(ModeS::extractICAOWithCA_Short(frame) & 0xffffff, mlat);
+        } else {
+            a = find(CRC::compute<56>(Bits128(frame)), mlat);
+        }
+
+        if (a) {
+            const uint16_t bits = ModeS::extractSquawkAlt_Short(frame);
+            if (df == 0 || df == 4)
+                updateAltitude(*a, ModeS::decodeAltitude(bits));
+            else if (df == 5)
+                updateSquawk(*a, bits);
+        }
+        publishIfDue(mlat);
+    }
+
+    void handleLong(uint64_t mlat, const Bits128& frame) noexcept {
+        const uint8_t df = (frame.high() >> 43) & 0x1f;
+        if (df == 17 || df == 18) {
+            if (Aircraft* a = claim(ModeS::extractICAOWithCA_Long(frame) & 0xffffff, mlat))
+                decodeExtendedSquitter(*a, mlat, ModeS::extractME_Long(frame));
+        } else if (Aircraft* a = find(CRC::compute<112>(frame), mlat)) {
+            const uint16_t bits = ModeS::extractSquawkAlt_Long(frame);
+            if (df == 16 || df == 20)
+                updateAltitude(*a, ModeS::decodeAltitude(bits));
+            else if (df == 21)
+                updateSquawk(*a, bits);
+
+            // the MB field is at the same position as the ME field
+            if (df == 20 || df == 21)
+                decodeCommB(*a, ModeS::extractME_Long(frame));
+        }
+        publishIfDue(mlat);
+    }
+
+    // number of Comm-B replies per inferred register
+    using CommBCounts = std::array<uint64_t, size_t(CommB::BDS::NumTypes)>;
+
+    // Copies the live aircraft into the snapshot. Unless block is set, this does
+    // not wait. If the snapshot is being read right now, this round is skipped.
+    void publish(uint64_t now, bool block = false) noexcept {
+        std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+        if (block)
+            lock.lock();
+        else if (!lock.try_lock())
+            return;
+
+        size_t n = 0;
+        for (size_t i = 0; i < Size; i++) {
+            const Aircraft& a = m_table[i];
+            if (a.icao != 0 && a.lastSeen + TimeoutTicks >= now)
+                m_snapshot[n++] = a;
+        }
+        m_snapshotSize = n;
+        m_snapshotCommB = m_commB;
+        m_snapshotTime = now;
+        m_snapshotVersion++;
+        lock.unlock();
+        m_condVar.notify_one();
+    }
+
+    // Waits until there is a new snapshot and copies it into out. Returns false on timeout.
+    template<typename Rep, typename Period>
+    bool waitForSnapshot(std::vector<Aircraft>& out, CommBCounts& commB, uint64_t& now, uint64_t& version,
+                         const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_condVar.wait_for(lock, timeout, [&] { return m_snapshotVersion != version; }))
+            return false;
+
+        out.assign(m_snapshot.get(), m_snapshot.get() + m_snapshotSize);
+        commB = m_snapshotCommB;
+        now = m_snapshotTime;
+        version = m_snapshotVersion;
+        return true;
+    }
+
+    // the current time on the MLAT clock
+    uint64_t now() const noexcept {
+        return m_now;
+    }
+
+private:
+    // slot of icao if the address is given in clear (DF11/17/18). Takes over the slot.
+    Aircraft* claim(uint32_t icao, uint64_t mlat) noexcept {
+        Aircraft& a = m_table[icao & HashMask];
+        if (a.icao != icao) {
+            a = Aircraft{};
+            a.icao = icao;
+        }
+        a.numMessages++;
+        a.lastSeen = mlat;
+        return &a;
+    }
+
+    // slot of icao if the address has been seen in clear before
+    Aircraft* find(uint32_t icao, uint64_t mlat) noexcept {
+        Aircraft& a = m_table[icao & HashMask];
+        if (a.icao != icao)
+            return nullptr;
+        a.numMessages++;
+        a.lastSeen = mlat;
+        return &a;
+    }
+
+    static void updateAltitude(Aircraft& a, uint16_t altitude) noexcept {
+        if (altitude == 0)
+            return;
+        a.altitude = altitude;
+        a.valid |= Aircraft::HasAltitude;
+    }
+
+    static void updateSquawk(Aircraft& a, uint16_t bits) noexcept {
+        a.squawk = ModeS::decodeSquawk(bits);
+        a.valid |= Aircraft::HasSquawk;
+    }
+
+    void decodeExtendedSquitter(Aircraft& a, uint64_t mlat, uint64_t me) noexcept {
+        const uint8_t tc = (me >> 51) & 0x1f;
+        if (tc >= 1 && tc <= 4) {
+            decodeCallsign(a, me);
+        } else if ((tc >= 9 && tc <= 18) || (tc >= 20 && tc <= 22)) {
+            // GNSS height (TC 20 to 22) is not a barometric altitude
+            if (tc <= 18)
+                updateAltitude(a, ModeS::decodeAltitude(ModeS::ac12ToAc13((me >> 36) & 0xfff)));
+            decodeAirbornePosition(a, mlat, me);
+        } else if (tc == 19) {
+            decodeVelocity(a, me);
+        }
+    }
+
+    static void decodeCallsign(Aircraft& a, uint64_t me) noexcept {
+        static constexpr char Charset[] =
+            "#ABCDEFGHIJKLMNOPQRSTUVWXYZ##### ###############0123456789######";
+        for (int i = 0; i < 8; i++) {
+            a.callsign[i] = Charset[(me >> (42 - 6 * i)) & 0x3f];
+        }
+        // no trailing spaces
+        int len = 8;
+        while (len > 0 && a.callsign[len - 1] == ' ')
+            len--;
+        a.callsign[len] = '\0';
+        a.valid |= Aircraft::HasCallsign;
+    }
+
+    static void decodeVelocity(Aircraft& a, uint64_t me) noexcept {
+        const uint8_t subtype = (me >> 48) & 0x7;
+        // ground speed only, airspeed and heading are not tracked
+        if (subtype == 1 || subtype == 2) {
+            const int ewRaw = (me >> 32) & 0x3ff;
+            const int nsRaw = (me >> 21) & 0x3ff;
+            if (ewRaw == 0 || nsRaw == 0)
+                return;
+
+            const int factor = (subtype == 2) ? 4 : 1;
+            const double ew = double((ewRaw - 1) * factor) * (((me >> 42) & 0x1) ? -1.0 : 1.0);
+            const double ns = double((nsRaw - 1) * factor) * (((me >> 31) & 0x1) ? -1.0 : 1.0);
+            a.groundSpeed = float(std::sqrt(ew * ew + ns * ns));
+            a.track = float(CPR::mod(std::atan2(ew, ns) * 180.0 / M_PI, 360.0));
+            a.valid |= Aircraft::HasVelocity;
+        }
+
+        const int vrRaw = (me >> 10) & 0x1ff;
+        if (vrRaw != 0) {
+            a.verticalRate = (vrRaw - 1) * 64 * (((me >> 19) & 0x1) ? -1 : 1);
+        }
+    }
+
+    // Infers the register of a Comm-B reply and takes over its values
+    void decodeCommB(Aircraft& a, uint64_t mb) noexcept {
+        CommB::Reference ref{};
+        std::copy(std::begin(a.callsign), std::end(a.callsign), ref.callsign);
+        ref.hasCallsign = a.valid & Aircraft::HasCallsign;
+        ref.hasVelocity = a.valid & Aircraft::HasVelocity;
+        ref.groundSpeed = a.groundSpeed;
+        ref.track = a.track;
+        ref.verticalRate = a.verticalRate;
+
+        CommB::Decoded d;
+        const CommB::BDS bds = CommB::infer(mb, ref, d);
+        m_commB[size_t(bds)]++;
+
+        switch (bds) {
+            case CommB::BDS::BDS20:
+                std::copy(std::begin(d.callsign), std::end(d.callsign), a.callsign);
+                a.valid |= Aircraft::HasCallsign;
+                break;
+            case CommB::BDS::BDS40:
+                a.selectedAltitude = d.selectedAltitude;
+                a.valid |= Aircraft::HasSelectedAltitude;
+                break;
+            case CommB::BDS::BDS50:
+                if (!d.hasRoll || !d.hasTrueAirspeed)
+                    break;
+                a.roll = d.roll;
+                a.trueAirspeed = d.trueAirspeed;
+                a.valid |= Aircraft::HasTrackAndTurn;
+                break;
+            case CommB::BDS::BDS60:
+                if (!d.hasMagHeading || !d.hasIndicatedAirspeed || !d.hasMach)
+                    break;
+                a.magHeading = d.magHeading;
+                a.indicatedAirspeed = d.indicatedAirspeed;
+                a.mach = d.mach;
+                a.valid |= Aircraft::HasHeadingAndSpeed;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Global decoding needs an even and an odd frame. Once the position is known,
+    // every further frame is decoded locally against the last position.
+    void decodeAirbornePosition(Aircraft& a, uint64_t mlat, uint64_t me) noexcept {
+        const int parity = (me >> 34) & 0x1;
+        a.cprLat[parity] = (me >> 17) & 0x1ffff;
+        a.cprLon[parity] = me & 0x1ffff;
+        a.cprTime[parity] = mlat;
+
+        double lat = 0.0;
+        double lon = 0.0;
+        const uint64_t other = a.cprTime[parity ^ 1];
+        if (other != 0 && mlat - other <= CprPairTicks) {
+            if (!CPR::decodeGlobal(a.cprLat, a.cprLon, parity, lat, lon))
+                return;
+        } else if ((a.valid & Aircraft::HasPosition) && mlat - a.lastPosition <= CprLocalTicks) {
+            CPR::decodeLocal(a.cprLat[parity], a.cprLon[parity], parity, a.lat, a.lon, lat, lon);
+        } else {
+            return;
+        }
+
+        a.lat = lat;
+        a.lon = lon;
+        a.lastPosition = mlat;
+        a.valid |= Aircraft::HasPosition;
+    }
+
+    void publishIfDue(uint64_t mlat) noexcept {
+        m_now = std::max(m_now, mlat);
+        if (m_now >= m_nextPublish) {
+            publish(m_now);
+            m_nextPublish = m_now + TicksPerSecond;
+        }
+    }
+
+    // only used by the decoding thread
+    std::unique_ptr<Aircraft[]> m_table;
+    CommBCounts m_commB{};
+    uint64_t m_now = 0;
+    uint64_t m_nextPublish = 0;
+
+    // shared with the reading thread
+    std::mutex m_mutex;
+    std::condition_variable m_condVar;
+    std::unique_ptr<Aircraft[]> m_snapshot;
+    size_t m_snapshotSize = 0;
+    CommBCounts m_snapshotCommB{};
+    uint64_t m_snapshotTime = 0;
+    uint64_t m_snapshotVersion = 0;
+};
+
+// Writes the snapshots of an AircraftTracker as JSON to a file. The file is
+// written to a temporary file first and then renamed, so readers never see a
+// partial file.
+class AircraftJsonWriter {
+public:
+    AircraftJsonWriter(AircraftTracker& tracker, const std::string& filename)
+        : m_tracker(tracker), m_filename(filename)
+    {
+        m_aircraft.reserve(AircraftTracker::Size);
+        m_thread = std::thread([this] { loop(); });
+    }
+
+    ~AircraftJsonWriter() {
+        stop();
+    }
+
+    // publishes the current state one last time, writes it and stops the thread
+    void stop() {
+        if (!m_thread.joinable())
+            return;
+        m_tracker.publish(m_tracker.now(), true);
+        m_stop.store(true);
+        m_thread.join();
+    }
+
+private:
+    void loop() {
+        using namespace std::chrono_literals;
+        uint64_t version = 0;
+        uint64_t now = 0;
+        for (;;) {
+            // read the stop flag first, the final snapshot is published before it is set
+            const bool stop = m_stop.load();
+            if (m_tracker.waitForSnapshot(m_aircraft, m_commB, now, version, 200ms))
+                write(now);
+            else if (stop)
+                break;
+        }
+    }
+
+    void write(uint64_t now) {
+        const std::string tmp = m_filename + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            if (!out.is_open())
+                return;
+
+            out << std::fixed;
+            out << "{\"now\":" << std::setprecision(1) << double(now) / AircraftTracker::TicksPerSecond
+                << ",\"aircraft\":[";
+            bool first = true;
+            for (const auto& a : m_aircraft) {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                writeAircraft(out, a, now);
+            }
+            out << "\n],\"commb\":{";
+            for (size_t i = 0; i < m_commB.size(); i++) {
+                out << (i ? "," : "") << "\"" << CommB::toString(CommB::BDS(i)) << "\":" << m_commB[i];
+            }
+            out << "}}\n";
+        }
+        std::rename(tmp.c_str(), m_filename.c_str());
+    }
+
+    static void writeAircraft(std::ostream& out, const Aircraft& a, uint64_t now) {
+        const double seen = double(now - std::min(now, a.lastSeen)) / AircraftTracker::TicksPerSecond;
+        out << "{\"hex\":\"" << std::hex << std::setw(6) << std::setfill('0') << a.icao << std::dec << "\"";
+        if (a.valid & Aircraft::HasCallsign)
+            out << ",\"flight\":\"" << a.callsign << "\"";
+        if (a.valid & Aircraft::HasAltitude)
+            out << ",\"alt_baro\":" << a.altitude;
+        if (a.valid & Aircraft::HasSquawk)
+            out << ",\"squawk\":\"" << std::setw(4) << std::setfill('0') << a.squawk << "\"";
+        if (a.valid & Aircraft::HasVelocity)
+            out << std::setprecision(1) << ",\"gs\":" << a.groundSpeed << ",\"track\":" << a.track
+                << ",\"baro_rate\":" << a.verticalRate;
+        if (a.valid & Aircraft::HasPosition) {
+            const double seenPos = double(now - std::min(now, a.lastPosition)) / AircraftTracker::TicksPerSecond;
+            out << std::setprecision(6) << ",\"lat\":" << a.lat << ",\"lon\":" << a.lon
+                << std::setprecision(1) << ",\"seen_pos\":" << seenPos;
+        }
+        if (a.valid & Aircraft::HasSelectedAltitude)
+            out << ",\"nav_altitude_mcp\":" << a.selectedAltitude;
+        if (a.valid & Aircraft::HasTrackAndTurn)
+            out << std::setprecision(1) << ",\"roll\":" << a.roll << ",\"tas\":" << a.trueAirspeed;
+        if (a.valid & Aircraft::HasHeadingAndSpeed)
+            out << std::setprecision(1) << ",\"mag_heading\":" << a.magHeading << ",\"ias\":" << a.indicatedAirspeed
+                << std::setprecision(3) << ",\"mach\":" << a.mach;
+        out << std::setprecision(1) << ",\"seen\":" << seen << ",\"messages\":" << a.numMessages << "}";
+    }
+
+    AircraftTracker& m_tracker;
+    std::string m_filename;
+    std::vector<Aircraft> m_aircraft;
+    AircraftTracker::CommBCounts m_commB{};
+    std::atomic<bool> m_stop{false};
+    std::thread m_thread;
+};
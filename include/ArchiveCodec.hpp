@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// A small LZ77 codec in the spirit of LZ4 for the blocks of the frame archive.
+// No dependencies, one pass, a hash table of recent 4-byte sequences.
+//
+// The compressed stream is a list of sequences:
+//   token: upper 4 bits literal length, lower 4 bits match length - 4
+//   [255...] more literal length if the upper 4 bits are 15
+//   literals
+//   offset: 2 bytes little endian            (not present in the last sequence)
+//   [255...] more match length if the lower 4 bits are 15
+// The last sequence has literals only and ends the stream.
+namespace ArchiveCodec {
+
+    enum Codec : uint8_t {
+        None = 0,
+        LZ = 1
+    };
+
+    static constexpr size_t MinMatch = 4;
+    static constexpr size_t HashBits = 12;
+    static constexpr size_t MaxOffset = 65535;
+
+    // upper bound of the compressed size of n bytes
+    constexpr size_t maxCompressedSize(size_t n) {
+        return n + n / 255 + 16;
+    }
+
+    namespace detail {
+        inline uint32_t read32(const uint8_t* p) {
+            uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        inline uint32_t hash(uint32_t v) {
+            return (v * 2654435761u) >> (32 - HashBits);
+        }
+
+        inline void writeLength(std::vector<uint8_t>& out, size_t len) {
+            while (len >= 255) {
+                out.push_back(255);
+                len -= 255;
+            }
+            out.push_back(uint8_t(len));
+        }
+    }
+
+    // Appends the compressed src to out
+    inline void compress(const uint8_t* src, size_t n, std::vector<uint8_t>& out) {
+        using namespace detail;
+        std::array<uint32_t, size_t(1) << HashBits> table;
+        table.fill(UINT32_MAX);
+
+        size_t anchor = 0;
+        size_t i = 0;
+        while (i + MinMatch <= n) {
+            const uint32_t v = read32(src + i);
+            const uint32_t h = hash(v);
+            const uint32_t cand = table[h];
+            table[h] = uint32_t(i);
+
+            if (cand == UINT32_MAX || i - cand > MaxOffset || read32(src + cand) != v) {
+                i++;
+                continue;
+            }
+
+            size_t len = MinMatch;
+            while (i + len < n && src[cand + len] == src[i + len])
+                len++;
+
+            const size_t litLen = i - anchor;
+            const size_t matchLen = len - MinMatch;
+            out.push_back(uint8_t((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(matchLen, 15)));
+            if (litLen >= 15)
+                writeLength(out, litLen - 15);
+            out.insert(out.end(), src + anchor, src + i);
+            const size_t offset = i - cand;
+            out.push_back(uint8_t(offset));
+            out.push_back(uint8_t(offset >> 8));
+            if (matchLen >= 15)
+                writeLength(out, matchLen - 15);
+
+            i += len;
+            anchor = i;
+        }
+
+        // the remaining literals
+        const size_t litLen = n - anchor;
+        out.push_back(uint8_t(std::min<size_t>(litLen, 15) << 4));
+        if (litLen >= 15)
+            writeLength(out, litLen - 15);
+        out.insert(out.end(), src + anchor, src + n);
+    }
+
+    // Decompresses src into dst which has room for exactly rawSize bytes.
+    // Returns false if the stream is corrupt.
+    inline bool decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t rawSize) {
+        size_t ip = 0;
+        size_t op = 0;
+
+        auto readLength = [&](size_t len) -> size_t {
+            if (len != 15)
+                return len;
+            uint8_t b;
+            do {
+                if (ip >= n)
+                    return SIZE_MAX;
+                b = src[ip++];
+                len += b;
+            } while (b == 255);
+            return len;
+        };
+
+        while (ip < n) {
+            const uint8_t token = src[ip++];
+            const size_t litLen = readLength(token >> 4);
+            if (litLen == SIZE_MAX || ip + litLen > n || op + litLen > rawSize)
+                return false;
+            std::memcpy(dst + op, src + ip, litLen);
+            ip += litLen;
+            op += litLen;
+
+            // the last sequence has no match
+            if (ip == n)
+                break;
+
+            if (ip + 2 > n)
+                return false;
+            const size_t offset = size_t(src[ip]) | (size_t(src[ip + 1]) << 8);
+            ip += 2;
+            const size_t matchLen = readLength(token & 0xf);
+            if (matchLen == SIZE_MAX || offset == 0 || offset > op || op + matchLen + MinMatch > rawSize)
+                return false;
+
+            // the match may overlap with the output, copy byte by byte
+            const uint8_t* m = dst + op - offset;
+            for (size_t k = 0; k < matchLen + MinMatch; k++) {
+                dst[op + k] = m[k];
+            }
+            op += matchLen + MinMatch;
+        }
+        return op == rawSize;
+    }
+
+} // end of namespace ArchiveCodec
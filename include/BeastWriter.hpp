@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+#include "Bits128.hpp"
+
+// Encoder for the binary Beast format as read by readsb, dump1090 and most MLAT clients:
+//   0x1a, type ('2' short frame, '3' long frame), 6 bytes MLAT timestamp (12 MHz),
+//   1 byte signal level, 7 or 14 bytes frame
+// Every 0x1a after the type byte is escaped by a second 0x1a.
+class BeastWriter {
+public:
+    static constexpr uint8_t Escape = 0x1a;
+    // worst case, everything escaped
+    static constexpr size_t MaxEncodedSize = 2 + 2 * (6 + 1 + 14);
+
+    BeastWriter(std::ostream& out) : m_out(out) {}
+
+    void write_short(uint64_t ts, uint64_t frameShort, uint8_t rssi) {
+        const size_t n = encodeShort(m_buf, ts, frameShort, rssi);
+        m_out.write(reinterpret_cast<const char*>(m_buf), n);
+    }
+
+    void write_long(uint64_t ts, const Bits128& frame, uint8_t rssi) {
+        const size_t n = encodeLong(m_buf, ts, frame, rssi);
+        m_out.write(reinterpret_cast<const char*>(m_buf), n);
+    }
+
+    // encodes a short frame into out (at least MaxEncodedSize bytes). Returns the number of bytes.
+    static size_t encodeShort(uint8_t* out, uint64_t ts, uint64_t frameShort, uint8_t rssi) {
+        uint8_t* p = out;
+        *p++ = Escape;
+        *p++ = '2';
+        p = putEscaped(p, ts, 6);
+        p = putEscaped(p, rssi, 1);
+        p = putEscaped(p, frameShort, 7);
+        return size_t(p - out);
+    }
+
+    // encodes a long frame into out (at least MaxEncodedSize bytes). Returns the number of bytes.
+    static size_t encodeLong(uint8_t* out, uint64_t ts, const Bits128& frame, uint8_t rssi) {
+        uint8_t* p = out;
+        *p++ = Escape;
+        *p++ = '3';
+        p = putEscaped(p, ts, 6);
+        p = putEscaped(p, rssi, 1);
+        p = putEscaped(p, frame.high(), 6);
+        p = putEscaped(p, frame.low(), 8);
+        return size_t(p - out);
+    }
+
+private:
+    // the lower numBytes bytes of value, big endian
+    static uint8_t* putEscaped(uint8_t* p, uint64_t value, int numBytes) {
+        for (int i = numBytes - 1; i >= 0; i--) {
+            const uint8_t b = uint8_t(value >> (8 * i));
+            *p++ = b;
+            if (b == Escape)
+                *p++ = Escape;
+        }
+        return p;
+    }
+
+    uint8_t m_buf[MaxEncodedSize];
+    std::ostream& m_out;
+};
@@ -0,0 +1,216 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Capture of the demodulated bitstream, i.e., what the slicer in SampleStream::read
+// hands over to DemodCore::shiftInNewBits. Replaying a capture runs only the
+// demodulator, which makes experiments with DemodCore much faster and bit-exact
+// reproducible.
+//
+// File layout (little endian):
+//   Header
+//   for every 1 MHz tick:
+//      ceil(NumStreams / 8) bytes with the packed slicer bits (stream 0 = lsb of byte 0)
+//      1 byte RSSI as returned by SampleStream::getRSSI() for this tick (if FlagRSSI is set)
+namespace BitCapture {
+
+    static constexpr char Magic[8] = { 'S', '1', '0', '9', '0', 'B', 'I', 'T' };
+    static constexpr uint32_t Version = 1;
+    static constexpr uint32_t FlagRSSI = 0x1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t numStreams;
+        uint32_t inputRate;
+        uint32_t outputRate;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Header) == 32);
+
+    constexpr size_t bytesPerTick(size_t numStreams, bool withRSSI) {
+        return (numStreams + 7) / 8 + (withRSSI ? 1 : 0);
+    }
+
+    template<int NumStreams>
+    class Writer {
+    public:
+        static constexpr size_t NumBitBytes  = (NumStreams + 7) / 8;
+        static constexpr size_t BytesPerTick = NumBitBytes + 1;
+        // number of ticks buffered before writing to the file
+        static constexpr size_t TicksPerChunk = 65536;
+
+        bool open(const std::string& filename, uint32_t inputRate, uint32_t outputRate) {
+            m_out.open(filename, std::ios::binary | std::ios::trunc);
+            if (!m_out.is_open())
+                return false;
+
+            Header header{};
+            std::memcpy(header.magic, Magic, sizeof(Magic));
+            header.version    = Version;
+            header.numStreams = NumStreams;
+            header.inputRate  = inputRate;
+            header.outputRate = outputRate;
+            header.flags      = FlagRSSI;
+            m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            m_buffer.assign(TicksPerChunk * BytesPerTick, 0);
+            m_pos = 0;
+            return m_out.good();
+        }
+
+        ~Writer() {
+            close();
+        }
+
+        // appends one tick, i.e., NumStreams bits (each 0 or 1) and the RSSI at this tick
+        void push(const uint32_t* bits, uint8_t rssi) noexcept {
+            uint8_t* p = m_buffer.data() + m_pos;
+            for (size_t b = 0; b < NumBitBytes; b++) {
+                uint8_t v = 0;
+                for (size_t k = 0; (k < 8) && (b * 8 + k < NumStreams); k++) {
+                    v |= uint8_t(bits[b * 8 + k] << k);
+                }
+                p[b] = v;
+            }
+            p[NumBitBytes] = rssi;
+            m_pos += BytesPerTick;
+
+            if (m_pos == m_buffer.size()) {
+                flush();
+            }
+        }
+
+        void close() {
+            if (m_out.is_open()) {
+                flush();
+                m_out.close();
+            }
+        }
+
+    private:
+        void flush() {
+            m_out.write(reinterpret_cast<const char*>(m_buffer.data()), m_pos);
+            m_pos = 0;
+        }
+
+        std::ofstream m_out;
+        std::vector<uint8_t> m_buffer;
+        size_t m_pos = 0;
+    };
+
+    // Reads a capture tick by tick. The reader is not templated, the number
+    // of streams is only known after reading the header.
+    class Reader {
+    public:
+        static constexpr size_t TicksPerChunk = 65536;
+
+        bool open(const std::string& filename) {
+            m_in.open(filename, std::ios::binary);
+            if (!m_in.is_open())
+                return false;
+
+            if (!m_in.read(reinterpret_cast<char*>(&m_header), sizeof(m_header)))
+                return false;
+
+            if (std::memcmp(m_header.magic, Magic, sizeof(Magic)) != 0 || m_header.version != Version)
+                return false;
+
+            m_bytesPerTick = bytesPerTick(m_header.numStreams, hasRSSI());
+            m_buffer.resize(TicksPerChunk * m_bytesPerTick);
+            m_pos = m_end = 0;
+            return true;
+        }
+
+        const Header& header() const noexcept { return m_header; }
+
+        bool hasRSSI() const noexcept { return (m_header.flags & FlagRSSI) != 0; }
+
+        // reads the next tick. Unpacks the bits into bits[0..numStreams-1].
+        // Returns false if there are no more ticks.
+        bool next(uint32_t* bits, uint8_t& rssi) {
+            if (m_pos == m_end && !fill())
+                return false;
+
+            const uint8_t* p = m_buffer.data() + m_pos;
+            for (size_t j = 0; j < m_header.numStreams; j++) {
+                bits[j] = (p[j >> 3] >> (j & 7)) & 0x1;
+            }
+            rssi = hasRSSI() ? p[(m_header.numStreams + 7) / 8] : 0;
+            m_pos += m_bytesPerTick;
+            return true;
+        }
+
+    private:
+        bool fill() {
+            m_in.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size());
+            // only complete ticks
+            m_end = (size_t(m_in.gcount()) / m_bytesPerTick) * m_bytesPerTick;
+            m_pos = 0;
+            return m_end > 0;
+        }
+
+        std::ifstream m_in;
+        Header m_header{};
+        size_t m_bytesPerTick = 0;
+        std::vector<uint8_t> m_buffer;
+        size_t m_pos = 0;
+        size_t m_end = 0;
+    };
+
+    // A complete capture held in memory. Several threads may replay it at the same time.
+    struct Capture {
+        Header header{};
+        size_t bytesPerTick = 0;
+        std::vector<uint8_t> data;
+
+        size_t numTicks() const noexcept {
+            return bytesPerTick ? data.size() / bytesPerTick : 0;
+        }
+
+        // same as Reader::next, but for an arbitrary tick
+        void unpack(size_t tick, uint32_t* bits, uint8_t& rssi) const noexcept {
+            const uint8_t* p = data.data() + tick * bytesPerTick;
+            for (size_t j = 0; j < header.numStreams; j++) {
+                bits[j] = (p[j >> 3] >> (j & 7)) & 0x1;
+            }
+            rssi = (header.flags & FlagRSSI) ? p[(header.numStreams + 7) / 8] : 0;
+        }
+    };
+
+    // reads a whole capture into memory. Returns false on failure.
+    inline bool loadCapture(const std::string& filename, Capture& out) {
+        std::ifstream in(filename, std::ios::binary | std::ios::ate);
+        if (!in.is_open())
+            return false;
+
+        const auto numBytes = static_cast<size_t>(in.tellg());
+        if (numBytes < sizeof(Header))
+            return false;
+        in.seekg(0);
+
+        if (!in.read(reinterpret_cast<char*>(&out.header), sizeof(Header)))
+            return false;
+
+        if (std::memcmp(out.header.magic, Magic, sizeof(Magic)) != 0 || out.header.version != Version)
+            return false;
+
+        out.bytesPerTick = bytesPerTick(out.header.numStreams, (out.header.flags & FlagRSSI) != 0);
+        // only complete ticks
+        const size_t numTicks = (numBytes - sizeof(Header)) / out.bytesPerTick;
+        out.data.resize(numTicks * out.bytesPerTick);
+        return bool(in.read(reinterpret_cast<char*>(out.data.data()), out.data.size()));
+    }
+
+} // end of namespace BitCapture
@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Presets.hpp"
+#include "SampleStream.hpp"
+#include "InputMemoryReader.hpp"
+#include "MessageHandler.hpp"
+
+// Picks the number of input samples processed at once (see SampleStream::setBlockSize)
+// by timing the pipeline of a preset on a few block sizes. The candidates are the
+// blocks whose working set fits into the L1 or L2 cache, and the largest block.
+// The pipeline runs on generated noise, so the demodulator mostly rejects, which
+// is also what it does most of the time on real signals.
+namespace BlockTuner {
+
+    struct CacheSizes {
+        size_t l1 = 32 * 1024;
+        size_t l2 = 1024 * 1024;
+    };
+
+    namespace detail {
+        // e.g. "48K" from /sys/devices/system/cpu/cpu0/cache/indexN/size
+        inline size_t readSysCacheSize(int level, bool data) {
+            for (int index = 0; index < 8; index++) {
+                const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+                int l = 0;
+                std::string type;
+                std::string size;
+                if (!(std::ifstream(dir + "level") >> l) || !(std::ifstream(dir + "type") >> type)
+                    || !(std::ifstream(dir + "size") >> size))
+                    continue;
+                if (l != level || (data && type == "Instruction"))
+                    continue;
+                size_t bytes = std::strtoull(size.c_str(), nullptr, 10);
+                if (size.ends_with('K')) bytes *= 1024;
+                if (size.ends_with('M')) bytes *= 1024 * 1024;
+                return bytes;
+            }
+            return 0;
+        }
+
+        inline size_t cacheSize(int name, int level, bool data) {
+            const long res = sysconf(name);
+            if (res > 0)
+                return size_t(res);
+            return readSysCacheSize(level, data);
+        }
+    }
+
+    // sizes of the L1 data and the L2 cache of this CPU, the defaults if unknown
+    inline CacheSizes cacheSizes() {
+        CacheSizes res;
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+        const size_t l1 = detail::cacheSize(_SC_LEVEL1_DCACHE_SIZE, 1, true);
+        const size_t l2 = detail::cacheSize(_SC_LEVEL2_CACHE_SIZE, 2, false);
+#else
+        const size_t l1 = detail::readSysCacheSize(1, true);
+        const size_t l2 = detail::readSysCacheSize(2, false);
+#endif
+        if (l1 > 0) res.l1 = l1;
+        if (l2 > 0) res.l2 = l2;
+        return res;
+    }
+
+    struct Result {
+        size_t blockSize = 0;
+        double nsPerSample = 0.0;
+    };
+
+    template<typename preset>
+    class Tuner {
+    public:
+        using RawFormatType = typename preset::RawFormatType;
+        using RawType       = typename preset::RawType;
+        using SamplerType   = typename preset::SamplerType;
+
+        static constexpr size_t Granularity = SamplerType::InputBlockGranularity;
+        static constexpr size_t MaxBlockSize = SamplerType::InputBufferSize;
+        // raw values per input sample of the sampler
+        static constexpr size_t ValuesPerSample = 2 * preset::decimation;
+        // a block touches the raw IQ pairs and the magnitudes they are converted to
+        static constexpr size_t BytesPerSample = ValuesPerSample * sizeof(RawType) + sizeof(float);
+        // amount of signal each candidate is timed on
+        static constexpr double SecondsPerRun = 0.1;
+
+        explicit Tuner(const std::vector<float>& taps) : m_taps(taps) {
+            const size_t numSamples = size_t(SecondsPerRun * double(SamplerType::InputSampleRate));
+            m_recording.resize(ValuesPerSample * numSamples);
+            // a fixed LCG, the noise is the same for every candidate and run
+            uint32_t state = 1090;
+            for (auto& v : m_recording) {
+                state = state * 1664525u + 1013904223u;
+                if constexpr (std::is_floating_point_v<RawType>) {
+                    v = RawType(float(state >> 8) / float(1u << 24) - 0.5f);
+                } else {
+                    v = RawType(state >> (32 - 8 * sizeof(RawType)));
+                }
+            }
+        }
+
+        // multiples of Granularity whose working set fits half of and the whole L1 and L2
+        static std::vector<size_t> candidates(const CacheSizes& caches) {
+            std::vector<size_t> res;
+            for (size_t bytes : { caches.l1 / 2, caches.l1, caches.l2 / 2, caches.l2 }) {
+                const size_t blockSize = bytes / BytesPerSample / Granularity * Granularity;
+                res.push_back(std::clamp(blockSize, Granularity, MaxBlockSize));
+            }
+            res.push_back(MaxBlockSize);
+            std::sort(res.begin(), res.end());
+            res.erase(std::unique(res.begin(), res.end()), res.end());
+            return res;
+        }
+
+        // time per input sample when processing blockSize samples at once
+        double measure(size_t blockSize) const {
+            auto iqPipeline = IQPipelineSelector<SamplerType::InputSampleRate, SamplerType::OutputSampleRate,
+                                                 preset::pipelineOption, preset::decimation>::make(m_taps);
+            InputMemoryReader<
+                RawFormatType,
+                SamplerType::InputBufferSize,
+                decltype(iqPipeline)
+            > inputReader(iqPipeline, m_recording.data(), m_recording.size());
+
+            CountingMessageHandler messageHandler;
+            // the sample stream has large buffers, keep it off the stack
+            auto sampleStream = std::make_unique<SampleStream<SamplerType>>();
+            sampleStream->setBlockSize(blockSize);
+
+            const auto start = std::chrono::steady_clock::now();
+            sampleStream->read(inputReader, messageHandler);
+            const auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(end - start).count() / double(m_recording.size() / ValuesPerSample);
+        }
+
+        // times all candidates, the fastest one comes first
+        std::vector<Result> run(const CacheSizes& caches) const {
+            std::vector<Result> res;
+            const auto blockSizes = candidates(caches);
+            // warm up the caches and the clock
+            measure(blockSizes.back());
+            for (size_t blockSize : blockSizes) {
+                // the better of two runs, the first may still be disturbed by page faults
+                const double ns = std::min(measure(blockSize), measure(blockSize));
+                res.push_back(Result{ blockSize, ns });
+            }
+            std::stable_sort(res.begin(), res.end(), [](const Result& a, const Result& b) {
+                return a.nsPerSample < b.nsPerSample;
+            });
+            return res;
+        }
+
+    private:
+        std::vector<float> m_taps;
+        std::vector<RawType> m_recording;
+    };
+
+} // end of namespace BlockTuner
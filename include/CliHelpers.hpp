@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Sampler.hpp"
+
+// Helpers for parsing command line values. Shared by stream1090 and the tools.
+
+// maximum number of taps that may be loaded from a taps file, long filters run with an FFT
+inline constexpr size_t MaxNumTapsFromFile = 1024;
+
+inline SampleRate parse_sample_rate(const std::string& raw) {
+    // Strip optional trailing 'M' or 'm'
+    std::string s = raw;
+    if (!s.empty() && (s.back() == 'M' || s.back() == 'm'))
+        s.pop_back();
+
+    // Parse as float MHz
+    float mhz = 0.0f;
+    try {
+        mhz = std::stof(s);
+    } catch (...) {
+        std::cerr << "Invalid sample rate: " << raw << "\n";
+        std::exit(1);
+    }
+
+    // Convert MHz → Hz
+    int hz = static_cast<int>(mhz * 1'000'000.0f + 0.5f);
+
+    // Match directly against enum values
+    switch (hz) {
+        case Rate_1_0_Mhz:  return Rate_1_0_Mhz;
+        case Rate_2_0_Mhz:  return Rate_2_0_Mhz;
+        case Rate_2_4_Mhz:  return Rate_2_4_Mhz;
+        case Rate_2_56_Mhz:  return Rate_2_56_Mhz;
+        case Rate_3_0_Mhz:  return Rate_3_0_Mhz;
+        case Rate_3_2_Mhz:  return Rate_3_2_Mhz;
+        case Rate_4_0_Mhz:  return Rate_4_0_Mhz;
+        case Rate_6_0_Mhz:  return Rate_6_0_Mhz;
+        case Rate_8_0_Mhz:  return Rate_8_0_Mhz;
+        case Rate_10_0_Mhz: return Rate_10_0_Mhz;
+        case Rate_12_0_Mhz: return Rate_12_0_Mhz;
+        case Rate_16_0_Mhz: return Rate_16_0_Mhz;
+        case Rate_20_0_Mhz: return Rate_20_0_Mhz;
+        case Rate_24_0_Mhz: return Rate_24_0_Mhz;
+        case Rate_40_0_Mhz: return Rate_40_0_Mhz;
+        case Rate_48_0_Mhz: return Rate_48_0_Mhz;
+    }
+
+    std::cerr << "Unsupported sample rate: " << raw << "\n";
+    std::exit(1);
+}
+
+inline std::vector<float> load_taps_from_file(const std::string& filename) {
+    std::vector<float> taps;
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return taps;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        // trim whitespace
+        if (line.empty()) continue;
+
+        // skip comments
+        if (line[0] == '#') continue;
+
+        // parse float
+        try {
+            //float v = std::stof(line);
+            double v = std::stod(line);
+            taps.push_back((float)v);
+        } catch (...) {
+            // malformed line
+            return std::vector<float>();
+        }
+
+        // too many taps
+        if (taps.size() > MaxNumTapsFromFile) {
+            return std::vector<float>();
+        }
+    }
+
+    return taps;
+}
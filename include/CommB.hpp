@@ -0,0 +1,311 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+// Inference of the BDS register of a Comm-B reply (DF20/21). The MB field does
+// not say which register it contains, the ground station asked for it. Hence,
+// every register is tried: first the fixed bits, status bits and value ranges,
+// then the decoded values are checked against what we know about the aircraft.
+// Only if exactly one register is left, the reply is classified.
+//
+// Every check is a fixed number of bit operations, so the time per reply is bounded.
+namespace CommB {
+
+    enum class BDS : uint8_t {
+        Unknown = 0,
+        BDS10,
+        BDS17,
+        BDS20,
+        BDS30,
+        BDS40,
+        BDS50,
+        BDS60,
+        Ambiguous,
+        NumTypes
+    };
+
+    inline const char* toString(BDS bds) {
+        switch (bds) {
+            case BDS::BDS10: return "10";
+            case BDS::BDS17: return "17";
+            case BDS::BDS20: return "20";
+            case BDS::BDS30: return "30";
+            case BDS::BDS40: return "40";
+            case BDS::BDS50: return "50";
+            case BDS::BDS60: return "60";
+            case BDS::Ambiguous: return "ambiguous";
+            default: return "unknown";
+        }
+    }
+
+    // what is known about the aircraft from other frames
+    struct Reference {
+        char callsign[9];
+        float groundSpeed;
+        float track;
+        int32_t verticalRate;
+        bool hasCallsign;
+        bool hasVelocity;
+    };
+
+    // the decoded content of the registers
+    struct Decoded {
+        char callsign[9];
+        int32_t selectedAltitude;
+        float roll;
+        float trueTrack;
+        float groundSpeed;
+        float trueAirspeed;
+        float magHeading;
+        float indicatedAirspeed;
+        float mach;
+        int32_t baroRate;
+        bool hasSelectedAltitude;
+        bool hasRoll;
+        bool hasTrueTrack;
+        bool hasGroundSpeed;
+        bool hasTrueAirspeed;
+        bool hasMagHeading;
+        bool hasIndicatedAirspeed;
+        bool hasMach;
+        bool hasBaroRate;
+    };
+
+    // bits first to last of the MB field, numbered 1 to 56 as in the standard
+    constexpr inline uint32_t bits(uint64_t mb, int first, int last) {
+        return uint32_t((mb >> (56 - last)) & ((uint64_t(1) << (last - first + 1)) - 1));
+    }
+
+    // A field that is not available must be all zero
+    constexpr inline bool validStatus(uint64_t mb, int statusBit, int first, int last) {
+        return bits(mb, statusBit, statusBit) || (bits(mb, first, last) == 0);
+    }
+
+    // two's complement with a separate sign bit
+    constexpr inline int32_t signedValue(uint64_t mb, int signBit, int first, int last) {
+        const int32_t v = int32_t(bits(mb, first, last));
+        return bits(mb, signBit, signBit) ? v - (int32_t(1) << (last - first + 1)) : v;
+    }
+
+    inline float angleDiff(float a, float b) {
+        const float d = std::fabs(std::fmod(a - b + 540.0f, 360.0f) - 180.0f);
+        return d;
+    }
+
+    // data link capability report
+    inline bool isBDS10(uint64_t mb) {
+        return (bits(mb, 1, 8) == 0x10) && (bits(mb, 10, 14) == 0);
+    }
+
+    // common usage GICB capability report. Who supports anything, supports 2,0.
+    inline bool isBDS17(uint64_t mb) {
+        return (bits(mb, 25, 56) == 0) && bits(mb, 7, 7);
+    }
+
+    // aircraft identification
+    inline bool isBDS20(uint64_t mb, const Reference& ref, Decoded& out) {
+        if (bits(mb, 1, 8) != 0x20)
+            return false;
+
+        static constexpr char Charset[] =
+            "#ABCDEFGHIJKLMNOPQRSTUVWXYZ##### ###############0123456789######";
+        for (int i = 0; i < 8; i++) {
+            const char c = Charset[bits(mb, 9 + 6 * i, 14 + 6 * i)];
+            if (c == '#')
+                return false;
+            out.callsign[i] = c;
+        }
+        int len = 8;
+        while (len > 0 && out.callsign[len - 1] == ' ')
+            len--;
+        out.callsign[len] = '\0';
+
+        if (len == 0)
+            return false;
+
+        // if we know the callsign, it has to be the same
+        if (ref.hasCallsign) {
+            for (int i = 0; i <= len; i++) {
+                if (ref.callsign[i] != out.callsign[i])
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // ACAS active resolution advisory
+    inline bool isBDS30(uint64_t mb) {
+        return (bits(mb, 1, 8) == 0x30)
+            && (bits(mb, 29, 30) != 3)
+            && (bits(mb, 16, 22) < 48);
+    }
+
+    // selected vertical intention
+    inline bool isBDS40(uint64_t mb, Decoded& out) {
+        if (mb == 0)
+            return false;
+
+        if (!validStatus(mb, 1, 2, 13) || !validStatus(mb, 14, 15, 26) || !validStatus(mb, 27, 28, 39)
+            || !validStatus(mb, 48, 49, 51) || !validStatus(mb, 54, 55, 56))
+            return false;
+
+        // reserved
+        if (bits(mb, 40, 47) != 0 || bits(mb, 52, 53) != 0)
+            return false;
+
+        const int32_t mcp = int32_t(bits(mb, 2, 13)) * 16;
+        const int32_t fms = int32_t(bits(mb, 15, 26)) * 16;
+        if (mcp > 45000 || fms > 45000)
+            return false;
+
+        // the baro setting is 800 mb plus 0.1 mb steps, 12 bits
+        if (bits(mb, 27, 27)) {
+            const float baro = 800.0f + float(bits(mb, 28, 39)) * 0.1f;
+            if (baro < 900.0f || baro > 1100.0f)
+                return false;
+        }
+
+        out.hasSelectedAltitude = bits(mb, 1, 1) || bits(mb, 14, 14);
+        out.selectedAltitude = bits(mb, 1, 1) ? mcp : fms;
+
+        // the selected altitude is set in steps of 100 ft, reported in steps of 16 ft
+        if (out.hasSelectedAltitude && (out.selectedAltitude + 16) % 100 > 32)
+            return false;
+
+        return out.hasSelectedAltitude;
+    }
+
+    // track and turn report
+    inline bool isBDS50(uint64_t mb, const Reference& ref, Decoded& out) {
+        if (mb == 0)
+            return false;
+
+        if (!validStatus(mb, 1, 3, 11) || !validStatus(mb, 12, 14, 23) || !validStatus(mb, 24, 25, 34)
+            || !validStatus(mb, 35, 37, 45) || !validStatus(mb, 46, 47, 56))
+            return false;
+
+        out.hasRoll = bits(mb, 1, 1);
+        out.roll = float(signedValue(mb, 2, 3, 11)) * 45.0f / 256.0f;
+        if (out.hasRoll && std::fabs(out.roll) > 50.0f)
+            return false;
+
+        out.hasTrueTrack = bits(mb, 12, 12);
+        out.trueTrack = float(signedValue(mb, 13, 14, 23)) * 90.0f / 512.0f;
+        if (out.trueTrack < 0.0f)
+            out.trueTrack += 360.0f;
+
+        out.hasGroundSpeed = bits(mb, 24, 24);
+        out.groundSpeed = float(bits(mb, 25, 34)) * 2.0f;
+        if (out.hasGroundSpeed && out.groundSpeed > 600.0f)
+            return false;
+
+        out.hasTrueAirspeed = bits(mb, 46, 46);
+        out.trueAirspeed = float(bits(mb, 47, 56)) * 2.0f;
+        if (out.hasTrueAirspeed && out.trueAirspeed > 500.0f)
+            return false;
+
+        if (out.hasGroundSpeed && out.hasTrueAirspeed && std::fabs(out.groundSpeed - out.trueAirspeed) > 200.0f)
+            return false;
+
+        // compare with the ADS-B velocity
+        if (ref.hasVelocity) {
+            if (out.hasGroundSpeed && std::fabs(out.groundSpeed - ref.groundSpeed) > 50.0f)
+                return false;
+            if (out.hasTrueTrack && angleDiff(out.trueTrack, ref.track) > 20.0f)
+                return false;
+        }
+
+        // a sparse 4,0 or 6,0 also passes the checks above. Transponders always
+        // report the speeds in 5,0.
+        return out.hasGroundSpeed && out.hasTrueAirspeed;
+    }
+
+    // heading and speed report
+    inline bool isBDS60(uint64_t mb, const Reference& ref, Decoded& out) {
+        if (mb == 0)
+            return false;
+
+        if (!validStatus(mb, 1, 2, 12) || !validStatus(mb, 13, 14, 23) || !validStatus(mb, 24, 25, 34)
+            || !validStatus(mb, 35, 36, 45) || !validStatus(mb, 46, 47, 56))
+            return false;
+
+        out.hasMagHeading = bits(mb, 1, 1);
+        out.magHeading = float(signedValue(mb, 2, 3, 12)) * 90.0f / 512.0f;
+        if (out.magHeading < 0.0f)
+            out.magHeading += 360.0f;
+
+        out.hasIndicatedAirspeed = bits(mb, 13, 13);
+        out.indicatedAirspeed = float(bits(mb, 14, 23));
+        if (out.hasIndicatedAirspeed && out.indicatedAirspeed > 500.0f)
+            return false;
+
+        out.hasMach = bits(mb, 24, 24);
+        out.mach = float(bits(mb, 25, 34)) * 2.048f / 512.0f;
+        if (out.hasMach && out.mach > 1.0f)
+            return false;
+
+        out.hasBaroRate = bits(mb, 35, 35);
+        out.baroRate = signedValue(mb, 36, 37, 45) * 32;
+        if (out.hasBaroRate && std::abs(out.baroRate) > 6000)
+            return false;
+
+        // compare with the ADS-B velocity. Magnetic heading and true track
+        // differ by the declination and the wind.
+        if (ref.hasVelocity) {
+            if (out.hasMagHeading && angleDiff(out.magHeading, ref.track) > 45.0f)
+                return false;
+            if (out.hasBaroRate && std::abs(out.baroRate - ref.verticalRate) > 1500)
+                return false;
+        }
+
+        // same as for 5,0, a heading and a speed are always reported
+        return out.hasMagHeading && (out.hasIndicatedAirspeed || out.hasMach);
+    }
+
+    // Tries all registers. Returns the only one that fits, BDS::Ambiguous if more
+    // than one fits and BDS::Unknown if none. out is only valid for the result.
+    inline BDS infer(uint64_t mb, const Reference& ref, Decoded& out) {
+        out = Decoded{};
+        BDS result = BDS::Unknown;
+        int numMatches = 0;
+
+        auto match = [&](BDS bds) {
+            result = bds;
+            numMatches++;
+        };
+
+        // the registers with a fixed first byte are tried first and checked strictly.
+        // If one of them fits, the reply is not tried as 4,0, 5,0 or 6,0.
+        if (isBDS10(mb)) match(BDS::BDS10);
+        if (isBDS20(mb, ref, out)) match(BDS::BDS20);
+        if (isBDS30(mb)) match(BDS::BDS30);
+        if (numMatches == 1)
+            return result;
+
+        if (isBDS17(mb)) match(BDS::BDS17);
+
+        // each decoder writes its own fields only
+        Decoded d40{}, d50{}, d60{};
+        if (isBDS40(mb, d40)) match(BDS::BDS40);
+        if (isBDS50(mb, ref, d50)) match(BDS::BDS50);
+        if (isBDS60(mb, ref, d60)) match(BDS::BDS60);
+
+        if (numMatches != 1)
+            return numMatches ? BDS::Ambiguous : BDS::Unknown;
+
+        if (result == BDS::BDS40) out = d40;
+        if (result == BDS::BDS50) out = d50;
+        if (result == BDS::BDS60) out = d60;
+        return result;
+    }
+
+} // end of namespace CommB
@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A Unix domain socket for changing a running instance, e.g. a single gain,
+// without rewriting the INI file and sending SIGHUP. The protocol is line based:
+// a client connects, sends one command per line and gets one line back for
+// each, starting with "OK" or "ERR":
+//
+//   set gain 40.2          -> OK gain=40.2
+//   stats                  -> OK samples=... frames=... df17=...
+//   output udp off         -> OK udp=off
+//
+// The commands run on the thread of the server, never on the DSP thread.
+// See MainInstance::setupControl for the commands.
+namespace Control {
+
+    // the reply to a command
+    inline std::string ok(const std::string& str = "") {
+        return str.empty() ? "OK" : "OK " + str;
+    }
+
+    inline std::string error(const std::string& str) {
+        return "ERR " + str;
+    }
+
+    class Server {
+    public:
+        // gets the arguments after the command and returns the reply, see ok() and error()
+        using Handler = std::function<std::string(const std::vector<std::string>& args)>;
+
+        ~Server() {
+            close();
+        }
+
+        // registers a command. Only before open()
+        void on(const std::string& command, const std::string& usage, Handler handler) {
+            m_commands[command] = Command{ usage, std::move(handler) };
+        }
+
+        // creates the socket, replacing a stale one of the same path, and starts the thread
+        bool open(const std::string& path) {
+            sockaddr_un addr{};
+            if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+                m_error = "path is empty or too long";
+                return false;
+            }
+
+            m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (m_fd < 0) {
+                m_error = std::strerror(errno);
+                return false;
+            }
+
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, path.c_str(), path.size());
+            ::unlink(path.c_str());
+            if (::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(m_fd, 4) != 0) {
+                m_error = std::strerror(errno);
+                ::close(m_fd);
+                m_fd = -1;
+                return false;
+            }
+
+            m_path = path;
+            m_stop.store(false);
+            m_thread = std::thread([this] { run(); });
+            return true;
+        }
+
+        void close() {
+            if (m_fd < 0)
+                return;
+            m_stop.store(true);
+            if (m_thread.joinable())
+                m_thread.join();
+            ::close(m_fd);
+            m_fd = -1;
+            ::unlink(m_path.c_str());
+        }
+
+        bool isOpen() const noexcept {
+            return m_fd >= 0;
+        }
+
+        const std::string& lastError() const noexcept {
+            return m_error;
+        }
+
+        // runs a single command line, also used by the thread
+        std::string execute(const std::string& line) {
+            std::istringstream in(line);
+            std::vector<std::string> args;
+            for (std::string arg; in >> arg; )
+                args.push_back(arg);
+            if (args.empty())
+                return error("empty command");
+
+            const std::string command = args.front();
+            args.erase(args.begin());
+
+            if (command == "help") {
+                std::string res;
+                for (const auto& [name, cmd] : m_commands)
+                    res += (res.empty() ? "" : " | ") + cmd.usage;
+                return ok(res);
+            }
+
+            const auto it = m_commands.find(command);
+            if (it == m_commands.end())
+                return error("unknown command " + command + ", try help");
+
+            // e.g. std::stof of a value that is not a number
+            try {
+                return it->second.handler(args);
+            } catch (const std::exception& e) {
+                return error(std::string("invalid argument (") + e.what() + ")");
+            }
+        }
+
+    private:
+        struct Command {
+            std::string usage;
+            Handler handler;
+        };
+
+        struct Client {
+            int fd;
+            std::string pending;
+        };
+
+        // clients beyond this are turned away
+        static constexpr size_t MaxClients = 8;
+        // longest accepted command line
+        static constexpr size_t MaxLineLength = 64 * 1024;
+
+        void run() {
+            std::vector<Client> clients;
+            std::vector<pollfd> fds;
+            while (!m_stop.load()) {
+                fds.assign(1, pollfd{ m_fd, POLLIN, 0 });
+                for (const auto& c : clients)
+                    fds.push_back(pollfd{ c.fd, POLLIN, 0 });
+
+                // wake up now and then to see if we are done
+                if (::poll(fds.data(), fds.size(), 200) <= 0)
+                    continue;
+
+                if (fds[0].revents & POLLIN) {
+                    const int fd = ::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+                    if (fd >= 0 && clients.size() < MaxClients) {
+                        clients.push_back(Client{ fd, "" });
+                    } else if (fd >= 0) {
+                        send(fd, error("too many clients") + "\n");
+                        ::close(fd);
+                    }
+                }
+
+                // the new client is not in fds yet
+                for (size_t i = fds.size() - 1; i > 0; i--) {
+                    if (!fds[i].revents)
+                        continue;
+                    if (!serve(clients[i - 1])) {
+                        ::close(clients[i - 1].fd);
+                        clients.erase(clients.begin() + ptrdiff_t(i - 1));
+                    }
+                }
+            }
+
+            for (const auto& c : clients)
+                ::close(c.fd);
+        }
+
+        // reads what the client sent and answers the complete lines, false if it is gone
+        bool serve(Client& client) {
+            char buffer[4096];
+            const ssize_t n = ::recv(client.fd, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                return false;
+
+            client.pending.append(buffer, size_t(n));
+            size_t pos;
+            while ((pos = client.pending.find('\n')) != std::string::npos) {
+                std::string line = client.pending.substr(0, pos);
+                client.pending.erase(0, pos + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (!send(client.fd, execute(line) + "\n"))
+                    return false;
+            }
+            return client.pending.size() <= MaxLineLength;
+        }
+
+        static bool send(int fd, const std::string& str) {
+            size_t done = 0;
+            while (done < str.size()) {
+                const ssize_t n = ::send(fd, str.data() + done, str.size() - done, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                done += size_t(n);
+            }
+            return true;
+        }
+
+        int m_fd = -1;
+        std::string m_path;
+        std::string m_error;
+        std::map<std::string, Command> m_commands;
+        std::thread m_thread;
+        std::atomic<bool> m_stop{false};
+    };
+
+} // end of namespace Control
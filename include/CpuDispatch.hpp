@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <string>
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
+// Selects the instruction set for the hot loops once at startup. The build
+// itself targets the baseline of the architecture, so the binary runs on any
+// CPU of it. The hot loops (conversion and IQ pipeline, slicer, shift
+// registers) are compiled a second and third time for AVX2 and AVX-512 on
+// x86-64. Every variant is a function with a target attribute into which the
+// loop body is force-inlined. All the callees inlined into it are compiled for
+// the same instruction set.
+//
+// On AArch64 NEON is part of the baseline, hence there is one variant only.
+//
+// Build with -DENABLE_ISA_DISPATCH=OFF for a single baseline variant, e.g.
+// when building with -march=native anyway.
+namespace CpuDispatch {
+
+    enum class Isa {
+        Baseline,
+        AVX2,
+        AVX512
+    };
+
+#if defined(STREAM1090_ISA_DISPATCH) && STREAM1090_ISA_DISPATCH && defined(__x86_64__) && defined(__GNUC__)
+    static constexpr bool Enabled = true;
+    #define STREAM1090_TARGET_AVX2   __attribute__((target("avx2,fma,bmi,bmi2,popcnt")))
+    #define STREAM1090_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,bmi,bmi2,popcnt")))
+#else
+    static constexpr bool Enabled = false;
+    #define STREAM1090_TARGET_AVX2
+    #define STREAM1090_TARGET_AVX512
+#endif
+
+// for the loop bodies that are compiled into every variant
+#if defined(__GNUC__)
+    #define STREAM1090_FORCE_INLINE __attribute__((always_inline)) inline
+#else
+    #define STREAM1090_FORCE_INLINE inline
+#endif
+
+    inline const char* name(Isa isa) noexcept {
+        switch (isa) {
+            case Isa::AVX2:   return "avx2";
+            case Isa::AVX512: return "avx512";
+            default:
+#if defined(__aarch64__)
+                return "neon";
+#elif defined(__x86_64__)
+                return "sse2";
+#else
+                return "baseline";
+#endif
+        }
+    }
+
+    // "avx2", "avx512" or "baseline"
+    inline bool parse(const std::string& str, Isa& isa) noexcept {
+        if (str == "baseline") { isa = Isa::Baseline; return true; }
+        if (str == "avx2")     { isa = Isa::AVX2;     return true; }
+        if (str == "avx512")   { isa = Isa::AVX512;   return true; }
+        return false;
+    }
+
+    // the best variant the CPU supports
+    inline Isa detect() noexcept {
+#if defined(__x86_64__) && defined(__GNUC__)
+        if constexpr (Enabled) {
+            __builtin_cpu_init();
+            const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+                              && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2")
+                              && __builtin_cpu_supports("popcnt");
+            if (avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+                && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+                return Isa::AVX512;
+            if (avx2)
+                return Isa::AVX2;
+        }
+#endif
+        return Isa::Baseline;
+    }
+
+    // what the CPU offers in addition to the variants, for the log
+    inline std::string cpuFeatures() {
+        std::string features;
+#if defined(__x86_64__) && defined(__GNUC__)
+        __builtin_cpu_init();
+        const auto add = [&](bool supported, const char* feature) {
+            if (supported)
+                features += std::string(features.empty() ? "" : " ") + feature;
+        };
+        add(__builtin_cpu_supports("sse4.2"), "sse4.2");
+        add(__builtin_cpu_supports("avx"), "avx");
+        add(__builtin_cpu_supports("avx2"), "avx2");
+        add(__builtin_cpu_supports("fma"), "fma");
+        add(__builtin_cpu_supports("avx512f"), "avx512f");
+        add(__builtin_cpu_supports("avx512bw"), "avx512bw");
+#elif defined(__aarch64__)
+        const unsigned long hwcap = getauxval(AT_HWCAP);
+        if (hwcap & HWCAP_ASIMD)
+            features += "asimd";
+    #ifdef HWCAP_SVE
+        if (hwcap & HWCAP_SVE)
+            features += " sve";
+    #endif
+#endif
+        return features;
+    }
+
+    namespace detail {
+        inline Isa& selected() noexcept {
+            static Isa isa = detect();
+            return isa;
+        }
+    }
+
+    // the variant in use
+    inline Isa selected() noexcept {
+        return detail::selected();
+    }
+
+    // Caps the variant, e.g. to compare them. A variant the CPU lacks is never selected.
+    inline void limit(Isa isa) noexcept {
+        if (int(isa) < int(detect()))
+            detail::selected() = isa;
+        else
+            detail::selected() = detect();
+    }
+
+} // end of namespace CpuDispatch
@@ -1,401 +1,619 @@
-/* SPDX-License-Identifier: GPL-3.0-or-later
- * Copyright 2025 Martin Gronemann
- *
- * This file is part of stream1090 and is licensed under the GNU General
- * Public License v3.0. See the top-level LICENSE file for details.
- */
-
-#pragma once
-
-#include "Bits128.hpp"
-#include "CRC.hpp"
-#include "CRCErrorTable.hpp"
-#include "ModeS.hpp"
-#include "ICAOCache.hpp"
-#include "Stats.hpp"
-#include <cmath>
-#include "ShiftRegisters.hpp"
-#include "MessageHandler.hpp"
-
-template<int NumStreams, MessageHandler Handler>
-class DemodCore {
-public:
-	// default constructor
-	explicit DemodCore(Handler& messageHandler) : m_messageHandler(messageHandler) {
-		// nothing
-	}
-
-	~DemodCore() {
-		#if defined(STATS_ENABLED) && STATS_ENABLED
-		#if defined(STATS_END_ONLY) && STATS_END_ONLY
-			Stats::printStatsOnExit(m_statsLog, std::cerr);
-		#endif
-		#endif
-	}
-
-	// This is the main entry function called by the SampleStream. 
-	// NumStreams many new bits are shifted in. The crc's are updated
-	// and the streams are being checked for new messages
-	void shiftInNewBits(uint32_t* cmp) {
-		m_shiftRegisters.shiftInNewBits(cmp); 
-		// the streams and crc's are ready
-		m_cache.tick();
-		for (auto i = 0; i < NumStreams; i++) {
-			handleStream(i);			
-			m_currTime++;
-		}
-		logStats(Stats::NUM_ITERATIONS);
-	}
-
-	bool sendFrameLongAligned(int,
-							  const uint8_t downlinkFormat, 
-							  CRC::crc_t, 
-							  const Bits128& frame, 
-							  const ICAOTable::Iterator& it) {
-		auto& e = m_cache.getMsgStatEntry(it);
-		static constexpr uint64_t DUP_WINDOW_TICKS = 30 * NumStreams;
-		if ((m_currTime - e.last_time) < DUP_WINDOW_TICKS) {
-		    e.last_time = m_currTime;
-    		logStatsDup(downlinkFormat);
-    		return false;
-		}
-
-		if ((downlinkFormat == 20) || (downlinkFormat == 16)) {
-			const auto alt_bits = ModeS::extractSquawkAlt_Long(frame);
-			const auto alt = ModeS::decodeAltitude(alt_bits);
-			if (!m_cache.checkAltitude(it, alt)) {	
-				return false;
-			} else {
-				m_cache.markAsSeen(it);
-			}
-		}
-		
-		if (downlinkFormat == 21) {
-			const auto sqwk = ModeS::extractSquawkAlt_Long(frame);
-			if (!m_cache.checkSquawk(it, sqwk))
-				return false;
-			m_cache.markAsSeen(it);
-		}
-		
-		logStatsSent(downlinkFormat);
-		e.last_time = m_currTime;		
-		m_messageHandler.handleLong(m_currTime, frame);
-		return true;
-	}
-
-	bool sendFrameShortAligned(int, const uint8_t downlinkFormat, CRC::crc_t, const uint64_t& frameShort, const ICAOTable::Iterator& it) {
-		auto& e = m_cache.getMsgStatEntry(it);
-		static constexpr uint64_t DUP_WINDOW_TICKS = 30 * NumStreams;
-		if ((m_currTime - e.last_time) < DUP_WINDOW_TICKS) {
-		    e.last_time = m_currTime;
-    		logStatsDup(downlinkFormat);
-    		return false;
-		}
-
-		if ((downlinkFormat == 4) || (downlinkFormat == 0)) {
-			const auto alt_bits = ModeS::extractSquawkAlt_Short(frameShort);
-			const auto alt = ModeS::decodeAltitude(alt_bits);
-			if (!m_cache.checkAltitude(it, alt)) {
-				return false;
-			} else {
-				m_cache.markAsSeen(it);
-			}
-		}
-
-		if (downlinkFormat == 5) {
-			const auto sqwk = ModeS::extractSquawkAlt_Short(frameShort);
-			if (!m_cache.checkSquawk(it, sqwk))
-				return false;
-			m_cache.markAsSeen(it);
-		}
-
-		logStatsSent(downlinkFormat);
-		e.last_time = m_currTime;
-		m_messageHandler.handleShort(m_currTime, frameShort);
-		return true;
-	}
-
-	bool phaseDupCheckShort(const uint64_t& frameShort) noexcept {
-		if (frameShort == m_prevShortFrame)
-			return true;
-		
-		m_prevShortFrame = frameShort;
-		return false;
-	}
-
-	bool phaseDupCheckLong(const Bits128& frameLong) noexcept {
-		if (frameLong == m_prevLongFrame)
-			return true;
-		
-		m_prevLongFrame = frameLong;
-		return false;
-	}
-
-	// Dispatcher function for handling messages based on the downlink format  
-	bool handleStream(int streamIndex) {
-		const auto downlinkFormat = m_shiftRegisters.getDF(streamIndex);
-		
-		switch (downlinkFormat)
-		{
-		case 0: // acas
-		case 4: // surveillance altitude
-		case 5: // surveillance identity
-			return handleAcasSurvShortMessage(streamIndex, downlinkFormat);
-		case 11: // DF 11 messages
-			return handleDF11ShortMessage(streamIndex);
-
-		// Extended squitter messages
-		case 17:
-		case 18:
-		case 19:
-			return handleExtSquitterLongMessage(streamIndex, downlinkFormat);
-		//  ACAS, Comm-B Messages
-		case 16:
-		case 20:
-		case 21:
-			return handleAcasCommBLongMessage(streamIndex, downlinkFormat);
-		default:
-			break;
-		}
-
-		return false;
-	}
-
-	/// @brief Handler for the extended squitter messages
-	/// @return returns true if a message has been send to the output
-	bool handleExtSquitterLongMessage(int streamIndex, const uint8_t& downlinkFormat) {
-		auto frame = m_shiftRegisters.extractAlignedFrameLong(streamIndex);
-
-		if (phaseDupCheckLong(frame))
-			return false;
-
-		auto crc = m_shiftRegisters.getCRC_112(streamIndex);
-
-		// if the crc is zero, we have a correct message
-		if (crc == 0) {
-			// we consider a crc of 0 as a good message
-			logStats(Stats::DF17_GOOD_MESSAGE);
-			// get the address including the CA field
-			const auto icaoWithCA = ModeS::extractICAOWithCA_Long(frame);
-			const auto e = m_cache.findWithCA(icaoWithCA);
-			
-			// if we know this plane
-			if (e.isValid()) {
-				m_cache.markAsTrustedSeen(e);
-				// and send the 112 bit message to the output
-				return sendFrameLongAligned(streamIndex, downlinkFormat, crc, frame, e);
-			} else {
-				m_cache.markAsTrustedSeen(m_cache.insertWithCA(icaoWithCA));
-			} 
-		} else {
-			// the crc is not zero, so we might have a broken message
-			logStats(Stats::DF17_BAD_MESSAGE);
-			// Ask the error table for a possible fix
-			const auto fix_op = CRC::df17ErrorTable.lookup(crc);
-			// can we fix it?
-			if (fix_op.valid()) {
-				// make a copy of the broken message
-				Bits128 toRepair{ frame };
-				// and let the error table apply the fix
-				CRC::applyFixOp(fix_op, toRepair, 0);
-				// extract the address together with the CA bits
-				const auto icaoWithCA = ModeS::extractICAOWithCA_Long(toRepair);
-				// do we know this icao address? We are only asking there the list of trusted addresses
-				// using a not trusted address and repairing at the same time is too dangerous
-				const auto e = m_cache.findWithCA(icaoWithCA);
-
-				// if this plane is not known we are leaving this
-				if (!e.isValid())
-					return false;
-
-				if (m_cache.isTrusted(e)) {
-					// log that fixing the message was a success
-					logStats(Stats::DF17_REPAIR_SUCCESS);
-					// and keep the trusted entry alive
-					m_cache.markAsTrustedSeen(e);
-					// send the 112 bit message to the output
-					return sendFrameLongAligned(streamIndex, downlinkFormat, crc, toRepair, e);
-				};				
-			}
-			logStats(Stats::DF17_REPAIR_FAILED);
-		}
-		return false;
-	}
-
-	/// @brief Handler for long ACAS and Comm-B messages
-	/// @return returns true if a message has been send to the output
-	bool handleAcasCommBLongMessage(int streamIndex, const uint8_t& downlinkFormat) {
-		auto frame = m_shiftRegisters.extractAlignedFrameLong(streamIndex);
-
-		if (phaseDupCheckLong(frame))
-			return false;
-
-		auto crc = m_shiftRegisters.getCRC_112(streamIndex);
-		// a valid message has the icao overlaid, i.e., check if crc corresponds to 
-		// a known, active and trusted address
-		if (crc ==  0)
-			return false;
-		const auto e = m_cache.find(crc);
-		// if this is not in the list of known planes, we have to leave
-		if (!e.isValid()) {
-			return false;
-		}
-
-		if (m_cache.isAlive(e)) {
-			// log that this message is a good message
-			logStats(Stats::COMM_B_GOOD_MESSAGE);
-			// output the message
-			return sendFrameLongAligned(streamIndex, downlinkFormat, crc, frame, e);
-		}
-
-		return false;
-	}
-
-	/// @brief This function handles the downlink formats 0 (short acas reply), 4 (altitude reply), and 5 (identity reply)
-	/// @return returns true if a message has been send to the output
-	bool handleAcasSurvShortMessage(int streamIndex, const uint8_t& downlinkFormat) {
-		// get the short message frame
-		const auto frameShort = m_shiftRegisters.extractAlignedFrameShort(streamIndex);
-		// first check if we have seen this in the previous stream
-		if (phaseDupCheckShort(frameShort))
-			return false;
-
-		const auto crc = m_shiftRegisters.getCRC_56(streamIndex);
-
-		if (crc ==  0)
-			return false;
-		// for DF 0, 4, 5 we have address parity, i.e. the crc of a valid message corresponds to the address of the transponder
-		// check if we have a trustworthy address in our cache
-		const auto e = m_cache.find(crc);
-		// if this is not in the list of known planes, we have to leave
-		if (!e.isValid())
-			return false;
-
-		if (m_cache.isAlive(e)) {
-			// log that this message is a good message
-			logStats(Stats::ACAS_SURV_GOOD_MESSAGE);
-			// output the message
-			return sendFrameShortAligned(streamIndex, downlinkFormat, crc, frameShort, e);		
-		} 
-		return false;
-	}
-
-	/// @brief Helper function for all-call replies (DF11) with a crc of zero. Either received correctly or repaired with 1-bit error correction
-	/// @return returns true if a message has been send to the output
-	bool handleDF11ShortMessageWithZeroCRC(int streamIndex, const uint64_t& frameShort, bool repaired) {
-		const auto icaoWithCA = ModeS::extractICAOWithCA_Short(frameShort);
-		const auto e = m_cache.findWithCA(icaoWithCA);
-		
-		// if the plane is not in table,
-		if (!e.isValid()) {
-			// put it there.
-			if (!repaired) {
-				m_cache.insertWithCA(icaoWithCA);
-			}
-			// we stop here and do not send the message
-			return false;
-		}
-
-		if (m_cache.isAlive(e)) {
-			// log that this message is a good message
-			// we consider this a valid message
-			m_cache.markAsSeen(e);
-			// and output the message
-			return sendFrameShortAligned(streamIndex, 11, 0, frameShort, e);
-		} 
-		m_cache.markAsSeen(e);
-		return false;
-	}
-
-	/// @brief This function handles all-call replies (downlink format 11).
-	/// @return returns true if a message has been send to the output
-	bool handleDF11ShortMessage(int streamIndex) {
-		auto frameShort = m_shiftRegisters.extractAlignedFrameShort(streamIndex);
-
-		if (phaseDupCheckShort(frameShort))
-			return false;
-
-		const auto crc = m_shiftRegisters.getCRC_56(streamIndex);
-	
-		if (crc == 0) {
-			logStats(Stats::DF11_ICAO_CA_FOUND_GOOD_CRC);
-			return handleDF11ShortMessageWithZeroCRC(streamIndex, frameShort, false);
-		} else  {
-			// ask the 1 bit error correction table for short messages for help
-			const auto fix_op = CRC::df11ErrorTable.lookup(crc);
-			// can we fix it?
-			if (fix_op.valid()) {
-				// let the error table apply the fix
-				CRC::applyFixOp(fix_op, frameShort, 0);
-				logStats(Stats::DF11_ICAO_CA_FOUND_1_BIT_FIX);
-				// we are good now and proceed as with the normal zero crc case
-				return handleDF11ShortMessageWithZeroCRC(streamIndex, frameShort, true);
-			} else {
-				// the crc is not good and no repairs with the error table. We do now a dirty trick here.
-				// get the address including the CA field
-				const auto icaoWithCA = ModeS::extractICAOWithCA_Short(frameShort);
-				// look up the address in the trusted list
-				const auto e = m_cache.findWithCA(icaoWithCA);
-				// if it is there and we consider this as an active trusted transponder
-				if (e.isValid() && m_cache.isTrusted(e)) {
-					// Hence, we trust the address including the CA field. Downlink format is correct. 
-					// make sure to have this sender address in the list of known but not thrustworthy addresses
-					m_cache.markAsSeen(e);
-					// The only remaining data in this short message is the parity block. Fix it and output the message
-					return sendFrameShortAligned(streamIndex, 11, 0, frameShort ^ crc, e);
-				}
-			}
-		}
-		return false;
-	} 
-
-
-private:
-
-#if defined(STATS_ENABLED) && STATS_ENABLED
-	Stats::StatsLog m_statsLog;
-	void logStats(Stats::EventType evt) {
-		m_statsLog.log(evt);
-		#if !(defined(STATS_END_ONLY) && STATS_END_ONLY)
-			if (evt == Stats::NUM_ITERATIONS)
-				Stats::printTick(m_statsLog, std::cerr);
-		#endif
-	}
-
-	void logStatsSent(int df) {
-		m_statsLog.logSent(df);
-	}
-
-	void logStatsDup(int df) {
-		m_statsLog.logDup(df);
-	}
-#else
-	void logStats(Stats::EventType) {}
-	void logStatsSent(int) {}
-	void logStatsDup(int) {}
-#endif	
-	static constexpr uint64_t samplesPerSecond() {
-		return NumStreams * 1000000;
-	}
-
-	static constexpr uint64_t secondsToNumSamples(float secs) {
-		return (samplesPerSecond() * secs);
-	}
-	
-	// while dealing with a single stream, this holds a copy of the frame
-	// from the previous stream  
-	alignas(16) Bits128 m_prevLongFrame; 
-	alignas(16) uint64_t m_prevShortFrame; 
-
-	// plane lookup table
-	ICAOTable m_cache; 
-	
-	// the current time measured in samples.
-	uint64_t m_currTime{ 0 };
-	
-	// the shift registers for the bits
-	ShiftRegisters<NumStreams> m_shiftRegisters;
-
-	// the message handler that deals with long and short frames
-	Handler& m_messageHandler;
-};
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2025 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include "Bits128.hpp"
+#include "CRC.hpp"
+#include "CRCErrorTable.hpp"
+#include "ModeS.hpp"
+#include "ICAOCache.hpp"
+#include "Stats.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include "ShiftRegisters.hpp"
+#include "MessageHandler.hpp"
+#include "DemodPolicy.hpp"
+
+// the step between coarse phases with numStreams streams, 1 if there are too few for them
+constexpr int coarsePhaseStep(int numStreams) {
+	return (numStreams >= 16 && numStreams % 8 == 0) ? numStreams / 8 : 1;
+}
+
+// With PhaseStep > 1 the shift registers and crc's only run on every PhaseStep-th
+// stream (the coarse phases). The bits of all streams are kept for the last 128
+// ticks. When a coarse phase holds a frame, or one a repair would explain, the
+// phases around it are rebuilt from these bits and checked as well, see
+// shiftInCoarsePhases. Neighbouring phases see almost the same bits, so this
+// decodes nearly as much as running all streams, at the cost of the coarse ones.
+template<int NumStreams, MessageHandler Handler, typename Policy = DefaultDemodPolicy, int PhaseStep = 1>
+class DemodCore {
+public:
+	using Cache = ICAOTableT<Policy>;
+
+	static_assert(NumStreams % PhaseStep == 0, "the coarse phases are evenly spaced");
+	static constexpr int NumCoarse = NumStreams / PhaseStep;
+	static constexpr bool UsesCoarsePhases = PhaseStep > 1;
+	// the coarse streams and one more for the phase being refined
+	static constexpr int NumRegisters = UsesCoarsePhases ? NumCoarse + 1 : NumStreams;
+	// Coarse stream c is phase c * PhaseStep + CoarseOffset. The last phase of each
+	// group keeps the phases below it within the same tick, see shiftInCoarsePhases
+	static constexpr int CoarseOffset = PhaseStep - 1;
+
+	// default constructor
+	explicit DemodCore(Handler& messageHandler, const Policy& policy = Policy())
+		: m_policy(policy), m_cache(policy), m_messageHandler(messageHandler) {
+		// nothing
+	}
+
+	~DemodCore() {
+		#if defined(STATS_ENABLED) && STATS_ENABLED
+		#if defined(STATS_END_ONLY) && STATS_END_ONLY
+			Stats::printStatsOnExit(m_statsLog, std::cerr);
+		#endif
+		#endif
+	}
+
+	// share the trusted addresses with the demodulators of other receivers
+	void setSharedTrustView(SharedTrustView* shared) noexcept {
+		m_cache.setSharedTrustView(shared);
+	}
+
+	// This is the main entry function called by the SampleStream. 
+	// NumStreams many new bits are shifted in. The crc's are updated
+	// and the streams are being checked for new messages
+	STREAM1090_FORCE_INLINE void shiftInNewBits(uint32_t* cmp) {
+		if constexpr (UsesCoarsePhases) {
+			shiftInCoarsePhases(cmp);
+		} else {
+			m_shiftRegisters.shiftInNewBits(cmp); 
+			// the streams and crc's are ready
+			m_cache.tick();
+			// most streams hold noise with a DF nobody handles, only the others are dispatched
+			const uint64_t startTime = m_currTime;
+			uint64_t candidates = candidateStreams();
+			logStats(Stats::NUM_STREAMS, NumStreams);
+			logStats(Stats::DF_CANDIDATES, std::popcount(candidates));
+			while (candidates) {
+				const int i = std::countr_zero(candidates);
+				candidates &= candidates - 1;
+				m_currTime = startTime + i;
+				handleStream(i);
+			}
+			m_currTime = startTime + NumStreams;
+			logStats(Stats::NUM_ITERATIONS);
+		}
+	}
+
+	// Same as shiftInNewBits, but only the coarse phases are shifted in. All
+	// supported coarse phases are dispatched, plus the phases up to PhaseStep - 1
+	// on either side of one that is near a frame. The phases are dispatched in
+	// order, so the earliest phase that decodes a frame emits it, the same as
+	// with all streams. Phases above the last coarse phase belong to the next
+	// tick and are refined there from its first coarse phase.
+	STREAM1090_FORCE_INLINE void shiftInCoarsePhases(const uint32_t* cmp) {
+		static_assert(NumStreams <= 64, "one bit per stream");
+		// keep the bits of all phases for rebuilding them
+		uint64_t allBits = 0;
+		for (auto i = 0; i < NumStreams; i++)
+			allBits |= uint64_t(cmp[i] & 0x1) << i;
+		m_history[m_historyPos++ % HistoryLength] = allBits;
+
+		uint32_t coarse[NumRegisters];
+		for (auto c = 0; c < NumCoarse; c++)
+			coarse[c] = cmp[c * PhaseStep + CoarseOffset];
+		coarse[NumCoarse] = 0;
+		m_shiftRegisters.shiftInNewBits(coarse);
+		m_cache.tick();
+
+		// bit p is set if phase p is dispatched
+		uint64_t phases = 0;
+		for (auto c = 0; c < NumCoarse; c++) {
+			const auto downlinkFormat = m_shiftRegisters.getDF(c);
+			if (!((SupportedDFMask >> downlinkFormat) & 0x1))
+				continue;
+			phases |= uint64_t(0x1) << (c * PhaseStep + CoarseOffset);
+			if (isNearFrame(c, downlinkFormat))
+				phases |= neighbourMask(c * PhaseStep + CoarseOffset);
+		}
+
+		logStats(Stats::NUM_STREAMS, NumStreams);
+		logStats(Stats::DF_CANDIDATES, std::popcount(phases));
+		const uint64_t startTime = m_currTime;
+		while (phases) {
+			const int p = std::countr_zero(phases);
+			phases &= phases - 1;
+			m_currTime = startTime + p;
+			if (p % PhaseStep == CoarseOffset) {
+				handleStream(p / PhaseStep);
+			} else if (refinePhase(p)) {
+				logStats(Stats::PHASES_REFINED);
+				handleStream(NumCoarse);
+			}
+		}
+		m_currTime = startTime + NumStreams;
+		logStats(Stats::NUM_ITERATIONS);
+	}
+
+	// Advances the time by numSamples without any new bits, e.g. for a gap
+	// between two recordings. Rounded down to whole ticks.
+	void skip(uint64_t numSamples) noexcept {
+		const uint64_t numTicks = numSamples / NumStreams;
+		m_currTime += numTicks * NumStreams;
+		m_cache.skip(numTicks);
+	}
+
+	bool sendFrameLongAligned(int,
+							  const uint8_t downlinkFormat, 
+							  CRC::crc_t, 
+							  const Bits128& frame, 
+							  const typename Cache::Iterator& it) {
+		auto& e = m_cache.getMsgStatEntry(it);
+		if ((m_currTime - e.last_time) < dupWindow()) {
+		    e.last_time = m_currTime;
+    		logStatsDup(downlinkFormat);
+    		return false;
+		}
+
+		if ((downlinkFormat == 20) || (downlinkFormat == 16)) {
+			const auto alt_bits = ModeS::extractSquawkAlt_Long(frame);
+			const auto alt = ModeS::decodeAltitude(alt_bits);
+			if (!m_cache.checkAltitude(it, alt)) {	
+				return false;
+			} else {
+				m_cache.markAsSeen(it);
+			}
+		}
+		
+		if (downlinkFormat == 21) {
+			const auto sqwk = ModeS::extractSquawkAlt_Long(frame);
+			if (!m_cache.checkSquawk(it, sqwk))
+				return false;
+			m_cache.markAsSeen(it);
+		}
+		
+		logStatsSent(downlinkFormat);
+		e.last_time = m_currTime;		
+		m_messageHandler.handleLong(m_currTime, frame);
+		return true;
+	}
+
+	bool sendFrameShortAligned(int, const uint8_t downlinkFormat, CRC::crc_t, const uint64_t& frameShort, const typename Cache::Iterator& it) {
+		auto& e = m_cache.getMsgStatEntry(it);
+		if ((m_currTime - e.last_time) < dupWindow()) {
+		    e.last_time = m_currTime;
+    		logStatsDup(downlinkFormat);
+    		return false;
+		}
+
+		if ((downlinkFormat == 4) || (downlinkFormat == 0)) {
+			const auto alt_bits = ModeS::extractSquawkAlt_Short(frameShort);
+			const auto alt = ModeS::decodeAltitude(alt_bits);
+			if (!m_cache.checkAltitude(it, alt)) {
+				return false;
+			} else {
+				m_cache.markAsSeen(it);
+			}
+		}
+
+		if (downlinkFormat == 5) {
+			const auto sqwk = ModeS::extractSquawkAlt_Short(frameShort);
+			if (!m_cache.checkSquawk(it, sqwk))
+				return false;
+			m_cache.markAsSeen(it);
+		}
+
+		logStatsSent(downlinkFormat);
+		e.last_time = m_currTime;
+		m_messageHandler.handleShort(m_currTime, frameShort);
+		return true;
+	}
+
+	bool phaseDupCheckShort(const uint64_t& frameShort) noexcept {
+		if (frameShort == m_prevShortFrame)
+			return true;
+		
+		m_prevShortFrame = frameShort;
+		return false;
+	}
+
+	bool phaseDupCheckLong(const Bits128& frameLong) noexcept {
+		if (frameLong == m_prevLongFrame)
+			return true;
+		
+		m_prevLongFrame = frameLong;
+		return false;
+	}
+
+	// the downlink formats handleStream takes care of, bit df is set
+	static constexpr uint32_t SupportedDFMask {
+		(0x1u << 0) | (0x1u << 4) | (0x1u << 5) | (0x1u << 11) | (0x1u << 16) |
+		(0x1u << 17) | (0x1u << 18) | (0x1u << 19) | (0x1u << 20) | (0x1u << 21)
+	};
+
+	// Bit i is set if stream i holds a supported DF. The loop has no branches
+	// and is vectorized by the compiler.
+	STREAM1090_FORCE_INLINE uint64_t candidateStreams() const noexcept {
+		static_assert(NumStreams <= 64, "one bit per stream");
+		uint64_t res = 0;
+		for (auto i = 0; i < NumStreams; i++)
+			res |= uint64_t((SupportedDFMask >> m_shiftRegisters.getDF(i)) & 0x1) << i;
+		return res;
+	}
+
+	// The coarse stream holds a frame that is correct or that a repair table or the
+	// address index can explain. A neighbouring phase may have it earlier or without errors.
+	bool isNearFrame(int streamIndex, uint32_t downlinkFormat) const noexcept {
+		switch (downlinkFormat) {
+		case 0:
+		case 4:
+		case 5: {
+			const auto crc = m_shiftRegisters.getCRC_56(streamIndex);
+			return (crc != 0) && (m_cache.contains(crc)
+				|| m_cache.findParityRepair(crc, AddressParityIndex::NumBitsShort).entry.isValid());
+		}
+		case 11: {
+			const auto crc = m_shiftRegisters.getCRC_56(streamIndex);
+			const auto frameShort = m_shiftRegisters.extractAlignedFrameShort(streamIndex);
+			return (crc == 0) || CRC::df11ErrorTable.lookup(crc).valid()
+				|| m_cache.containsWithCA(ModeS::extractICAOWithCA_Short(frameShort));
+		}
+		case 16:
+		case 20:
+		case 21: {
+			const auto crc = m_shiftRegisters.getCRC_112(streamIndex);
+			return (crc != 0) && (m_cache.contains(crc)
+				|| m_cache.findParityRepair(crc, AddressParityIndex::NumBitsLong).entry.isValid());
+		}
+		default: {
+			const auto crc = m_shiftRegisters.getCRC_112(streamIndex);
+			return (crc == 0) || CRC::df17ErrorTable.lookup(crc).valid();
+		}
+		}
+	}
+
+	// the phases around phase that belong to this tick
+	static constexpr uint64_t neighbourMask(int phase) noexcept {
+		uint64_t res = 0;
+		for (auto p = std::max(0, phase - PhaseStep + 1); p < std::min(NumStreams, phase + PhaseStep); p++)
+			res |= uint64_t(0x1) << p;
+		return res & ~(uint64_t(0x1) << phase);
+	}
+
+	// Rebuilds the last 128 bits of phase into the extra stream. Returns true if it holds a supported DF
+	bool refinePhase(int phase) noexcept {
+		uint64_t low = 0;
+		uint64_t high = 0;
+		for (size_t k = 0; k < 64; k++) {
+			low  |= ((m_history[(m_historyPos - 1 - k) % HistoryLength] >> phase) & 0x1) << k;
+			high |= ((m_history[(m_historyPos - 65 - k) % HistoryLength] >> phase) & 0x1) << k;
+		}
+		m_shiftRegisters.loadStream(NumCoarse, high, low);
+		return (SupportedDFMask >> m_shiftRegisters.getDF(NumCoarse)) & 0x1;
+	}
+
+	// Dispatcher function for handling messages based on the downlink format  
+	bool handleStream(int streamIndex) {
+		const auto downlinkFormat = m_shiftRegisters.getDF(streamIndex);
+		
+		switch (downlinkFormat)
+		{
+		case 0: // acas
+		case 4: // surveillance altitude
+		case 5: // surveillance identity
+			return handleAcasSurvShortMessage(streamIndex, downlinkFormat);
+		case 11: // DF 11 messages
+			return handleDF11ShortMessage(streamIndex);
+
+		// Extended squitter messages
+		case 17:
+		case 18:
+		case 19:
+			return handleExtSquitterLongMessage(streamIndex, downlinkFormat);
+		//  ACAS, Comm-B Messages
+		case 16:
+		case 20:
+		case 21:
+			return handleAcasCommBLongMessage(streamIndex, downlinkFormat);
+		default:
+			break;
+		}
+
+		return false;
+	}
+
+	/// @brief Handler for the extended squitter messages
+	/// @return returns true if a message has been send to the output
+	bool handleExtSquitterLongMessage(int streamIndex, const uint8_t& downlinkFormat) {
+		auto frame = m_shiftRegisters.extractAlignedFrameLong(streamIndex);
+
+		if (phaseDupCheckLong(frame))
+			return false;
+
+		auto crc = m_shiftRegisters.getCRC_112(streamIndex);
+
+		// if the crc is zero, we have a correct message
+		if (crc == 0) {
+			// we consider a crc of 0 as a good message
+			logStats(Stats::DF17_GOOD_MESSAGE);
+			// get the address including the CA field
+			const auto icaoWithCA = ModeS::extractICAOWithCA_Long(frame);
+			const auto e = m_cache.findWithCA(icaoWithCA);
+			
+			// if we know this plane
+			if (e.isValid()) {
+				m_cache.markAsTrustedSeen(e);
+				// and send the 112 bit message to the output
+				return sendFrameLongAligned(streamIndex, downlinkFormat, crc, frame, e);
+			} else {
+				m_cache.markAsTrustedSeen(m_cache.insertWithCA(icaoWithCA));
+			} 
+		} else {
+			// the crc is not zero, so we might have a broken message
+			logStats(Stats::DF17_BAD_MESSAGE);
+			// Ask the error table for a possible fix
+			const auto fix_op = m_policy.DF17Experimental ? CRC::df17ErrorTable.lookup(crc)
+			                                              : CRC::df17ErrorTableBasic.lookup(crc);
+			// can we fix it?
+			if (fix_op.valid()) {
+				// make a copy of the broken message
+				Bits128 toRepair{ frame };
+				// and let the error table apply the fix
+				CRC::applyFixOp(fix_op, toRepair, 0);
+				// extract the address together with the CA bits
+				const auto icaoWithCA = ModeS::extractICAOWithCA_Long(toRepair);
+				// do we know this icao address? We are only asking there the list of trusted addresses
+				// using a not trusted address and repairing at the same time is too dangerous
+				const auto e = m_cache.findWithCA(icaoWithCA);
+
+				// if this plane is not known we are leaving this
+				if (!e.isValid())
+					return false;
+
+				if (m_cache.isTrusted(e)) {
+					// log that fixing the message was a success
+					logStats(Stats::DF17_REPAIR_SUCCESS);
+					// and keep the trusted entry alive
+					m_cache.markAsTrustedSeen(e);
+					// send the 112 bit message to the output
+					return sendFrameLongAligned(streamIndex, downlinkFormat, crc, toRepair, e);
+				};				
+			}
+			logStats(Stats::DF17_REPAIR_FAILED);
+		}
+		return false;
+	}
+
+	/// @brief Handler for long ACAS and Comm-B messages
+	/// @return returns true if a message has been send to the output
+	bool handleAcasCommBLongMessage(int streamIndex, const uint8_t& downlinkFormat) {
+		auto frame = m_shiftRegisters.extractAlignedFrameLong(streamIndex);
+
+		if (phaseDupCheckLong(frame))
+			return false;
+
+		auto crc = m_shiftRegisters.getCRC_112(streamIndex);
+		// a valid message has the icao overlaid, i.e., check if crc corresponds to 
+		// a known, active and trusted address
+		if (crc ==  0)
+			return false;
+		const auto e = m_cache.find(crc);
+		// if this is not in the list of known planes, a single bit error may have hidden a trusted one
+		if (!e.isValid()) {
+			if (!m_policy.AddressParityRepair)
+				return false;
+			// ask the index of trusted addresses for a bit that explains the crc
+			const auto repair = m_cache.findParityRepair(crc, AddressParityIndex::NumBitsLong);
+			if (!repair.entry.isValid())
+				return false;
+			// flip the bit in a copy and output the repaired message
+			Bits128 toRepair{ frame };
+			CRC::applyFixOp(repair.op, toRepair, 0);
+			if (!isPlausibleRepair(downlinkFormat, ModeS::extractSquawkAlt_Long(toRepair), repair.entry))
+				return false;
+			logStatsRepaired(downlinkFormat);
+			return sendFrameLongAligned(streamIndex, downlinkFormat, crc, toRepair, repair.entry);
+		}
+
+		if (m_cache.isAlive(e)) {
+			// log that this message is a good message
+			logStats(Stats::COMM_B_GOOD_MESSAGE);
+			// output the message
+			return sendFrameLongAligned(streamIndex, downlinkFormat, crc, frame, e);
+		}
+
+		return false;
+	}
+
+	/// @brief This function handles the downlink formats 0 (short acas reply), 4 (altitude reply), and 5 (identity reply)
+	/// @return returns true if a message has been send to the output
+	bool handleAcasSurvShortMessage(int streamIndex, const uint8_t& downlinkFormat) {
+		// get the short message frame
+		const auto frameShort = m_shiftRegisters.extractAlignedFrameShort(streamIndex);
+		// first check if we have seen this in the previous stream
+		if (phaseDupCheckShort(frameShort))
+			return false;
+
+		const auto crc = m_shiftRegisters.getCRC_56(streamIndex);
+
+		if (crc ==  0)
+			return false;
+		// for DF 0, 4, 5 we have address parity, i.e. the crc of a valid message corresponds to the address of the transponder
+		// check if we have a trustworthy address in our cache
+		const auto e = m_cache.find(crc);
+		// if this is not in the list of known planes, a single bit error may have hidden a trusted one
+		if (!e.isValid()) {
+			if (!m_policy.AddressParityRepair)
+				return false;
+			// same as for the long messages, but only bits of the short frame
+			const auto repair = m_cache.findParityRepair(crc, AddressParityIndex::NumBitsShort);
+			if (!repair.entry.isValid())
+				return false;
+			auto toRepair = frameShort;
+			CRC::applyFixOp(repair.op, toRepair, 0);
+			if (!isPlausibleRepair(downlinkFormat, ModeS::extractSquawkAlt_Short(toRepair), repair.entry))
+				return false;
+			logStatsRepaired(downlinkFormat);
+			return sendFrameShortAligned(streamIndex, downlinkFormat, crc, toRepair, repair.entry);
+		}
+
+		if (m_cache.isAlive(e)) {
+			// log that this message is a good message
+			logStats(Stats::ACAS_SURV_GOOD_MESSAGE);
+			// output the message
+			return sendFrameShortAligned(streamIndex, downlinkFormat, crc, frameShort, e);		
+		} 
+		return false;
+	}
+
+	/// @brief A repaired frame with address parity has to agree with the squawk or altitude confirmed before.
+	/// Noise finds a bit to flip much more often than it matches an address, hence the strict check.
+	bool isPlausibleRepair(uint8_t downlinkFormat, uint16_t squawkAlt, const typename Cache::Iterator& it) const noexcept {
+		if ((downlinkFormat == 5) || (downlinkFormat == 21))
+			return m_cache.matchesSquawk(it, squawkAlt);
+		return m_cache.matchesAltitude(it, ModeS::decodeAltitude(squawkAlt), m_policy.RepairALT_delta_ft);
+	}
+
+	/// @brief Helper function for all-call replies (DF11) with a crc of zero. Either received correctly or repaired with 1-bit error correction
+	/// @return returns true if a message has been send to the output
+	bool handleDF11ShortMessageWithZeroCRC(int streamIndex, const uint64_t& frameShort, bool repaired) {
+		const auto icaoWithCA = ModeS::extractICAOWithCA_Short(frameShort);
+		const auto e = m_cache.findWithCA(icaoWithCA);
+		
+		// if the plane is not in table,
+		if (!e.isValid()) {
+			// put it there.
+			if (!repaired) {
+				m_cache.insertWithCA(icaoWithCA);
+			}
+			// we stop here and do not send the message
+			return false;
+		}
+
+		if (m_cache.isAlive(e)) {
+			// log that this message is a good message
+			// we consider this a valid message
+			m_cache.markAsSeen(e);
+			// and output the message
+			return sendFrameShortAligned(streamIndex, 11, 0, frameShort, e);
+		} 
+		m_cache.markAsSeen(e);
+		return false;
+	}
+
+	/// @brief This function handles all-call replies (downlink format 11).
+	/// @return returns true if a message has been send to the output
+	bool handleDF11ShortMessage(int streamIndex) {
+		auto frameShort = m_shiftRegisters.extractAlignedFrameShort(streamIndex);
+
+		if (phaseDupCheckShort(frameShort))
+			return false;
+
+		const auto crc = m_shiftRegisters.getCRC_56(streamIndex);
+	
+		if (crc == 0) {
+			logStats(Stats::DF11_ICAO_CA_FOUND_GOOD_CRC);
+			return handleDF11ShortMessageWithZeroCRC(streamIndex, frameShort, false);
+		} else  {
+			// ask the 1 bit error correction table for short messages for help
+			const auto fix_op = CRC::df11ErrorTable.lookup(crc);
+			// can we fix it?
+			if (fix_op.valid()) {
+				// let the error table apply the fix
+				CRC::applyFixOp(fix_op, frameShort, 0);
+				logStats(Stats::DF11_ICAO_CA_FOUND_1_BIT_FIX);
+				// we are good now and proceed as with the normal zero crc case
+				return handleDF11ShortMessageWithZeroCRC(streamIndex, frameShort, true);
+			} else {
+				// the crc is not good and no repairs with the error table. We do now a dirty trick here.
+				// get the address including the CA field
+				const auto icaoWithCA = ModeS::extractICAOWithCA_Short(frameShort);
+				// look up the address in the trusted list
+				const auto e = m_cache.findWithCA(icaoWithCA);
+				// if it is there and we consider this as an active trusted transponder
+				if (e.isValid() && m_cache.isTrusted(e)) {
+					// Hence, we trust the address including the CA field. Downlink format is correct. 
+					// make sure to have this sender address in the list of known but not thrustworthy addresses
+					m_cache.markAsSeen(e);
+					// The only remaining data in this short message is the parity block. Fix it and output the message
+					return sendFrameShortAligned(streamIndex, 11, 0, frameShort ^ crc, e);
+				}
+			}
+		}
+		return false;
+	} 
+
+
+private:
+
+#if defined(STATS_ENABLED) && STATS_ENABLED
+	Stats::StatsLog m_statsLog;
+	void logStats(Stats::EventType evt, int count = 1) {
+		m_statsLog.log(evt, count);
+		#if !(defined(STATS_END_ONLY) && STATS_END_ONLY)
+			if (evt == Stats::NUM_ITERATIONS)
+				Stats::printTick(m_statsLog, std::cerr);
+		#endif
+	}
+
+	void logStatsSent(int df) {
+		m_statsLog.logSent(df);
+	}
+
+	void logStatsDup(int df) {
+		m_statsLog.logDup(df);
+	}
+
+	void logStatsRepaired(int df) {
+		m_statsLog.logRepaired(df);
+	}
+#else
+	void logStats(Stats::EventType, int = 1) {}
+	void logStatsSent(int) {}
+	void logStatsDup(int) {}
+	void logStatsRepaired(int) {}
+#endif	
+	// the dup window of the policy in samples
+	constexpr uint64_t dupWindow() const noexcept {
+		return m_policy.DupWindowTicks * NumStreams;
+	}
+
+	static constexpr uint64_t samplesPerSecond() {
+		return NumStreams * 1000000;
+	}
+
+	static constexpr uint64_t secondsToNumSamples(float secs) {
+		return (samplesPerSecond() * secs);
+	}
+	
+	// while dealing with a single stream, this holds a copy of the frame
+	// from the previous stream  
+	alignas(16) Bits128 m_prevLongFrame; 
+	alignas(16) uint64_t m_prevShortFrame; 
+
+	// the constants in use
+	[[no_unique_address]] Policy m_policy;
+
+	// plane lookup table
+	Cache m_cache; 
+	
+	// the current time measured in samples.
+	uint64_t m_currTime{ 0 };
+	
+	// the shift registers for the bits
+	ShiftRegisters<NumRegisters> m_shiftRegisters;
+
+	// the bits of all phases of the last ticks, only used with coarse phases
+	static constexpr size_t HistoryLength = 128;
+	std::array<uint64_t, UsesCoarsePhases ? HistoryLength : 1> m_history{};
+	size_t m_historyPos = 0;
+
+	// the message handler that deals with long and short frames
+	Handler& m_messageHandler;
+};
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// The constants that control which frames the demodulator trusts and emits.
+// ICAOTable and DemodCore are templated on a policy and access the members
+// through an instance, so both policies below can be used the same way.
+//
+// The default policy has only static constexpr members. The compiler folds
+// them exactly like the hard-coded constants they replace.
+struct DefaultDemodPolicy {
+	// seconds an address stays alive after a frame was received
+	static constexpr uint16_t TTL_not_trusted { 10 };
+	// seconds an address stays trusted after a frame with a good crc was received
+	static constexpr uint16_t TTL_trusted { 30 };
+	// maximum altitude jump in feet between two consecutive frames of an address
+	static constexpr int ALT_delta_ft { 2000 };
+	// frames of the same address closer than this (in 1 MHz ticks) are dupes
+	static constexpr uint64_t DupWindowTicks { 30 };
+	// use DF17ErrorTableExperimental instead of DF17ErrorTable for repairs
+	static constexpr bool DF17Experimental { true };
+	// repair single bit errors of DF 0, 4, 5, 16, 20, 21 against trusted addresses
+	static constexpr bool AddressParityRepair { true };
+	// maximum distance in feet of a repaired altitude to the confirmed one
+	static constexpr int RepairALT_delta_ft { 200 };
+};
+
+// Same members as DefaultDemodPolicy, but changeable at runtime.
+// Used by the sweep tools to evaluate many settings without recompiling.
+struct RuntimeDemodPolicy {
+	uint16_t TTL_not_trusted { DefaultDemodPolicy::TTL_not_trusted };
+	uint16_t TTL_trusted { DefaultDemodPolicy::TTL_trusted };
+	int ALT_delta_ft { DefaultDemodPolicy::ALT_delta_ft };
+	uint64_t DupWindowTicks { DefaultDemodPolicy::DupWindowTicks };
+	bool DF17Experimental { DefaultDemodPolicy::DF17Experimental };
+	bool AddressParityRepair { DefaultDemodPolicy::AddressParityRepair };
+	int RepairALT_delta_ft { DefaultDemodPolicy::RepairALT_delta_ft };
+};
@@ -0,0 +1,212 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <vector>
+
+#include "CpuDispatch.hpp"
+
+// Overlap-save convolution of I and Q with long real filters. I and Q are the
+// real and the imaginary part of a single complex FFT. Since the taps are real,
+// the real part of the result is the filtered I and the imaginary part the
+// filtered Q, i.e., one forward and one inverse FFT filter both.
+//
+// A frame holds the last numTaps - 1 samples followed by the new block. It is
+// transformed, multiplied with the spectrum of the taps and transformed back.
+// The first numTaps - 1 results wrapped around and are dropped, the others are
+// exactly the FIR of the block. There is no delay on top of the one of the FIR.
+//
+// The forward FFT is a radix-2 decimation in frequency, which leaves the
+// spectrum in bit reversed order. The spectrum of the taps is in the same order,
+// and the inverse FFT is a decimation in time that takes bit reversed input,
+// so the frame is never reordered. The last two stages of the one and the first
+// two of the other have the trivial twiddles 1 and -i and run as one radix-4
+// stage. Real and imaginary parts are in separate arrays and every stage has
+// its twiddles in one contiguous row, hence the butterflies vectorize.
+class FFTConvolver {
+public:
+    // the frame size is at most maxFrameSize, a power of two
+    explicit FFTConvolver(size_t maxFrameSize)
+        : m_maxFrameSize(std::bit_ceil(maxFrameSize)),
+          m_re(m_maxFrameSize), m_im(m_maxFrameSize),
+          m_spectrum_re(m_maxFrameSize), m_spectrum_im(m_maxFrameSize),
+          m_twiddle_re(m_maxFrameSize), m_twiddle_im(m_maxFrameSize)
+    {}
+
+    // Prepares the spectrum of the taps for blocks of at most blockSize samples.
+    // False if the frame would be larger than maxFrameSize.
+    bool setTaps(const float* taps, size_t numTaps, size_t blockSize) {
+        if (numTaps == 0 || blockSize == 0)
+            return false;
+        const size_t frameSize = std::max<size_t>(std::bit_ceil(numTaps - 1 + blockSize), 4);
+        if (frameSize > m_maxFrameSize)
+            return false;
+
+        m_numTaps = numTaps;
+        m_blockSize = blockSize;
+        setFrameSize(frameSize);
+
+        // out[i] = sum of taps[k] * x[i + k] is a convolution with the reversed taps,
+        // the scale of the inverse FFT is folded into the spectrum
+        const float scale = 1.0f / float(m_frameSize);
+        std::fill(m_spectrum_re.begin(), m_spectrum_re.end(), 0.0f);
+        std::fill(m_spectrum_im.begin(), m_spectrum_im.end(), 0.0f);
+        for (size_t k = 0; k < numTaps; k++)
+            m_spectrum_re[numTaps - 1 - k] = taps[k] * scale;
+        forward(m_spectrum_re.data(), m_spectrum_im.data());
+        return true;
+    }
+
+    size_t frameSize() const noexcept {
+        return m_frameSize;
+    }
+
+    size_t blockSize() const noexcept {
+        return m_blockSize;
+    }
+
+    // out[i] = sum of taps[k] * x[i + k] for i < n <= blockSize, x holds numTaps - 1 + n samples
+    STREAM1090_FORCE_INLINE void convolve(const float* __restrict x_I, const float* __restrict x_Q,
+                                          float* __restrict out_I, float* __restrict out_Q, size_t n) noexcept {
+        float* __restrict re = m_re.data();
+        float* __restrict im = m_im.data();
+        const size_t frameLength = m_numTaps - 1 + n;
+        for (size_t i = 0; i < frameLength; i++) {
+            re[i] = x_I[i];
+            im[i] = x_Q[i];
+        }
+        for (size_t i = frameLength; i < m_frameSize; i++) {
+            re[i] = 0.0f;
+            im[i] = 0.0f;
+        }
+
+        forward(re, im);
+
+        // both spectra are in bit reversed order
+        const float* __restrict h_re = m_spectrum_re.data();
+        const float* __restrict h_im = m_spectrum_im.data();
+        for (size_t i = 0; i < m_frameSize; i++) {
+            const float a = re[i];
+            const float b = im[i];
+            re[i] = a * h_re[i] - b * h_im[i];
+            im[i] = a * h_im[i] + b * h_re[i];
+        }
+
+        // the inverse FFT is a forward one with real and imaginary part swapped
+        inverse(im, re);
+
+        for (size_t i = 0; i < n; i++) {
+            out_I[i] = re[m_numTaps - 1 + i];
+            out_Q[i] = im[m_numTaps - 1 + i];
+        }
+    }
+
+private:
+    void setFrameSize(size_t frameSize) {
+        m_frameSize = frameSize;
+        // the twiddles of the stage with butterflies of half size h are at [h, 2h)
+        for (size_t h = 1; h < frameSize; h *= 2) {
+            for (size_t j = 0; j < h; j++) {
+                const double angle = -std::numbers::pi * double(j) / double(h);
+                m_twiddle_re[h + j] = float(std::cos(angle));
+                m_twiddle_im[h + j] = float(std::sin(angle));
+            }
+        }
+    }
+
+    // in-place FFT, natural order in, bit reversed order out
+    STREAM1090_FORCE_INLINE void forward(float* __restrict re, float* __restrict im) const noexcept {
+        const size_t n = m_frameSize;
+        for (size_t h = n / 2; h >= 4; h /= 2) {
+            const float* __restrict w_re = m_twiddle_re.data() + h;
+            const float* __restrict w_im = m_twiddle_im.data() + h;
+            for (size_t base = 0; base < n; base += 2 * h) {
+                float* __restrict lo_re = re + base;
+                float* __restrict lo_im = im + base;
+                float* __restrict hi_re = re + base + h;
+                float* __restrict hi_im = im + base + h;
+                for (size_t j = 0; j < h; j++) {
+                    const float d_re = lo_re[j] - hi_re[j];
+                    const float d_im = lo_im[j] - hi_im[j];
+                    lo_re[j] += hi_re[j];
+                    lo_im[j] += hi_im[j];
+                    hi_re[j] = d_re * w_re[j] - d_im * w_im[j];
+                    hi_im[j] = d_re * w_im[j] + d_im * w_re[j];
+                }
+            }
+        }
+
+        // the stages of half size 2 and 1
+        for (size_t i = 0; i < n; i += 4) {
+            const float a_re = re[i] + re[i + 2], a_im = im[i] + im[i + 2];
+            const float b_re = re[i + 1] + re[i + 3], b_im = im[i + 1] + im[i + 3];
+            const float c_re = re[i] - re[i + 2], c_im = im[i] - im[i + 2];
+            // (x1 - x3) * -i
+            const float d_re = im[i + 1] - im[i + 3], d_im = re[i + 3] - re[i + 1];
+            re[i]     = a_re + b_re; im[i]     = a_im + b_im;
+            re[i + 1] = a_re - b_re; im[i + 1] = a_im - b_im;
+            re[i + 2] = c_re + d_re; im[i + 2] = c_im + d_im;
+            re[i + 3] = c_re - d_re; im[i + 3] = c_im - d_im;
+        }
+    }
+
+    // in-place FFT, bit reversed order in, natural order out
+    STREAM1090_FORCE_INLINE void inverse(float* __restrict re, float* __restrict im) const noexcept {
+        const size_t n = m_frameSize;
+        // the stages of half size 1 and 2
+        for (size_t i = 0; i < n; i += 4) {
+            const float a_re = re[i] + re[i + 1], a_im = im[i] + im[i + 1];
+            const float b_re = re[i] - re[i + 1], b_im = im[i] - im[i + 1];
+            const float c_re = re[i + 2] + re[i + 3], c_im = im[i + 2] + im[i + 3];
+            // (x2 - x3) * -i
+            const float d_re = im[i + 2] - im[i + 3], d_im = re[i + 3] - re[i + 2];
+            re[i]     = a_re + c_re; im[i]     = a_im + c_im;
+            re[i + 2] = a_re - c_re; im[i + 2] = a_im - c_im;
+            re[i + 1] = b_re + d_re; im[i + 1] = b_im + d_im;
+            re[i + 3] = b_re - d_re; im[i + 3] = b_im - d_im;
+        }
+
+        for (size_t h = 4; h < n; h *= 2) {
+            const float* __restrict w_re = m_twiddle_re.data() + h;
+            const float* __restrict w_im = m_twiddle_im.data() + h;
+            for (size_t base = 0; base < n; base += 2 * h) {
+                float* __restrict lo_re = re + base;
+                float* __restrict lo_im = im + base;
+                float* __restrict hi_re = re + base + h;
+                float* __restrict hi_im = im + base + h;
+                for (size_t j = 0; j < h; j++) {
+                    const float t_re = hi_re[j] * w_re[j] - hi_im[j] * w_im[j];
+                    const float t_im = hi_re[j] * w_im[j] + hi_im[j] * w_re[j];
+                    hi_re[j] = lo_re[j] - t_re;
+                    hi_im[j] = lo_im[j] - t_im;
+                    lo_re[j] += t_re;
+                    lo_im[j] += t_im;
+                }
+            }
+        }
+    }
+
+    size_t m_maxFrameSize;
+    size_t m_frameSize = 0;
+    size_t m_numTaps = 0;
+    size_t m_blockSize = 0;
+
+    // the frame while it is being filtered
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    // the spectrum of the reversed taps, divided by the frame size
+    std::vector<float> m_spectrum_re;
+    std::vector<float> m_spectrum_im;
+    std::vector<float> m_twiddle_re;
+    std::vector<float> m_twiddle_im;
+};
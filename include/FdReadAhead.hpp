@@ -0,0 +1,207 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Global.hpp"
+#include "RingBuffer.hpp"
+#include "StreamGaps.hpp"
+
+// Reads raw samples from a file descriptor, usually a pipe on stdin, on its own
+// thread into the ring buffer. The DSP thread reads them from there like from a
+// device. A stall of the pipe then does not idle the decoder right away, and a
+// burst of decoding work does not stall the process writing into the pipe.
+//
+// The fd is read with read(2) into an aligned chunk, iostreams are not involved.
+// At the end of the stream the samples are padded with zeros to a full block
+// of the sample stream, as the synchronous reader did.
+//
+// Several recordings (see Playlist) are read back to back into the same stream.
+// The next one is opened and advised to the page cache while the current one is
+// read. A known gap between two recordings is not filled with samples. The
+// previous recording is padded with zeros so that its last frames leave the
+// demodulator, and the rest of the gap is queued for the reader, see gaps().
+template<typename T>
+class FdReadAhead {
+public:
+    // bytes read at once
+    static constexpr size_t ChunkSize = 256 * 1024;
+
+    struct Source {
+        // empty for the fd given to the constructor
+        std::string path;
+        // input samples missing right before this source
+        uint64_t gapSamples = 0;
+    };
+
+    // reads fd, e.g. stdin
+    FdReadAhead(int fd, IAsyncWriter<T>& writer) : m_sources(1), m_fd(fd), m_target(writer), m_writer(writer) {}
+
+    // reads the files one after the other
+    FdReadAhead(std::vector<Source> sources, IAsyncWriter<T>& writer)
+        : m_sources(std::move(sources)), m_fd(-1), m_target(writer), m_writer(writer) {}
+
+    ~FdReadAhead() {
+        join();
+    }
+
+    // Sets the capacity of the pipe the fd refers to. Returns the new capacity,
+    // 0 if the fd is no pipe and -1 if it failed (errno is set).
+    long setPipeBufferSize(size_t numBytes) {
+        struct stat st;
+        if (fstat(m_fd, &st) != 0 || !S_ISFIFO(st.st_mode))
+            return 0;
+#if defined(F_SETPIPE_SZ)
+        return fcntl(m_fd, F_SETPIPE_SZ, int(numBytes));
+#else
+        (void)numBytes;
+        errno = ENOTSUP;
+        return -1;
+#endif
+    }
+
+    // Starts the thread. The stream is padded to a multiple of blockValues raw values.
+    // Before a gap at least flushValues zeros are added. The gaps count input samples
+    // of valuesPerSample raw values each.
+    void start(size_t blockValues, size_t flushValues = 0, size_t valuesPerSample = 2) {
+        m_thread = std::thread([this, blockValues, flushValues, valuesPerSample] {
+            run(blockValues, flushValues, valuesPerSample);
+        });
+    }
+
+    // the gaps between the recordings, for the reader
+    StreamGaps& gaps() noexcept {
+        return m_gaps;
+    }
+
+    void join() {
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    pthread_t nativeHandle() {
+        return m_thread.native_handle();
+    }
+
+    size_t numBytesRead() const noexcept { return m_numBytesRead.load(std::memory_order_relaxed); }
+    size_t numReads() const noexcept { return m_numReads.load(std::memory_order_relaxed); }
+    // how often the pipe was empty when the thread wanted to read
+    size_t numPipeStalls() const noexcept { return m_numPipeStalls.load(std::memory_order_relaxed); }
+    // empty if the stream ended normally
+    const std::string& error() const noexcept { return m_error; }
+
+private:
+    struct AlignedDeleter {
+        void operator()(unsigned char* p) const noexcept {
+            ::operator delete[](p, std::align_val_t(64));
+        }
+    };
+
+    int openSource(size_t index) {
+        if (index >= m_sources.size())
+            return -1;
+        if (m_sources[index].path.empty())
+            return m_fd;
+        const int fd = ::open(m_sources[index].path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            m_error = m_sources[index].path + ": " + std::strerror(errno);
+        } else {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        }
+        return fd;
+    }
+
+    void run(size_t blockValues, size_t flushValues, size_t valuesPerSample) {
+        std::unique_ptr<unsigned char[], AlignedDeleter> chunk(
+            new (std::align_val_t(64)) unsigned char[ChunkSize], AlignedDeleter{});
+        int fd = openSource(0);
+        for (size_t i = 0; fd >= 0 && m_error.empty() && !ProcessSignals::shutdownRequested(); i++) {
+            // the next one is already on its way to the page cache
+            const int nextFd = openSource(i + 1);
+
+            const uint64_t gapSamples = m_sources[i].gapSamples;
+            if (i > 0 && gapSamples > 0) {
+                const uint64_t padded = m_writer.pad(blockValues, flushValues) / valuesPerSample;
+                if (gapSamples > padded)
+                    m_gaps.push(m_writer.numValues() / valuesPerSample, gapSamples - padded);
+            }
+
+            copy(fd, m_sources[i].path, chunk.get());
+            if (fd != m_fd)
+                ::close(fd);
+            fd = nextFd;
+        }
+        if (fd >= 0 && fd != m_fd)
+            ::close(fd);
+
+        // pad to the end of the block, a full one if the stream ends exactly at a block
+        m_writer.pad(blockValues, 0);
+        m_target.shutdown();
+    }
+
+    // reads fd until its end, an error or a shutdown
+    void copy(int fd, const std::string& path, unsigned char* chunk) {
+        // bytes of an incomplete value at the front of the chunk
+        size_t carry = 0;
+
+        pollfd pfd{ fd, POLLIN, 0 };
+        while (!ProcessSignals::shutdownRequested()) {
+            if (poll(&pfd, 1, 0) == 0) {
+                m_numPipeStalls.fetch_add(1, std::memory_order_relaxed);
+                // wait with a timeout, so a shutdown is noticed while the pipe is silent
+                while (!ProcessSignals::shutdownRequested() && poll(&pfd, 1, 200) == 0) { }
+                continue;
+            }
+
+            const ssize_t res = ::read(fd, chunk + carry, ChunkSize - carry);
+            if (res < 0) {
+                if (errno == EINTR || errno == EAGAIN)
+                    continue;
+                m_error = (path.empty() ? std::string() : path + ": ") + std::strerror(errno);
+                return;
+            }
+            if (res == 0)
+                return;
+
+            m_numReads.fetch_add(1, std::memory_order_relaxed);
+            m_numBytesRead.fetch_add(size_t(res), std::memory_order_relaxed);
+
+            const size_t numBytes = carry + size_t(res);
+            const size_t n = numBytes / sizeof(T);
+            m_writer.write(reinterpret_cast<const T*>(chunk), n);
+
+            carry = numBytes - n * sizeof(T);
+            std::memmove(chunk, chunk + n * sizeof(T), carry);
+        }
+    }
+
+    std::vector<Source> m_sources;
+    int m_fd;
+    IAsyncWriter<T>& m_target;
+    // counts the values for the positions of the gaps
+    CountingWriter<T> m_writer;
+    std::thread m_thread;
+    std::atomic<size_t> m_numBytesRead{0};
+    std::atomic<size_t> m_numReads{0};
+    std::atomic<size_t> m_numPipeStalls{0};
+    std::string m_error;
+    StreamGaps m_gaps;
+};
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Presets.hpp"
+#include "SampleStream.hpp"
+#include "InputMemoryReader.hpp"
+#include "MessageHandler.hpp"
+
+// The result of decoding a recording once
+struct DecodeCounts {
+    uint64_t total = 0;
+    uint64_t numLong = 0;
+    std::array<uint64_t, 32> perDF{};
+};
+
+// Reads a complete raw recording into memory. Returns an empty vector on failure.
+template<typename RawType>
+std::vector<RawType> loadRecording(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return {};
+
+    const auto numBytes = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    // we only want complete IQ pairs
+    const size_t numValues = (numBytes / (2 * sizeof(RawType))) * 2;
+    std::vector<RawType> data(numValues);
+    if (!file.read(reinterpret_cast<char*>(data.data()), numValues * sizeof(RawType)))
+        return {};
+
+    return data;
+}
+
+// Runs the full pipeline (IQ pipeline with custom taps, sampler, demodulator)
+// over a recording held in memory. The recording is shared by all evaluations,
+// each evaluation has its own pipeline, sample stream and demodulator.
+// This allows to evaluate many tap candidates in parallel without re-reading
+// and re-converting the recording for every candidate.
+template<typename preset>
+class FilterEvaluator {
+public:
+    using RawFormatType = typename preset::RawFormatType;
+    using RawType       = typename preset::RawType;
+    using SamplerType   = typename preset::SamplerType;
+
+    static constexpr SampleRate inputRate  = SamplerType::InputSampleRate;
+    static constexpr SampleRate outputRate = SamplerType::OutputSampleRate;
+    // the rate of the raw IQ pairs, higher than inputRate if the pipeline decimates
+    static constexpr SampleRate rawRate    = preset::inputRate;
+
+    explicit FilterEvaluator(const std::vector<RawType>& recording) : m_recording(recording) { }
+
+    // decodes the recording once with the given taps
+    DecodeCounts evaluate(const std::vector<float>& taps) const {
+        auto iqPipeline = IQPipelineSelector<inputRate, outputRate, preset::pipelineOption, preset::decimation>::make(taps);
+
+        InputMemoryReader<
+            RawFormatType,
+            SamplerType::InputBufferSize,
+            decltype(iqPipeline)
+        > inputReader(iqPipeline, m_recording.data(), m_recording.size());
+
+        CountingMessageHandler messageHandler;
+        // the sample stream has large buffers, keep it off the stack
+        auto sampleStream = std::make_unique<SampleStream<SamplerType>>();
+        sampleStream->read(inputReader, messageHandler);
+
+        DecodeCounts res;
+        res.total = messageHandler.total();
+        res.numLong = messageHandler.numLong();
+        for (int df = 0; df < 32; df++) {
+            res.perDF[df] = messageHandler.perDF(df);
+        }
+        return res;
+    }
+
+    // evaluates all candidates using numThreads worker threads.
+    // The results are in the same order as the candidates.
+    std::vector<DecodeCounts> evaluateBatch(const std::vector<std::vector<float>>& candidates,
+                                            size_t numThreads) const {
+        std::vector<DecodeCounts> results(candidates.size());
+        std::atomic<size_t> next{0};
+
+        auto worker = [&]() {
+            for (size_t i = next++; i < candidates.size(); i = next++) {
+                results[i] = evaluate(candidates[i]);
+            }
+        };
+
+        numThreads = std::max<size_t>(1, std::min(numThreads, candidates.size()));
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < numThreads; t++) {
+            threads.emplace_back(worker);
+        }
+        // the calling thread helps out
+        worker();
+        for (auto& t : threads) {
+            t.join();
+        }
+        return results;
+    }
+
+private:
+    const std::vector<RawType>& m_recording;
+};
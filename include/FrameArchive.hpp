@@ -0,0 +1,598 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bits128.hpp"
+#include "CRC.hpp"
+#include "ModeS.hpp"
+#include "ArchiveCodec.hpp"
+
+// Compact binary archive of the emitted frames. The archive is a directory of
+// segment files, a new segment is started every SegmentSeconds (on the MLAT clock).
+//
+// Segment file layout (little endian):
+//   SegmentHeader
+//   for every block: BlockHeader, stored bytes (compressed with BlockHeader::codec)
+//   BlockIndexEntry[numBlocks]
+//   IcaoIndexEntry[numIcaoEntries], sorted by address and block
+//   Footer
+//
+// A block holds up to BlockFrames frames in columns:
+//   zigzag varint of the MLAT delta to the previous frame (the first to BlockHeader::minMlat)
+//   1 byte RSSI per frame
+//   the frames, 7 or 14 bytes. The first bit of the DF tells which.
+//
+// If stream1090 did not close the segment, the index and the footer are
+// missing. SegmentReader then rebuilds the block index by scanning the blocks.
+namespace FrameArchive {
+
+    static constexpr char SegmentMagic[8] = { 'S', '1', '0', '9', '0', 'A', 'R', 'C' };
+    static constexpr char FooterMagic[8]  = { 'S', '1', '0', '9', '0', 'I', 'D', 'X' };
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t BlockFrames = 4096;
+    static constexpr uint64_t SegmentSeconds = 3600;
+    static constexpr uint64_t TicksPerSecond = 12'000'000;
+    static constexpr const char* FileExtension = ".s1090a";
+
+    struct SegmentHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        // wall clock (unix time in microseconds) at MLAT time 0
+        int64_t epochMicros;
+        uint64_t reserved2;
+    };
+    static_assert(sizeof(SegmentHeader) == 32);
+
+    struct BlockHeader {
+        uint32_t rawSize;
+        uint32_t storedSize;
+        uint32_t numFrames;
+        uint8_t codec;
+        uint8_t reserved[3];
+        uint64_t minMlat;
+        uint64_t maxMlat;
+        // bit df is set if the block has a frame with this downlink format
+        uint32_t dfMask;
+        uint32_t reserved2;
+    };
+    static_assert(sizeof(BlockHeader) == 40);
+
+    struct BlockIndexEntry {
+        // file offset of the BlockHeader
+        uint64_t offset;
+        uint64_t minMlat;
+        uint64_t maxMlat;
+        uint32_t numFrames;
+        uint32_t dfMask;
+    };
+    static_assert(sizeof(BlockIndexEntry) == 32);
+
+    struct IcaoIndexEntry {
+        uint32_t icao;
+        uint32_t block;
+    };
+
+    struct Footer {
+        uint64_t blockIndexOffset;
+        uint64_t icaoIndexOffset;
+        uint32_t numBlocks;
+        uint32_t reserved;
+        uint64_t numIcaoEntries;
+        char magic[8];
+    };
+    static_assert(sizeof(Footer) == 40);
+
+    struct Record {
+        uint64_t mlat;
+        Bits128 frame;
+        uint8_t rssi;
+        bool isLong;
+    };
+
+    inline uint8_t downlinkFormat(const Record& r) {
+        return r.isLong ? uint8_t((r.frame.high() >> 43) & 0x1f) : uint8_t((r.frame.low() >> 51) & 0x1f);
+    }
+
+    // the address in clear (DF11/17/18) or the one overlaid on the parity
+    inline uint32_t address(const Record& r) {
+        const uint8_t df = downlinkFormat(r);
+        if (r.isLong) {
+            if (df == 17 || df == 18)
+                return ModeS::extractICAOWithCA_Long(r.frame) & 0xffffff;
+            return CRC::compute<112>(r.frame);
+        }
+        if (df == 11)
+            return ModeS::extractICAOWithCA_Short(r.frame.low()) & 0xffffff;
+        return CRC::compute<56>(r.frame);
+    }
+
+    namespace detail {
+        inline void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+            while (v >= 0x80) {
+                out.push_back(uint8_t(v) | 0x80);
+                v >>= 7;
+            }
+            out.push_back(uint8_t(v));
+        }
+
+        inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+            v = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (p >= end)
+                    return false;
+                const uint8_t b = *p++;
+                v |= uint64_t(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return true;
+            }
+            return false;
+        }
+
+        inline uint64_t zigzag(int64_t v) {
+            return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+        }
+
+        inline int64_t unzigzag(uint64_t v) {
+            return int64_t(v >> 1) ^ -int64_t(v & 1);
+        }
+
+        inline void putBigEndian(std::vector<uint8_t>& out, uint64_t v, int numBytes) {
+            for (int i = numBytes - 1; i >= 0; i--)
+                out.push_back(uint8_t(v >> (8 * i)));
+        }
+
+        inline uint64_t getBigEndian(const uint8_t* p, int numBytes) {
+            uint64_t v = 0;
+            for (int i = 0; i < numBytes; i++)
+                v = (v << 8) | p[i];
+            return v;
+        }
+    }
+
+    // Encodes the records into the column layout. Fills the header except the sizes and the codec.
+    inline void encodeBlock(const Record* records, size_t n, std::vector<uint8_t>& raw, BlockHeader& header) {
+        using namespace detail;
+        header = BlockHeader{};
+        header.numFrames = uint32_t(n);
+        header.minMlat = UINT64_MAX;
+        for (size_t i = 0; i < n; i++) {
+            header.minMlat = std::min(header.minMlat, records[i].mlat);
+            header.maxMlat = std::max(header.maxMlat, records[i].mlat);
+            header.dfMask |= uint32_t(1) << downlinkFormat(records[i]);
+        }
+
+        raw.clear();
+        uint64_t prev = header.minMlat;
+        for (size_t i = 0; i < n; i++) {
+            putVarint(raw, zigzag(int64_t(records[i].mlat - prev)));
+            prev = records[i].mlat;
+        }
+        for (size_t i = 0; i < n; i++) {
+            raw.push_back(records[i].rssi);
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (records[i].isLong) {
+                putBigEndian(raw, records[i].frame.high(), 6);
+                putBigEndian(raw, records[i].frame.low(), 8);
+            } else {
+                putBigEndian(raw, records[i].frame.low(), 7);
+            }
+        }
+    }
+
+    // Decodes a block in column layout. Returns false if the block is corrupt.
+    inline bool decodeBlock(const uint8_t* raw, size_t size, const BlockHeader& header, std::vector<Record>& out) {
+        using namespace detail;
+        const uint8_t* p = raw;
+        const uint8_t* end = raw + size;
+        const size_t n = header.numFrames;
+
+        out.clear();
+        uint64_t mlat = header.minMlat;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t v;
+            if (!getVarint(p, end, v))
+                return false;
+            mlat += uint64_t(unzigzag(v));
+            out.push_back(Record{ mlat, Bits128(), 0, false });
+        }
+
+        if (size_t(end - p) < n)
+            return false;
+        for (size_t i = 0; i < n; i++) {
+            out[i].rssi = *p++;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            if (p >= end)
+                return false;
+            // DF 16 and above are long frames
+            const bool isLong = (*p & 0x80) != 0;
+            const size_t len = isLong ? 14 : 7;
+            if (size_t(end - p) < len)
+                return false;
+            out[i].isLong = isLong;
+            out[i].frame = isLong ? Bits128(getBigEndian(p, 6), getBigEndian(p + 6, 8))
+                                  : Bits128(getBigEndian(p, 7));
+            p += len;
+        }
+        return p == end;
+    }
+
+    // Writes one segment file. Not thread safe, see Writer.
+    class SegmentWriter {
+    public:
+        bool open(const std::string& path, int64_t epochMicros) {
+            m_out.open(path, std::ios::binary | std::ios::trunc);
+            if (!m_out.is_open())
+                return false;
+
+            SegmentHeader header{};
+            std::memcpy(header.magic, SegmentMagic, sizeof(SegmentMagic));
+            header.version = Version;
+            header.epochMicros = epochMicros;
+            m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            m_offset = sizeof(header);
+            m_blocks.clear();
+            m_icaoIndex.clear();
+            return m_out.good();
+        }
+
+        bool isOpen() const noexcept {
+            return m_out.is_open();
+        }
+
+        size_t numBlocks() const noexcept {
+            return m_blocks.size();
+        }
+
+        uint64_t firstMlat() const noexcept {
+            return m_blocks.empty() ? 0 : m_blocks.front().minMlat;
+        }
+
+        void writeBlock(const Record* records, size_t n, ArchiveCodec::Codec codec) {
+            BlockHeader header;
+            encodeBlock(records, n, m_raw, header);
+            header.rawSize = uint32_t(m_raw.size());
+
+            const uint8_t* stored = m_raw.data();
+            header.codec = ArchiveCodec::None;
+            header.storedSize = header.rawSize;
+            if (codec == ArchiveCodec::LZ) {
+                m_compressed.clear();
+                ArchiveCodec::compress(m_raw.data(), m_raw.size(), m_compressed);
+                // keep the raw block if compression does not pay off
+                if (m_compressed.size() < m_raw.size()) {
+                    header.codec = ArchiveCodec::LZ;
+                    header.storedSize = uint32_t(m_compressed.size());
+                    stored = m_compressed.data();
+                }
+            }
+
+            const uint32_t blockIndex = uint32_t(m_blocks.size());
+            m_blocks.push_back(BlockIndexEntry{ m_offset, header.minMlat, header.maxMlat, header.numFrames, header.dfMask });
+
+            m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            m_out.write(reinterpret_cast<const char*>(stored), header.storedSize);
+            m_out.flush();
+            m_offset += sizeof(header) + header.storedSize;
+
+            // every address once per block
+            m_addresses.clear();
+            for (size_t i = 0; i < n; i++) {
+                m_addresses.push_back(address(records[i]));
+            }
+            std::sort(m_addresses.begin(), m_addresses.end());
+            m_addresses.erase(std::unique(m_addresses.begin(), m_addresses.end()), m_addresses.end());
+            for (uint32_t icao : m_addresses) {
+                m_icaoIndex.push_back(IcaoIndexEntry{ icao, blockIndex });
+            }
+        }
+
+        // writes the index and the footer
+        void close() {
+            if (!m_out.is_open())
+                return;
+
+            std::sort(m_icaoIndex.begin(), m_icaoIndex.end(), [](const auto& a, const auto& b) {
+                return (a.icao != b.icao) ? (a.icao < b.icao) : (a.block < b.block);
+            });
+
+            Footer footer{};
+            footer.blockIndexOffset = m_offset;
+            footer.numBlocks = uint32_t(m_blocks.size());
+            m_out.write(reinterpret_cast<const char*>(m_blocks.data()), m_blocks.size() * sizeof(BlockIndexEntry));
+            footer.icaoIndexOffset = m_offset + m_blocks.size() * sizeof(BlockIndexEntry);
+            footer.numIcaoEntries = m_icaoIndex.size();
+            m_out.write(reinterpret_cast<const char*>(m_icaoIndex.data()), m_icaoIndex.size() * sizeof(IcaoIndexEntry));
+            std::memcpy(footer.magic, FooterMagic, sizeof(FooterMagic));
+            m_out.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+            m_out.close();
+        }
+
+    private:
+        std::ofstream m_out;
+        uint64_t m_offset = 0;
+        std::vector<BlockIndexEntry> m_blocks;
+        std::vector<IcaoIndexEntry> m_icaoIndex;
+        std::vector<uint8_t> m_raw;
+        std::vector<uint8_t> m_compressed;
+        std::vector<uint32_t> m_addresses;
+    };
+
+    // The archive sink of stream1090. push is called for every frame and only
+    // appends to the current block. Full blocks are handed over to a thread
+    // that encodes, compresses and writes them.
+    class Writer {
+    public:
+        ~Writer() {
+            close();
+        }
+
+        bool open(const std::string& directory, ArchiveCodec::Codec codec = ArchiveCodec::LZ) {
+            std::error_code ec;
+            std::filesystem::create_directories(directory, ec);
+            if (!std::filesystem::is_directory(directory))
+                return false;
+
+            m_directory = directory;
+            m_codec = codec;
+            m_current.reserve(BlockFrames);
+            m_stop = false;
+            m_thread = std::thread([this] { loop(); });
+            return true;
+        }
+
+        bool isOpen() const noexcept {
+            return m_thread.joinable();
+        }
+
+        void push(uint64_t mlat, const Bits128& frame, uint8_t rssi, bool isLong) {
+            if (m_epochMicros == INT64_MIN) {
+                // the wall clock at MLAT 0, assuming that the stream is live
+                const int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                m_epochMicros = now - int64_t(mlat / 12);
+            }
+
+            m_current.push_back(Record{ mlat, frame, rssi, isLong });
+            if (m_current.size() == BlockFrames)
+                handOver();
+        }
+
+        // writes the last block, closes the segment and stops the thread
+        void close() {
+            if (!m_thread.joinable())
+                return;
+            if (!m_current.empty())
+                handOver();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_condVar.notify_one();
+            m_thread.join();
+        }
+
+    private:
+        struct Full {
+            std::vector<Record> records;
+            int64_t epochMicros;
+        };
+
+        void handOver() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_full.push_back(Full{ std::move(m_current), m_epochMicros });
+                // reuse a buffer the writer thread is done with
+                if (!m_free.empty()) {
+                    m_current = std::move(m_free.back());
+                    m_free.pop_back();
+                } else {
+                    m_current = std::vector<Record>();
+                }
+            }
+            m_current.clear();
+            m_current.reserve(BlockFrames);
+            m_condVar.notify_one();
+        }
+
+        void loop() {
+            SegmentWriter segment;
+            for (;;) {
+                Full full;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condVar.wait(lock, [&] { return m_stop || !m_full.empty(); });
+                    if (m_full.empty())
+                        break;
+                    full = std::move(m_full.front());
+                    m_full.pop_front();
+                }
+
+                const auto& records = full.records;
+                const uint64_t mlat = records.front().mlat;
+                if (segment.isOpen() && mlat > segment.firstMlat() + SegmentSeconds * TicksPerSecond) {
+                    segment.close();
+                }
+                if (!segment.isOpen() && !segment.open(nextPath(full.epochMicros, mlat), full.epochMicros)) {
+                    std::cerr << "[Stream1090] Cannot write archive segment in " << m_directory << std::endl;
+                } else {
+                    segment.writeBlock(records.data(), records.size(), m_codec);
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_free.push_back(std::move(full.records));
+            }
+            segment.close();
+        }
+
+        // segments are named after the wall clock of their first frame
+        std::string nextPath(int64_t epochMicros, uint64_t mlat) const {
+            const std::time_t t = std::time_t((epochMicros + int64_t(mlat / 12)) / 1'000'000);
+            std::tm tm{};
+            gmtime_r(&t, &tm);
+            char name[64];
+            std::strftime(name, sizeof(name), "stream1090_%Y%m%d_%H%M%S", &tm);
+
+            std::filesystem::path path = std::filesystem::path(m_directory) / (std::string(name) + FileExtension);
+            for (int i = 1; std::filesystem::exists(path); i++) {
+                path = std::filesystem::path(m_directory) / (std::string(name) + "_" + std::to_string(i) + FileExtension);
+            }
+            return path.string();
+        }
+
+        std::string m_directory;
+        ArchiveCodec::Codec m_codec = ArchiveCodec::LZ;
+        int64_t m_epochMicros = INT64_MIN;
+
+        // only used by the thread calling push
+        std::vector<Record> m_current;
+
+        // shared with the writer thread
+        std::mutex m_mutex;
+        std::condition_variable m_condVar;
+        std::deque<Full> m_full;
+        std::vector<std::vector<Record>> m_free;
+        bool m_stop = false;
+
+        std::thread m_thread;
+    };
+
+    // Reads a segment file. Loads the index, the blocks are read on demand.
+    class SegmentReader {
+    public:
+        bool open(const std::string& path) {
+            m_in.open(path, std::ios::binary | std::ios::ate);
+            if (!m_in.is_open())
+                return false;
+            m_fileSize = uint64_t(m_in.tellg());
+            m_in.seekg(0);
+
+            if (!m_in.read(reinterpret_cast<char*>(&m_header), sizeof(m_header))
+                || std::memcmp(m_header.magic, SegmentMagic, sizeof(SegmentMagic)) != 0
+                || m_header.version != Version)
+                return false;
+
+            m_blocks.clear();
+            m_icaoIndex.clear();
+            m_hasIcaoIndex = readIndex();
+            if (!m_hasIcaoIndex)
+                scanBlocks();
+            return true;
+        }
+
+        const SegmentHeader& header() const noexcept { return m_header; }
+        const std::vector<BlockIndexEntry>& blocks() const noexcept { return m_blocks; }
+
+        // false if the segment was not closed properly. Then every block may contain every address.
+        bool hasIcaoIndex() const noexcept { return m_hasIcaoIndex; }
+
+        // the blocks that contain frames of icao, ascending
+        std::vector<uint32_t> blocksOf(uint32_t icao) const {
+            std::vector<uint32_t> result;
+            auto it = std::lower_bound(m_icaoIndex.begin(), m_icaoIndex.end(), icao,
+                [](const IcaoIndexEntry& e, uint32_t v) { return e.icao < v; });
+            for (; it != m_icaoIndex.end() && it->icao == icao; ++it) {
+                result.push_back(it->block);
+            }
+            return result;
+        }
+
+        // reads and decodes block i
+        bool readBlock(size_t i, std::vector<Record>& out) {
+            BlockHeader header;
+            m_in.clear();
+            m_in.seekg(std::streamoff(m_blocks[i].offset));
+            if (!m_in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+                return false;
+
+            m_stored.resize(header.storedSize);
+            if (!m_in.read(reinterpret_cast<char*>(m_stored.data()), header.storedSize))
+                return false;
+
+            if (header.codec == ArchiveCodec::None)
+                return decodeBlock(m_stored.data(), m_stored.size(), header, out);
+
+            m_raw.resize(header.rawSize);
+            if (header.codec != ArchiveCodec::LZ
+                || !ArchiveCodec::decompress(m_stored.data(), m_stored.size(), m_raw.data(), m_raw.size()))
+                return false;
+            return decodeBlock(m_raw.data(), m_raw.size(), header, out);
+        }
+
+    private:
+        bool readIndex() {
+            if (m_fileSize < sizeof(SegmentHeader) + sizeof(Footer))
+                return false;
+
+            Footer footer;
+            m_in.seekg(std::streamoff(m_fileSize - sizeof(Footer)));
+            if (!m_in.read(reinterpret_cast<char*>(&footer), sizeof(footer))
+                || std::memcmp(footer.magic, FooterMagic, sizeof(FooterMagic)) != 0)
+                return false;
+
+            if (footer.blockIndexOffset + uint64_t(footer.numBlocks) * sizeof(BlockIndexEntry) > m_fileSize
+                || footer.icaoIndexOffset + footer.numIcaoEntries * sizeof(IcaoIndexEntry) > m_fileSize)
+                return false;
+
+            m_blocks.resize(footer.numBlocks);
+            m_in.seekg(std::streamoff(footer.blockIndexOffset));
+            m_in.read(reinterpret_cast<char*>(m_blocks.data()), m_blocks.size() * sizeof(BlockIndexEntry));
+
+            m_icaoIndex.resize(footer.numIcaoEntries);
+            m_in.seekg(std::streamoff(footer.icaoIndexOffset));
+            m_in.read(reinterpret_cast<char*>(m_icaoIndex.data()), m_icaoIndex.size() * sizeof(IcaoIndexEntry));
+            return bool(m_in);
+        }
+
+        // walks over the block headers of a segment without index
+        void scanBlocks() {
+            m_blocks.clear();
+            m_in.clear();
+            uint64_t offset = sizeof(SegmentHeader);
+            BlockHeader header;
+            while (offset + sizeof(BlockHeader) <= m_fileSize) {
+                m_in.seekg(std::streamoff(offset));
+                if (!m_in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+                    break;
+                if (offset + sizeof(BlockHeader) + header.storedSize > m_fileSize || header.numFrames > BlockFrames)
+                    break;
+                m_blocks.push_back(BlockIndexEntry{ offset, header.minMlat, header.maxMlat, header.numFrames, header.dfMask });
+                offset += sizeof(BlockHeader) + header.storedSize;
+            }
+            m_in.clear();
+        }
+
+        std::ifstream m_in;
+        uint64_t m_fileSize = 0;
+        SegmentHeader m_header{};
+        std::vector<BlockIndexEntry> m_blocks;
+        std::vector<IcaoIndexEntry> m_icaoIndex;
+        bool m_hasIcaoIndex = false;
+        std::vector<uint8_t> m_stored;
+        std::vector<uint8_t> m_raw;
+    };
+
+} // end of namespace FrameArchive
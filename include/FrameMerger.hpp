@@ -0,0 +1,350 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Global.hpp"
+#include "Bits128.hpp"
+#include "ModeS.hpp"
+#include "AVRWriter.hpp"
+#include "MessageHandler.hpp"
+#include "FrameSinks.hpp"
+
+// A frame as emitted by the demodulator of one receiver
+struct MergedFrame {
+    // MLAT timestamp (12 MHz) on the clock of the receiver
+    uint64_t mlat;
+    // the frame, short frames are in the low part
+    Bits128 frame;
+    uint8_t rssi;
+    bool isLong;
+};
+
+// Merges the frames of several receivers running in the same process into
+// one AVR output. The demodulators push their frames from the DSP threads,
+// run() writes them on the calling thread in the order they arrive.
+//
+// A frame is a duplicate if another receiver emitted the same frame less than
+// the merge window before or after it. The first copy is written immediately,
+// later copies are dropped, so merging adds no latency.
+//
+// The receivers do not share a clock. Every receiver has an offset to the
+// clock of receiver 0, learned from DF17 airborne position frames. These are
+// unique enough to be matched across receivers within one second. The output
+// timestamps are on the clock of receiver 0. At most MaxReceivers receivers.
+class FrameMerger {
+public:
+    static constexpr size_t MaxReceivers = 64;
+    // frames of the same transmission seen by two receivers before they are synced
+    static constexpr int64_t SyncWindowTicks = 12'000'000;
+    // weight of a new measurement of the clock offset
+    static constexpr int64_t OffsetSmoothing = 8;
+
+    struct ReceiverStats {
+        uint64_t numFrames = 0;
+        uint64_t numWritten = 0;
+        uint64_t numDuplicates = 0;
+        bool synced = false;
+        int64_t offset = 0;
+    };
+
+    FrameMerger(size_t numReceivers, uint64_t windowMicros, std::ostream& out)
+        : m_windowTicks(int64_t(windowMicros) * 12),
+          m_writer(out),
+          m_latest(numReceivers, 0),
+          m_finished(numReceivers, false),
+          m_stats(numReceivers)
+    {
+        m_stats[0].synced = true;
+    }
+
+    // called by the DSP thread of receiver
+    void push(size_t receiver, const MergedFrame& frame) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back({ receiver, frame });
+            m_latest[receiver] = frame.mlat;
+        }
+        m_condVar.notify_one();
+    }
+
+    // called when receiver will not push any frames anymore
+    void finish(size_t receiver) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished[receiver] = true;
+        }
+        m_condVar.notify_one();
+    }
+
+    // the merge loop. Returns when all receivers are finished.
+    void run() {
+        using namespace std::chrono_literals;
+        std::vector<Pending> batch;
+        for (;;) {
+            bool done = false;
+            int64_t horizon = 0;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condVar.wait_for(lock, 100ms, [&] {
+                    return !m_pending.empty() || allFinished();
+                });
+                batch.swap(m_pending);
+                done = allFinished();
+                horizon = computeHorizon();
+            }
+
+            for (const auto& p : batch) {
+                merge(p.receiver, p.frame);
+            }
+            batch.clear();
+            expire(horizon);
+
+            if (done)
+                break;
+        }
+    }
+
+    // the written frames are also passed on to the sinks
+    void setSinks(const FrameSinks& sinks) noexcept {
+        m_sinks = sinks;
+    }
+
+    const std::vector<ReceiverStats>& stats() const noexcept {
+        return m_stats;
+    }
+
+private:
+    struct Pending {
+        size_t receiver;
+        MergedFrame frame;
+    };
+
+    struct Key {
+        Bits128 frame;
+        bool isLong;
+
+        bool operator==(const Key& other) const noexcept {
+            return (isLong == other.isLong) && (frame == other.frame);
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const noexcept {
+            return std::hash<uint64_t>()(k.frame.low() ^ (k.frame.high() * 0x9E3779B97F4A7C15ull) ^ uint64_t(k.isLong));
+        }
+    };
+
+    // one transmission of a frame
+    struct Entry {
+        // time of the first copy on the clock of receiver 0
+        int64_t time;
+        // the receivers that have seen this copy
+        uint64_t receivers;
+    };
+
+    void merge(size_t receiver, const MergedFrame& f) {
+        auto& stats = m_stats[receiver];
+        stats.numFrames++;
+
+        const Key key { f.frame, f.isLong };
+        const int64_t t = int64_t(f.mlat) - stats.offset;
+        const uint64_t bit = uint64_t(1) << receiver;
+        const bool syncFrame = isSyncFrame(f);
+
+        // The receivers do not run in lockstep, one may be ahead and already
+        // report a later repetition of the same frame. Hence, we keep all recent
+        // copies and look for the closest one this receiver has not seen yet.
+        auto& copies = m_entries[key];
+        Entry* best = nullptr;
+        size_t numCandidates = 0;
+        for (auto& e : copies) {
+            if (e.receivers & bit)
+                continue;
+            if (std::abs(t - e.time) < SyncWindowTicks)
+                numCandidates++;
+            if (!best || std::abs(t - e.time) < std::abs(t - best->time))
+                best = &e;
+        }
+
+        if (best) {
+            const int64_t delta = t - best->time;
+            // Before a receiver is synced, its clock may be off by up to SyncWindowTicks.
+            // A frame that was transmitted more than once in that time is ambiguous.
+            const size_t other = firstReceiver(best->receivers);
+            const bool initialSync = syncFrame && (m_stats[receiver].synced != m_stats[other].synced)
+                && (numCandidates == 1) && (std::abs(delta) < SyncWindowTicks);
+            const bool bothSynced = m_stats[receiver].synced && m_stats[other].synced;
+            if (initialSync || (bothSynced && std::abs(delta) <= m_windowTicks)) {
+                // same transmission on another receiver, adjust the clocks
+                if (syncFrame)
+                    updateOffset(receiver, other, delta);
+                stats.numDuplicates++;
+                best->receivers |= bit;
+                return;
+            }
+        }
+
+        // a new transmission
+        copies.push_back(Entry{ t, bit });
+        m_expiry.push_back({ t, key });
+        write(f, t);
+        stats.numWritten++;
+    }
+
+    void write(const MergedFrame& f, int64_t t) {
+        const uint64_t ts = uint64_t(std::max<int64_t>(0, t));
+        if constexpr (GlobalOptions::RSSIEnabled) {
+            if (f.isLong)
+                m_writer.write_long_MLAT_RSSI(ts, f.frame, f.rssi);
+            else
+                m_writer.write_short_MLAT_RSSI(ts, f.frame.low(), f.rssi);
+        } else {
+            if (f.isLong)
+                m_writer.write_long_MLAT(ts, f.frame);
+            else
+                m_writer.write_short_MLAT(ts, f.frame.low());
+        }
+
+        m_sinks.handle(ts, f.frame, f.rssi, f.isLong);
+    }
+
+    // DF17/18 airborne position frames. The CPR encoded position changes with
+    // every frame, so two receivers only see the same one for the same transmission
+    static bool isSyncFrame(const MergedFrame& f) noexcept {
+        if (!f.isLong)
+            return false;
+        const uint8_t df = (f.frame.high() >> 43) & 0x1f;
+        if (df != 17 && df != 18)
+            return false;
+        const uint8_t tc = (f.frame.high() >> 11) & 0x1f;
+        return (tc >= 9 && tc <= 22) && (tc != 19);
+    }
+
+    // receiver saw a frame delta ticks later than other
+    void updateOffset(size_t receiver, size_t other, int64_t delta) {
+        // an unsynced receiver is moved to the synced one. Otherwise receiver 0
+        // is the reference and its clock is never moved.
+        size_t toAdjust = receiver;
+        if ((m_stats[receiver].synced && !m_stats[other].synced) || (receiver == 0)) {
+            toAdjust = other;
+            delta = -delta;
+        }
+
+        auto& stats = m_stats[toAdjust];
+        if (!stats.synced) {
+            stats.offset += delta;
+            stats.synced = true;
+            std::cerr << "[Stream1090] Receiver " << toAdjust << " synced to receiver 0 (offset "
+                      << stats.offset / 12 << " us)" << std::endl;
+        } else {
+            stats.offset += delta / OffsetSmoothing;
+        }
+    }
+
+    // drops the copies that can not match anymore
+    void expire(int64_t horizon) {
+        while (!m_expiry.empty() && (m_expiry.front().first + SyncWindowTicks < horizon)) {
+            const auto& [time, key] = m_expiry.front();
+            auto it = m_entries.find(key);
+            if (it != m_entries.end()) {
+                auto& copies = it->second;
+                copies.erase(std::remove_if(copies.begin(), copies.end(),
+                    [&](const Entry& e) { return e.time == time; }), copies.end());
+                if (copies.empty())
+                    m_entries.erase(it);
+            }
+            m_expiry.pop_front();
+        }
+    }
+
+    // the time all running receivers have passed, on the clock of receiver 0
+    int64_t computeHorizon() const noexcept {
+        int64_t horizon = INT64_MAX;
+        bool any = false;
+        for (size_t r = 0; r < m_latest.size(); r++) {
+            if (m_finished[r])
+                continue;
+            horizon = std::min(horizon, int64_t(m_latest[r]) - m_stats[r].offset);
+            any = true;
+        }
+        return any ? horizon : INT64_MAX;
+    }
+
+    bool allFinished() const noexcept {
+        for (bool f : m_finished) {
+            if (!f)
+                return false;
+        }
+        return true;
+    }
+
+    static size_t firstReceiver(uint64_t receivers) noexcept {
+        return size_t(__builtin_ctzll(receivers));
+    }
+
+    const int64_t m_windowTicks;
+    AVRWriter m_writer;
+    FrameSinks m_sinks;
+
+    // shared with the DSP threads
+    std::mutex m_mutex;
+    std::condition_variable m_condVar;
+    std::vector<Pending> m_pending;
+    std::vector<uint64_t> m_latest;
+    std::vector<bool> m_finished;
+
+    // only used by the merge thread
+    std::vector<ReceiverStats> m_stats;
+    std::unordered_map<Key, std::vector<Entry>, KeyHash> m_entries;
+    std::deque<std::pair<int64_t, Key>> m_expiry;
+};
+
+// Message handler of a single receiver that forwards its frames to the merger
+template<typename Sampler, RssiProvider R>
+class MergeMessageHandler {
+public:
+    MergeMessageHandler(FrameMerger& merger, size_t receiver, const R& rssi)
+        : m_merger(merger), m_receiver(receiver), m_rssiProvider(rssi) {}
+
+    void handleShort(uint64_t sampleIndex, const uint64_t frame) {
+        m_merger.push(m_receiver, MergedFrame{ toMlat(sampleIndex), Bits128(frame), rssi(), false });
+    }
+
+    void handleLong(uint64_t sampleIndex, const Bits128& frame) {
+        m_merger.push(m_receiver, MergedFrame{ toMlat(sampleIndex), frame, rssi(), true });
+    }
+
+private:
+    static uint64_t toMlat(uint64_t sampleIndex) {
+        return MLAT::sampleIndexToMlatTime<Sampler::NumStreams>(sampleIndex);
+    }
+
+    uint8_t rssi() const {
+        if constexpr (GlobalOptions::RSSIEnabled) {
+            return m_rssiProvider.getRSSI();
+        } else {
+            return 0;
+        }
+    }
+
+    FrameMerger& m_merger;
+    size_t m_receiver;
+    const R& m_rssiProvider;
+};
@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "Global.hpp"
+#include "Bits128.hpp"
+#include "ModeS.hpp"
+#include "MessageHandler.hpp"
+#include "AircraftTracker.hpp"
+#include "ShmFrameRing.hpp"
+#include "FrameArchive.hpp"
+#include "UdpOutput.hpp"
+
+// The outputs that can be switched off and on while running, see ControlSocket
+class OutputSwitches {
+public:
+    enum Output { Stdout = 0, Aircraft, Ring, Archive, Udp, NumOutputs };
+
+    static constexpr const char* Names[NumOutputs] = { "stdout", "aircraft", "ring", "archive", "udp" };
+
+    OutputSwitches() {
+        for (auto& on : m_on)
+            on.store(true, std::memory_order_relaxed);
+    }
+
+    bool isOn(Output output) const noexcept {
+        return m_on[output].load(std::memory_order_relaxed);
+    }
+
+    void set(Output output, bool on) noexcept {
+        m_on[output].store(on, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<bool>, NumOutputs> m_on;
+};
+
+// counts the emitted frames for a stats snapshot of another thread
+struct FrameCounters {
+    std::atomic<uint64_t> numShort{0};
+    std::atomic<uint64_t> numLong{0};
+    std::array<std::atomic<uint64_t>, 32> numPerDF{};
+
+    void count(const Bits128& frame, bool isLong) noexcept {
+        const uint64_t firstByte = isLong ? (frame.high() >> 40) : (frame.low() >> 48);
+        (isLong ? numLong : numShort).fetch_add(1, std::memory_order_relaxed);
+        numPerDF[(firstByte >> 3) & 31].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// The optional consumers of the emitted frames besides stdout. They are
+// selected at runtime, so adding one does not instantiate the demodulator
+// for yet another handler type. A null pointer means not requested.
+struct FrameSinks {
+    AircraftTracker* tracker = nullptr;
+    ShmFrameRing::Writer* frameRing = nullptr;
+    FrameArchive::Writer* archive = nullptr;
+    UdpOutput::Sender* udp = nullptr;
+    // if set, the outputs above and stdout can be switched off
+    const OutputSwitches* switches = nullptr;
+    FrameCounters* counters = nullptr;
+
+    bool empty() const noexcept {
+        return !tracker && !frameRing && !archive && !udp && !switches && !counters;
+    }
+
+    bool isOn(OutputSwitches::Output output) const noexcept {
+        return !switches || switches->isOn(output);
+    }
+
+    void handle(uint64_t mlat, const Bits128& frame, uint8_t rssi, bool isLong) {
+        if (counters) {
+            counters->count(frame, isLong);
+        }
+
+        if (frameRing && isOn(OutputSwitches::Ring)) {
+            frameRing->push(mlat, frame, rssi, isLong);
+        }
+
+        if (archive && isOn(OutputSwitches::Archive)) {
+            archive->push(mlat, frame, rssi, isLong);
+        }
+
+        if (udp && isOn(OutputSwitches::Udp)) {
+            udp->push(mlat, frame, rssi, isLong);
+        }
+
+        if (tracker && isOn(OutputSwitches::Aircraft)) {
+            if (isLong)
+                tracker->handleLong(mlat, frame);
+            else
+                tracker->handleShort(mlat, frame.low());
+        }
+    }
+};
+
+// Message handler that passes the frames on to Inner and then to the sinks
+template<typename Sampler, MessageHandler Inner, RssiProvider R>
+class SinkMessageHandler {
+public:
+    SinkMessageHandler(Inner& inner, const FrameSinks& sinks, const R& rssi)
+        : m_inner(inner), m_sinks(sinks), m_rssiProvider(rssi) {}
+
+    void handleShort(uint64_t sampleIndex, const uint64_t frame) {
+        if (m_sinks.isOn(OutputSwitches::Stdout))
+            m_inner.handleShort(sampleIndex, frame);
+        m_sinks.handle(toMlat(sampleIndex), Bits128(frame), rssi(), false);
+    }
+
+    void handleLong(uint64_t sampleIndex, const Bits128& frame) {
+        if (m_sinks.isOn(OutputSwitches::Stdout))
+            m_inner.handleLong(sampleIndex, frame);
+        m_sinks.handle(toMlat(sampleIndex), frame, rssi(), true);
+    }
+
+private:
+    static uint64_t toMlat(uint64_t sampleIndex) {
+        return MLAT::sampleIndexToMlatTime<Sampler::NumStreams>(sampleIndex);
+    }
+
+    uint8_t rssi() const {
+        if constexpr (GlobalOptions::RSSIEnabled) {
+            return m_rssiProvider.getRSSI();
+        } else {
+            return 0;
+        }
+    }
+
+    Inner& m_inner;
+    FrameSinks m_sinks;
+    const R& m_rssiProvider;
+};
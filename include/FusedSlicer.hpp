@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "CpuDispatch.hpp"
+
+// Resampler and slicer in one step. The slicer only compares an upsampled
+// magnitude with the one NumStreams / 2 samples later. For the linear
+// interpolating samplers every upsampled magnitude is a fixed combination of
+// two neighbouring input magnitudes. So the slicer can compute the magnitudes
+// of a tick right before it compares them, and the upsampled block is never
+// written. Only the last NumStreams / 2 of them are kept for the next tick.
+//
+// The weights are taken from Sampler::sample itself by feeding it unit
+// impulses. Hence, the specialized samplers are covered as well. For samplers
+// based on SamplerFunc the result is bit exact, the weights are l and r and the
+// terms are summed in the same order.
+//
+// The outputs repeat their pattern of input positions and weights every
+// TicksPerGroup ticks. A group consumes InputsPerGroup input magnitudes.
+template<typename Sampler>
+class FusedSlicer {
+public:
+    static constexpr size_t NumStreams  = Sampler::NumStreams;
+    static constexpr size_t RatioInput  = Sampler::RatioInput;
+    static constexpr size_t RatioOutput = Sampler::RatioOutput;
+
+    static constexpr size_t TicksPerGroup   = RatioOutput / std::gcd(NumStreams, RatioOutput);
+    static constexpr size_t OutputsPerGroup = TicksPerGroup * NumStreams;
+    static constexpr size_t InputsPerGroup  = OutputsPerGroup / RatioOutput * RatioInput;
+    static_assert(Sampler::InputBlockGranularity % InputsPerGroup == 0);
+
+    FusedSlicer() {
+        probeSampler();
+        for (size_t y = 0; y < OutputsPerGroup; y++) {
+            m_taps[y] = tapsOf(ptrdiff_t(y));
+        }
+    }
+
+    // Slicer bits of the tick-th tick of a group, in points to the first input
+    // of the group. Same as out[j] > out[j + NumStreams / 2] on the upsampled
+    // block, ticks have to come in order.
+    STREAM1090_FORCE_INLINE void slice(const float* __restrict in, size_t tick, uint32_t* __restrict bits) noexcept {
+        constexpr size_t Half = NumStreams / 2;
+        const Taps* taps = &m_taps[tick * NumStreams];
+        float* next = m_tick + Half;
+        for (size_t k = 0; k < NumStreams; k++) {
+            next[k] = taps[k].w0 * in[taps[k].i] + taps[k].w1 * in[taps[k].i + 1];
+        }
+        for (size_t j = 0; j < NumStreams; j++) {
+            bits[j] = m_tick[j] > m_tick[j + Half];
+        }
+        // the second half is compared again in the next tick
+        std::copy(m_tick + NumStreams, m_tick + NumStreams + Half, m_tick);
+    }
+
+    // The upsampled magnitude at output y, relative to the first output of a
+    // group. input(i) returns the input magnitude at position i relative to the
+    // first input of the group. Both may be negative.
+    template<typename Input>
+    float output(ptrdiff_t y, const Input& input) const noexcept {
+        const Taps taps = tapsOf(y);
+        return taps.w0 * input(taps.i) + taps.w1 * input(taps.i + 1);
+    }
+
+private:
+    // out = w0 * in[i] + w1 * in[i + 1]
+    struct Taps {
+        int32_t i = 0;
+        float w0 = 0.0f;
+        float w1 = 0.0f;
+    };
+
+    static ptrdiff_t floorDiv(ptrdiff_t a, ptrdiff_t b) noexcept {
+        return (a >= 0) ? a / b : -((-a + b - 1) / b);
+    }
+
+    Taps tapsOf(ptrdiff_t y) const noexcept {
+        const ptrdiff_t block = floorDiv(y, ptrdiff_t(RatioOutput));
+        Taps taps = m_phases[size_t(y - block * ptrdiff_t(RatioOutput))];
+        taps.i += int32_t(block * ptrdiff_t(RatioInput));
+        return taps;
+    }
+
+    // Runs the sampler on unit impulses to get the weights of the first RatioOutput outputs.
+    // These are all there is, the sampler repeats them every RatioInput inputs.
+    void probeSampler() {
+        constexpr size_t NumInputs = RatioInput + Sampler::InputBufferOverlap;
+        std::vector<float> in(Sampler::InputBufferSize + Sampler::InputBufferOverlap, 0.0f);
+        std::vector<float> out(Sampler::SampleBufferSize, 0.0f);
+        std::array<std::array<float, NumInputs>, RatioOutput> weights{};
+        for (size_t q = 0; q < NumInputs; q++) {
+            in[q] = 1.0f;
+            Sampler::sample(in.data(), out.data());
+            in[q] = 0.0f;
+            for (size_t p = 0; p < RatioOutput; p++) {
+                weights[p][q] = out[p];
+            }
+        }
+
+        for (size_t p = 0; p < RatioOutput; p++) {
+            size_t first = NumInputs;
+            size_t last = 0;
+            for (size_t q = 0; q < NumInputs; q++) {
+                if (weights[p][q] != 0.0f) {
+                    first = std::min(first, q);
+                    last = q;
+                }
+            }
+            if (first < NumInputs && last > first + 1) {
+                std::cerr << "[Stream1090] The sampler uses more than two neighbouring inputs per output "
+                          << "and cannot be fused with the slicer" << std::endl;
+                std::abort();
+            }
+            // the pair of inputs has to stay within the ones the sampler reads
+            const size_t i = std::min(first, NumInputs - 2);
+            m_phases[p] = Taps{ int32_t(i), weights[p][i], weights[p][i + 1] };
+        }
+    }
+
+    std::array<Taps, RatioOutput> m_phases;
+    std::array<Taps, OutputsPerGroup> m_taps;
+    // the magnitudes of the current tick, the first half is from the previous one
+    float m_tick[NumStreams + NumStreams / 2] = {};
+};
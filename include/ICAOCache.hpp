@@ -7,14 +7,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
-
-class ICAOTable {
+#include <cstdlib>
+#include "DemodPolicy.hpp"
+#include "SharedTrustView.hpp"
+#include "AddressParityIndex.hpp"
+
+// Table of the addresses seen recently. The time to live and the altitude
+// check are taken from Policy, see DemodPolicy.hpp
+template<typename Policy = DefaultDemodPolicy>
+class ICAOTableT {
 public:
-	static constexpr auto TTL_not_trusted { 10 };
-	static constexpr auto TTL_trusted { 30 };
-	//static constexpr auto ALT_delta_25ft { 80 };
-	static constexpr auto ALT_delta_ft { 2000 };
     // number if bits used for the look up table 
 	static constexpr auto NumBits { 16 };
 
@@ -23,6 +27,12 @@ public:
 
     // lookup mask
     static constexpr uint32_t HashMask{(0x1 << NumBits) - 1};
+
+	// how far the clocks of two receivers sharing a SharedTrustView may be apart
+	static constexpr int64_t SharedClockToleranceMs{ 100 };
+
+	// a new trusted address is repairable after at most this many 1 MHz ticks
+	static constexpr uint32_t ParityIndexRebuildTicks{ 100000 };
   
     // icao address entry
     struct Entry {
@@ -68,7 +78,13 @@ public:
 		}
 	};
 
-	ICAOTable() {
+	// a trusted address and the single bit error that turns it into a crc, see findParityRepair
+	struct ParityRepair {
+		Iterator entry;
+		CRC::fixop_t op;
+	};
+
+	explicit ICAOTableT(const Policy& policy = Policy()) : m_policy(policy) {
 		m_table = std::make_unique<Entry[]>(Size);
 		std::fill(m_table.get(), m_table.get() + Size, Entry{0x0, 0, 0});
 
@@ -77,6 +93,9 @@ public:
 
 		m_msgStatTable = std::make_unique<MsgStatEntry[]>(Size);
 		std::fill(m_msgStatTable.get(), m_msgStatTable.get() + Size, MsgStatEntry{0});
+
+		if (m_policy.AddressParityRepair)
+			m_parityIndex = std::make_unique<AddressParityIndex>();
 	}
 
 	Iterator insertWithCA(uint32_t icaoWithCA) noexcept  {
@@ -86,19 +105,63 @@ public:
 		return Iterator(key);
 	}
 
-	Iterator findWithCA(uint32_t icaoWithCA) const noexcept {
+	Iterator findWithCA(uint32_t icaoWithCA) noexcept {
 		const auto key = icaoWithCA & HashMask; 
-		return (m_table[key].icao == icaoWithCA) ? Iterator(key) : Iterator();
+		if (m_table[key].icao == icaoWithCA)
+			return Iterator(key);
+		return m_shared ? importShared(icaoWithCA, 0xffffffffu) : Iterator();
 	}
 
-	Iterator find(uint32_t icao) const noexcept {
+	Iterator find(uint32_t icao) noexcept {
 		const auto key = icao & HashMask; 
-		return ((m_table[key].icao & 0xffffffu) == icao) ? Iterator(key) : Iterator();
+		if ((m_table[key].icao & 0xffffffu) == icao)
+			return Iterator(key);
+		return m_shared ? importShared(icao, 0xffffffu) : Iterator();
+	}
+
+	// same as find and findWithCA, but without asking the shared view and without changing the table
+	bool contains(uint32_t icao) const noexcept {
+		return (m_table[icao & HashMask].icao & 0xffffffu) == icao;
+	}
+
+	bool containsWithCA(uint32_t icaoWithCA) const noexcept {
+		return m_table[icaoWithCA & HashMask].icao == icaoWithCA;
+	}
+
+	// For a frame with address parity whose crc is not a known address: the trusted
+	// address that explains crc with a single flipped bit, if there is exactly one.
+	// numBits is AddressParityIndex::NumBitsShort or NumBitsLong.
+	ParityRepair findParityRepair(CRC::crc_t crc, int numBits) const noexcept {
+		if (!m_parityIndex)
+			return ParityRepair{};
+
+		const auto match = m_parityIndex->lookup(crc, numBits);
+		if (!match.valid())
+			return ParityRepair{};
+
+		// the index is rebuilt only now and then, the entry may be gone or replaced
+		const Iterator it(match.key);
+		const auto icao = m_table[it.key].icao & 0xffffffu;
+		if (!isTrusted(it) || ((icao ^ AddressParityIndex::Syndromes[match.bit]) != crc))
+			return ParityRepair{};
+
+		return ParityRepair{ it, CRC::encodeFixOp(0x1, match.bit) };
+	}
+
+	// trusted addresses are published to and looked up in the shared view
+	void setSharedTrustView(SharedTrustView* shared) noexcept {
+		m_shared = shared;
 	}
 
 	void tick() noexcept {
 		// the counter will wrap around every second exactly once
 		m_time1Mhz = (m_time1Mhz + 1) % 1000000;
+		if (m_time1Mhz == 0)
+			m_seconds++;
+
+		// once a second to drop the expired addresses, earlier if there is a new one
+		if (m_parityIndex && (m_time1Mhz % ParityIndexRebuildTicks == 0) && (m_parityIndexDirty || m_time1Mhz == 0))
+			rebuildParityIndex();
 		
 		// if the counter has a value greater than number of entries,
 		// we are done here.
@@ -109,13 +172,33 @@ public:
 		doTickForEntry(m_time1Mhz);
 	}
 
+	// Advances the clock by numTicks without any frames, e.g. for a gap between
+	// two recordings. The entries age by the seconds that passed.
+	void skip(uint64_t numTicks) noexcept {
+		const uint64_t numSeconds = numTicks / 1000000;
+		// after this many seconds every entry is gone anyway
+		const uint64_t maxAge = uint64_t(std::max(m_policy.TTL_trusted, m_policy.TTL_not_trusted)) + 1;
+		for (uint64_t s = 0; s < std::min(numSeconds, maxAge); s++) {
+			for (uint32_t index = 0; index < Size; index++)
+				doTickForEntry(uint16_t(index));
+		}
+		m_seconds += uint32_t(numSeconds);
+		m_parityIndexDirty = true;
+		for (uint64_t i = 0; i < numTicks % 1000000; i++)
+			tick();
+	}
+
 	void markAsTrustedSeen(const Iterator& entry) noexcept {
-		m_table[entry.key].ttl_trusted = TTL_trusted;
-		m_table[entry.key].ttl = TTL_not_trusted;
+		if (m_table[entry.key].ttl_trusted == 0)
+			m_parityIndexDirty = true;
+		m_table[entry.key].ttl_trusted = m_policy.TTL_trusted;
+		m_table[entry.key].ttl = m_policy.TTL_not_trusted;
+		if (m_shared)
+			m_shared->publish(m_table[entry.key].icao, millis());
 	}
 
 	void markAsSeen(const Iterator& entry) noexcept {
-		m_table[entry.key].ttl = TTL_not_trusted;
+		m_table[entry.key].ttl = m_policy.TTL_not_trusted;
 	}
 
 	bool isTrusted(const Iterator& entry) const noexcept {
@@ -150,7 +233,7 @@ public:
 		}
 
 		const auto delta = abs((int)m_squawkAlt[entry.key].altitude - (int)newAlt);
-		if ((delta <= ALT_delta_ft)) {
+		if ((delta <= m_policy.ALT_delta_ft)) {
 			m_squawkAlt[entry.key].altitude = newAlt;
 			m_squawkAlt[entry.key].altitude_cnt = 1;
 			return true;
@@ -164,10 +247,63 @@ public:
 		return false;
 	}
 
+	// true if squawk equals the confirmed squawk. Unlike checkSquawk this never changes the entry
+	bool matchesSquawk(const Iterator& entry, uint16_t squawk) const noexcept {
+		const auto& s = m_squawkAlt[entry.key];
+		return (squawk != 0) && (s.squawk_cnt > 0) && (s.squawk == squawk);
+	}
+
+	// true if alt is at most maxDelta feet away from the confirmed altitude, never changes the entry
+	bool matchesAltitude(const Iterator& entry, uint16_t alt, int maxDelta) const noexcept {
+		const auto& s = m_squawkAlt[entry.key];
+		return (alt != 0) && (s.altitude_cnt > 0) && (abs((int)s.altitude - (int)alt) <= maxDelta);
+	}
+
 	MsgStatEntry& getMsgStatEntry(const Iterator& it) noexcept {
 		return m_msgStatTable[it.key];
 	}
 private:
+	// Copies an address trusted by another receiver into this table. Only done if the
+	// slot is free, a live address of our own is never replaced. The view is accepted
+	// if it is not older than an untrusted entry may live on our side. Entries from
+	// the future of our clock are ignored, except for a small tolerance since the
+	// receivers are not started at exactly the same time.
+	Iterator importShared(uint32_t icao, uint32_t mask) noexcept {
+		const auto key = icao & HashMask;
+		if (m_table[key].icao != 0x0)
+			return Iterator();
+
+		uint32_t published;
+		const uint32_t icaoWithCA = m_shared->lookup(icao, published);
+		if ((icaoWithCA == 0x0) || ((icaoWithCA & mask) != icao))
+			return Iterator();
+
+		const int64_t age = int64_t(millis()) - int64_t(published);
+		if ((age < -SharedClockToleranceMs) || (age > int64_t(m_policy.TTL_not_trusted) * 1000))
+			return Iterator();
+
+		m_table[key].icao = icaoWithCA;
+		m_table[key].ttl_trusted = m_policy.TTL_trusted;
+		m_table[key].ttl = m_policy.TTL_not_trusted;
+		m_parityIndexDirty = true;
+		return Iterator(key);
+	}
+
+	// collects the trusted addresses into the index of single bit errors
+	void rebuildParityIndex() noexcept {
+		m_parityIndex->clear();
+		for (uint32_t key = 0; key < Size; key++) {
+			if (isTrusted(Iterator(key)) && !m_parityIndex->add(m_table[key].icao & 0xffffffu, uint16_t(key)))
+				break;
+		}
+		m_parityIndexDirty = false;
+	}
+
+	// our clock in milliseconds
+	uint32_t millis() const noexcept {
+		return m_seconds * 1000 + m_time1Mhz / 1000;
+	}
+
 	void doTickForEntry(uint16_t index) noexcept {
 		auto& entry = m_table[index];
 		if (entry.icao == 0x0)
@@ -194,9 +330,18 @@ private:
 	}
 
 	
+	// the constants in use
+	[[no_unique_address]] Policy m_policy;
+
 	// runs from 0 to 999 999
 	uint32_t m_time1Mhz { 0 };
 
+	// number of full seconds, used to age the entries in the shared view
+	uint32_t m_seconds { 0 };
+
+	// the view shared with the other receivers, if any
+	SharedTrustView* m_shared { nullptr };
+
     // the table with the icao addresses including transponder CA 
 	std::unique_ptr<Entry[]> m_table;
 
@@ -205,4 +350,13 @@ private:
 
 	// the table with the msg timestamps
 	std::unique_ptr<MsgStatEntry[]> m_msgStatTable;
+
+	// single bit errors of the trusted addresses, only if the policy repairs them
+	std::unique_ptr<AddressParityIndex> m_parityIndex;
+
+	// a new address became trusted since the last rebuild
+	bool m_parityIndexDirty { false };
 };
+
+// the table used with the default constants
+using ICAOTable = ICAOTableT<>;
@@ -7,15 +7,26 @@
 
 #pragma once
 
+#include <algorithm>
 #include <tuple>
 #include <cmath>
 #include <utility>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "CpuDispatch.hpp"
 
 
 struct DCRemoval {
     explicit DCRemoval(float alpha = 0.005f)
-        : m_alpha(alpha), m_avg_I(0.0f), m_avg_Q(0.0f)
-    {}
+        : m_avg_I(0.0f), m_avg_Q(0.0f)
+    {
+        setAlpha(alpha);
+    }
 
     void apply(float& I, float& Q) noexcept {
         float dI = I - m_avg_I;
@@ -28,8 +39,29 @@ struct DCRemoval {
         Q = dQ;
     }
 
+    // Same as apply on n pairs, up to rounding. With beta = 1 - alpha the average
+    // before sample j of a group is beta^j * avg plus the sum of alpha * beta^(j-1-k) * x_k
+    // over the samples k < j of the group. The sums do not depend on avg, only the
+    // average after the group is carried to the next one. Hence the loop-carried
+    // dependency is one multiply-add per group instead of one per sample.
+    STREAM1090_FORCE_INLINE void applyBlock(float* __restrict I, float* __restrict Q, size_t n) noexcept {
+        size_t i = 0;
+        for (; i + GroupSize <= n; i += GroupSize) {
+            m_avg_I = applyGroup(I + i, m_avg_I);
+            m_avg_Q = applyGroup(Q + i, m_avg_Q);
+        }
+        for (; i < n; i++)
+            apply(I[i], Q[i]);
+    }
+
     void setAlpha(float alpha) noexcept {
         m_alpha = alpha;
+        const double beta = 1.0 - double(alpha);
+        for (size_t j = 0; j <= GroupSize; j++)
+            m_betaPow[j] = float(std::pow(beta, double(j)));
+        for (size_t k = 0; k < GroupSize; k++)
+            for (size_t j = 0; j <= GroupSize; j++)
+                m_weights[k][j] = (j > k) ? float(double(alpha) * std::pow(beta, double(j - 1 - k))) : 0.0f;
     }
 
     std::string toString() const { 
@@ -38,9 +70,30 @@ struct DCRemoval {
         return oss.str(); 
     }
 private:
+    // samples of one channel whose averages are computed at once
+    static constexpr size_t GroupSize = 8;
+
+    // removes the average from the group x and returns the average after it
+    STREAM1090_FORCE_INLINE float applyGroup(float* __restrict x, float avg) const noexcept {
+        // entry j is the average before sample j, the last one after the group
+        float sum[GroupSize + 1];
+        for (size_t j = 0; j <= GroupSize; j++)
+            sum[j] = m_betaPow[j] * avg;
+        for (size_t k = 0; k < GroupSize; k++)
+            for (size_t j = 0; j <= GroupSize; j++)
+                sum[j] += m_weights[k][j] * x[k];
+        for (size_t j = 0; j < GroupSize; j++)
+            x[j] -= sum[j];
+        return sum[GroupSize];
+    }
+
     float m_alpha;
     float m_avg_I;
     float m_avg_Q;
+    // powers of 1 - alpha
+    float m_betaPow[GroupSize + 1];
+    // the weight of sample k of a group in the average before sample j
+    float m_weights[GroupSize][GroupSize + 1];
 };
 
 
@@ -55,6 +108,18 @@ struct FlipSigns {
         m_flip = !m_flip;
     }
 
+    // same as apply on n pairs
+    STREAM1090_FORCE_INLINE void applyBlock(float* __restrict I, float* __restrict Q, size_t n) noexcept {
+        const float first = m_flip ? -1.0f : 1.0f;
+        for (size_t i = 0; i < n; i++) {
+            const float sign = (i & 0x1) ? -first : first;
+            I[i] *= sign;
+            Q[i] *= sign;
+        }
+        if (n & 0x1)
+            m_flip = !m_flip;
+    }
+
     std::string toString() const { 
         return "[FlipSigns] enabled"; 
     }
@@ -63,24 +128,68 @@ private:
 };
 
 
+namespace detail {
+    // the pairs a stage wants to process at once, e.g. an FFT needs more than the others
+    template<typename Stage>
+    constexpr size_t preferredBlockSize() {
+        if constexpr (requires { Stage::PreferredBlockSize; })
+            return Stage::PreferredBlockSize;
+        else
+            return 256;
+    }
+
+    // the pairs a stage takes per pair it hands on, see HalfBandDecimator
+    template<typename Stage>
+    constexpr size_t decimation() {
+        if constexpr (requires { Stage::Decimation; })
+            return Stage::Decimation;
+        else
+            return 1;
+    }
+}
+
 template<typename... Stages>
 class IQPipeline {
 public:
+    // pairs handed to processBlock at once, the most any stage asks for, see InputReaderBase
+    static constexpr size_t BlockSize = std::max({ size_t(256), detail::preferredBlockSize<Stages>()... });
+
+    // raw pairs per magnitude, the product of the decimating stages
+    static constexpr size_t Decimation = (size_t(1) * ... * detail::decimation<Stages>());
+    static_assert(BlockSize % Decimation == 0);
+
     IQPipeline(Stages... stages)
         : m_stages(std::move(stages)...)
     {}
 
-    float process(float I, float Q) noexcept {
+    STREAM1090_FORCE_INLINE float process(float I, float Q) noexcept {
         // run IQ through the stages
         applyStages(I, Q, std::index_sequence_for<Stages...>{});
         // and compute the magnitude
         return std::sqrt(I * I + Q * Q);
     }
 
+    // Same as process on n pairs in I and Q, which are overwritten. The stages run
+    // one after the other on the whole block, those with applyBlock at once, the
+    // others pair by pair. Keep n small enough for I, Q and out to stay in the L1 cache.
+    // With decimating stages n is a multiple of Decimation and there are n / Decimation
+    // magnitudes, process is not available then.
+    STREAM1090_FORCE_INLINE void processBlock(float* __restrict I, float* __restrict Q,
+                                              float* __restrict out, size_t n) noexcept {
+        n = applyStagesBlock(I, Q, n, std::index_sequence_for<Stages...>{});
+        for (size_t i = 0; i < n; i++)
+            out[i] = std::sqrt(I[i] * I[i] + Q[i] * Q[i]);
+    }
+
     std::string toString() const {
         return toStringImpl(std::index_sequence_for<Stages...>{});
     }
 
+    // new taps for the stages with runtime taps, false if there is none or they were rejected
+    bool setTaps(const std::vector<float>& taps) {
+        return setTapsImpl(taps, std::index_sequence_for<Stages...>{});
+    }
+
 private:
     // the different stages of the IQ pair pipeline 
     // in the order how they are being executed on each pair
@@ -93,6 +202,37 @@ private:
         (std::get<Is>(m_stages).apply(I, Q), ...);
     }
 
+    // returns the number of pairs left after the decimating stages
+    template<std::size_t... Is>
+    STREAM1090_FORCE_INLINE size_t applyStagesBlock([[maybe_unused]] float* __restrict I, [[maybe_unused]] float* __restrict Q,
+                                                    size_t n, std::index_sequence<Is...>) noexcept {
+        ((n = applyStageBlock(std::get<Is>(m_stages), I, Q, n)), ...);
+        return n;
+    }
+
+    template<typename Stage>
+    STREAM1090_FORCE_INLINE static size_t applyStageBlock(Stage& stage, float* __restrict I, float* __restrict Q, size_t n) noexcept {
+        if constexpr (requires { stage.decimateBlock(I, Q, n); }) {
+            return stage.decimateBlock(I, Q, n);
+        } else if constexpr (requires { stage.applyBlock(I, Q, n); }) {
+            stage.applyBlock(I, Q, n);
+        } else {
+            for (size_t i = 0; i < n; i++)
+                stage.apply(I[i], Q[i]);
+        }
+        return n;
+    }
+
+    template<std::size_t... Is>
+    bool setTapsImpl(const std::vector<float>& taps, std::index_sequence<Is...>) {
+        bool res = false;
+        ([&] {
+            if constexpr (requires { std::get<Is>(m_stages).setTaps(taps); })
+                res = std::get<Is>(m_stages).setTaps(taps) || res;
+        }(), ...);
+        return res;
+    }
+
     template<std::size_t... Is>
     std::string toStringImpl(std::index_sequence<Is...>) const {
         std::ostringstream oss;
@@ -101,6 +241,46 @@ private:
     }
 };
 
+// Hands new filter taps from another thread to the thread that runs the
+// pipeline. The pipeline takes them between two blocks, see InputReaderBase.
+class TapsMailbox {
+public:
+    enum class Result { Applied, Rejected, Pending };
+
+    // Waits at most timeout until the pipeline took the taps. Pending if the
+    // stream did not get to it yet, it takes them with the next block.
+    Result post(std::vector<float> taps, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_taps = std::move(taps);
+        const uint64_t seq = ++m_postedSeq;
+        m_pending.store(true, std::memory_order_release);
+        if (!m_cv.wait_for(lock, timeout, [&] { return m_appliedSeq == seq; }))
+            return Result::Pending;
+        return m_accepted ? Result::Applied : Result::Rejected;
+    }
+
+    // called by the thread of the pipeline, cheap if nothing is pending
+    template<typename Pipeline>
+    void deliver(Pipeline& pipeline) {
+        if (!m_pending.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_accepted = pipeline.setTaps(m_taps);
+        m_appliedSeq = m_postedSeq;
+        m_pending.store(false, std::memory_order_relaxed);
+        m_cv.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic<bool> m_pending{false};
+    std::vector<float> m_taps;
+    uint64_t m_postedSeq = 0;
+    uint64_t m_appliedSeq = 0;
+    bool m_accepted = false;
+};
+
 // makes constructing a custom pipeline quite easy
 template<typename... Stages>
 auto make_pipeline(Stages&&... stages) {
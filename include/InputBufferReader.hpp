@@ -7,25 +7,47 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "InputReaderBase.hpp"
 #include "RingBuffer.hpp"
+#include "StreamGaps.hpp"
 
+// Reads from the ring buffer the device writes to. A block of the ring buffer
+// holds BufferBlockSize raw values, the blocks asked for are a multiple of it.
 template<typename RawFormat, size_t BufferBlockSize, size_t NumBufferBlocks, typename Pipeline>
-class InputBufferReader : public InputReaderBase<RawFormat, BufferBlockSize / 2, Pipeline> {
+class InputBufferReader : public InputReaderBase<RawFormat, Pipeline> {
 public:
     using RawType       = typename RawFormat::RawType;
     using RingBufferType = RingBufferAsync<RawType, BufferBlockSize, NumBufferBlocks>;
     using AsyncReader    = typename RingBufferType::Reader;
+    using Base           = InputReaderBase<RawFormat, Pipeline>;
+    static constexpr size_t SamplesPerBufferBlock = BufferBlockSize / Base::ValuesPerSample;
+    static_assert(BufferBlockSize % Base::ValuesPerSample == 0);
 
     InputBufferReader(Pipeline& pipeline, RingBufferType& ringBuffer)
-        : InputReaderBase<RawFormat, BufferBlockSize / 2, Pipeline>(pipeline),
+        : InputReaderBase<RawFormat, Pipeline>(pipeline),
           m_reader(ringBuffer)
     { }
 
-    inline void readMagnitude(float* out) {
-        m_reader.process([&](const RawType* buffer) {
-            this->processBlock(buffer, out);
-        });
+    // numSamples is a multiple of SamplesPerBufferBlock. Waits for the device until
+    // there are enough, the rest is zero if the stream ends before.
+    inline void readMagnitude(float* out, size_t numSamples) {
+        size_t remaining = numSamples / SamplesPerBufferBlock;
+        while (remaining > 0 && !eof()) {
+            const size_t n = m_reader.process(remaining, [&](const RawType* buffer, size_t numBlocks) {
+                this->processBlock(buffer, out, numBlocks * SamplesPerBufferBlock);
+            });
+            out += n * SamplesPerBufferBlock;
+            remaining -= n;
+        }
+        std::fill(out, out + remaining * SamplesPerBufferBlock, 0.0f);
+        m_position += numSamples;
+    }
+
+    // the number of input samples read so far
+    uint64_t position() const noexcept {
+        return m_position;
     }
 
     bool eof() { 
@@ -34,5 +56,27 @@ public:
 
 private:
     AsyncReader m_reader;
+    uint64_t m_position = 0;
+};
+
+// An InputBufferReader that passes the gaps in the stream on to the sample
+// stream, see StreamGaps.
+template<typename RawFormat, size_t BufferBlockSize, size_t NumBufferBlocks, typename Pipeline>
+class InputBufferGapReader : public InputBufferReader<RawFormat, BufferBlockSize, NumBufferBlocks, Pipeline> {
+public:
+    using Base = InputBufferReader<RawFormat, BufferBlockSize, NumBufferBlocks, Pipeline>;
+
+    InputBufferGapReader(Pipeline& pipeline, typename Base::RingBufferType& ringBuffer, StreamGaps& gaps)
+        : Base(pipeline, ringBuffer),
+          m_gaps(gaps)
+    { }
+
+    // the input samples missing before the next block, usually 0
+    uint64_t takeGap() {
+        return m_gaps.take(this->position());
+    }
+
+private:
+    StreamGaps& m_gaps;
 };
 
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include "Global.hpp"
+#include "InputReaderBase.hpp"
+
+// Input reader working on a recording that is already in memory.
+// The recording is not copied. Full blocks are converted directly from
+// the given buffer, only the last partial block is padded with zeros.
+// Several readers may share the same buffer, which is what the batch
+// evaluation tools are doing.
+template<typename RawFormat, size_t InputBufferSize, typename Pipeline>
+class InputMemoryReader : public InputReaderBase<RawFormat, Pipeline> {
+public:
+    using RawType = typename RawFormat::RawType;
+    using Base    = InputReaderBase<RawFormat, Pipeline>;
+
+    // numValues is the number of raw values, i.e., twice the number of IQ pairs
+    InputMemoryReader(Pipeline& pipeline, const RawType* data, size_t numValues)
+        : InputReaderBase<RawFormat, Pipeline>(pipeline),
+          m_data(data),
+          m_numValues(numValues),
+          m_pos(0)
+    { }
+
+    // numSamples is at most InputBufferSize
+    inline void readMagnitude(float* out, size_t numSamples) {
+        const size_t NumValuesToRead = Base::ValuesPerSample * numSamples;
+        const size_t remaining = m_numValues - m_pos;
+
+        if (remaining >= NumValuesToRead) {
+            this->processBlock(m_data + m_pos, out, numSamples);
+            m_pos += NumValuesToRead;
+            m_eof = (m_pos == m_numValues);
+            return;
+        }
+
+        // last block, pad the remaining values with zeros
+        if (!m_tail) {
+            m_tail = std::make_unique<RawType[]>(Base::ValuesPerSample * InputBufferSize);
+        }
+        std::fill(m_tail.get(), m_tail.get() + NumValuesToRead, RawType(0));
+        std::memcpy(m_tail.get(), m_data + m_pos, remaining * sizeof(RawType));
+        this->processBlock(m_tail.get(), out, numSamples);
+        m_pos = m_numValues;
+        m_eof = true;
+    }
+
+    bool eof() const {
+        return m_eof || ProcessSignals::shutdownRequested();
+    }
+
+private:
+    const RawType* m_data;
+    size_t m_numValues;
+    size_t m_pos;
+    std::unique_ptr<RawType[]> m_tail;
+    bool m_eof = false;
+};
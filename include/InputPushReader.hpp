@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "InputReaderBase.hpp"
+
+// Input reader for samples that are pushed by the caller instead of being
+// pulled from a device or a file, see Stream1090Decoder. The sample stream runs
+// on its own thread and reads as usual. push() hands a buffer over and waits
+// until the reader is done with it, hence it is not copied. Only a partial block
+// at the end of a buffer is copied and completed with the next one.
+template<typename RawFormat, size_t InputBufferSize, typename Pipeline>
+class InputPushReader : public InputReaderBase<RawFormat, Pipeline> {
+public:
+    using RawType = typename RawFormat::RawType;
+    using Base    = InputReaderBase<RawFormat, Pipeline>;
+
+    InputPushReader(Pipeline& pipeline)
+        : InputReaderBase<RawFormat, Pipeline>(pipeline),
+          m_carry(std::make_unique<RawType[]>(Base::ValuesPerSample * InputBufferSize))
+    { }
+
+    // the number of input samples the sample stream reads at once
+    void setBlockSize(size_t numSamples) {
+        m_blockValues = Base::ValuesPerSample * numSamples;
+    }
+
+    // gets every block of magnitudes, only before the sample stream runs
+    void setBlockCallback(std::function<void(const float*, size_t)> callback) {
+        m_blockCallback = std::move(callback);
+    }
+
+    // the number of blocks that were read
+    uint64_t numBlocks() const noexcept {
+        return m_numBlocks.load(std::memory_order_relaxed);
+    }
+
+    // Caller side. numValues is the number of raw values, i.e., twice the number
+    // of IQ pairs. Returns when the reader no longer needs the buffer.
+    void push(const RawType* data, size_t numValues) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_data = data;
+        m_numValues = numValues;
+        m_cv.notify_all();
+        m_cv.wait(lock, [&] { return m_numValues == 0; });
+        m_data = nullptr;
+    }
+
+    // Caller side. No more samples, the reader pads the last block.
+    void finish() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+        m_cv.notify_all();
+    }
+
+    // numSamples is the block size, eof() made sure there is a block
+    inline void readMagnitude(float* out, size_t numSamples) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const size_t NumValuesToRead = Base::ValuesPerSample * numSamples;
+        if (m_numCarry == 0 && m_numValues >= NumValuesToRead) {
+            this->processBlock(m_data, out, numSamples);
+            m_data += NumValuesToRead;
+            m_numValues -= NumValuesToRead;
+        } else {
+            // complete the carry, or pad it with zeros at the end of the stream
+            const size_t n = std::min(NumValuesToRead - m_numCarry, m_numValues);
+            std::memcpy(m_carry.get() + m_numCarry, m_data, n * sizeof(RawType));
+            std::fill(m_carry.get() + m_numCarry + n, m_carry.get() + NumValuesToRead, RawType(0));
+            this->processBlock(m_carry.get(), out, numSamples);
+            m_data += n;
+            m_numValues -= n;
+            m_numCarry = 0;
+            m_padded = m_finished;
+        }
+        m_numBlocks.fetch_add(1, std::memory_order_relaxed);
+        if (m_blockCallback)
+            m_blockCallback(out, numSamples);
+        if (m_numValues == 0)
+            m_cv.notify_all();
+    }
+
+    // Waits until there is a full block or the stream was finished. The end
+    // is padded to a full block, a whole one if it ends exactly at a block,
+    // as the other readers do.
+    bool eof() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            if (m_numCarry + m_numValues >= m_blockValues)
+                return false;
+            if (m_numValues > 0) {
+                // not enough for a block, keep the rest and release the buffer
+                std::memcpy(m_carry.get() + m_numCarry, m_data, m_numValues * sizeof(RawType));
+                m_numCarry += m_numValues;
+                m_numValues = 0;
+                m_cv.notify_all();
+                continue;
+            }
+            if (m_finished)
+                return m_padded;
+            m_cv.wait(lock);
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // the buffer of the caller
+    const RawType* m_data = nullptr;
+    size_t m_numValues = 0;
+    // the start of a block that did not fit into the previous buffer
+    std::unique_ptr<RawType[]> m_carry;
+    size_t m_numCarry = 0;
+    size_t m_blockValues = Base::ValuesPerSample * InputBufferSize;
+    bool m_finished = false;
+    // the last block was delivered
+    bool m_padded = false;
+    std::function<void(const float*, size_t)> m_blockCallback;
+    std::atomic<uint64_t> m_numBlocks{0};
+};
@@ -8,26 +8,73 @@
 #pragma once
 
 #include <stdint.h>
+#include <algorithm>
 #include <string>
+#include <type_traits>
 
-template<typename RawFormat, size_t InputBufferSize, typename Pipeline>
+#include "CpuDispatch.hpp"
+#include "IQPipeline.hpp"
+
+template<typename RawFormat, typename Pipeline>
 class InputReaderBase {
 public:
     using RawType = typename RawFormat::RawType;
 
+    // raw values per magnitude, an IQ pair unless the pipeline decimates
+    static constexpr size_t Decimation = std::remove_cvref_t<Pipeline>::Decimation;
+    static constexpr size_t ValuesPerSample = 2 * Decimation;
+
     InputReaderBase(Pipeline& pipeline) noexcept
         : m_pipeline(pipeline) {}
 
+    // new taps for the pipeline may arrive here, e.g. from the control socket
+    void setTapsMailbox(TapsMailbox* mailbox) noexcept {
+        m_tapsMailbox = mailbox;
+    }
+
+    // converts n * Decimation raw IQ pairs to n magnitudes, see CpuDispatch for the variants
     inline void processBlock(const RawType* __restrict in,
-                             float* __restrict out) noexcept {
-        constexpr size_t N = InputBufferSize;
-        for (size_t i = 0; i < N; ++i) {
-            float I = RawFormat::convertScalar(*in++);
-            float Q = RawFormat::convertScalar(*in++);
-            *out++ = m_pipeline.process(I, Q);
+                             float* __restrict out, size_t n) noexcept {
+        if (m_tapsMailbox) {
+            m_tapsMailbox->deliver(m_pipeline);
+        }
+        switch (CpuDispatch::selected()) {
+            case CpuDispatch::Isa::AVX512: processBlockAVX512(in, out, n); break;
+            case CpuDispatch::Isa::AVX2:   processBlockAVX2(in, out, n);   break;
+            default:                       processBlockLoop(in, out, n);   break;
         }
     }
 
 private:
+    STREAM1090_TARGET_AVX2 void processBlockAVX2(const RawType* __restrict in, float* __restrict out, size_t n) noexcept {
+        processBlockLoop(in, out, n);
+    }
+
+    STREAM1090_TARGET_AVX512 void processBlockAVX512(const RawType* __restrict in, float* __restrict out, size_t n) noexcept {
+        processBlockLoop(in, out, n);
+    }
+
+    // pairs that are converted and run through the pipeline at once
+    static constexpr size_t ChunkSize = std::remove_cvref_t<Pipeline>::BlockSize;
+
+    STREAM1090_FORCE_INLINE void processBlockLoop(const RawType* __restrict in,
+                                                  float* __restrict out, size_t n) noexcept {
+        // the pipeline takes I and Q in separate arrays, see IQPipeline::processBlock
+        alignas(64) float I[ChunkSize];
+        alignas(64) float Q[ChunkSize];
+        const size_t numPairs = n * Decimation;
+        for (size_t pos = 0; pos < numPairs; pos += ChunkSize) {
+            const size_t m = std::min(ChunkSize, numPairs - pos);
+            for (size_t i = 0; i < m; ++i) {
+                I[i] = RawFormat::convertScalar(in[2 * i]);
+                Q[i] = RawFormat::convertScalar(in[2 * i + 1]);
+            }
+            in += 2 * m;
+            m_pipeline.processBlock(I, Q, out, m);
+            out += m / Decimation;
+        }
+    }
+
     Pipeline& m_pipeline;
+    TapsMailbox* m_tapsMailbox = nullptr;
 };
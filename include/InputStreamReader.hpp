@@ -9,23 +9,24 @@
 
 #include "InputReaderBase.hpp"
 template<typename RawFormat, size_t InputBufferSize, typename Pipeline>
-class InputStdStreamReader : public InputReaderBase<RawFormat, InputBufferSize, Pipeline> {
+class InputStdStreamReader : public InputReaderBase<RawFormat, Pipeline> {
 public:
     using RawType = typename RawFormat::RawType;
+    using Base    = InputReaderBase<RawFormat, Pipeline>;
 
     InputStdStreamReader(Pipeline& pipeline, std::istream& stream)
-        : InputReaderBase<RawFormat, InputBufferSize, Pipeline>(pipeline),
+        : InputReaderBase<RawFormat, Pipeline>(pipeline),
           m_stream(stream)
     {
-        constexpr size_t NumValuesToRead = 2 * InputBufferSize;
+        constexpr size_t NumValuesToRead = Base::ValuesPerSample * InputBufferSize;
         m_buffer = std::make_unique<RawType[]>(NumValuesToRead);
         std::fill(m_buffer.get(), m_buffer.get() + NumValuesToRead, RawType(0));
     }
 
-    inline void readMagnitude(float* out) {
-        constexpr size_t N = InputBufferSize;
-        constexpr size_t NumValuesToRead = 2 * N;
-        constexpr size_t NumBytesToRead  = NumValuesToRead * sizeof(RawType);
+    // numSamples is at most InputBufferSize
+    inline void readMagnitude(float* out, size_t numSamples) {
+        const size_t NumValuesToRead = Base::ValuesPerSample * numSamples;
+        const size_t NumBytesToRead  = NumValuesToRead * sizeof(RawType);
 
         m_stream.read(reinterpret_cast<char*>(m_buffer.get()), NumBytesToRead);
         std::streamsize bytesRead = m_stream.gcount();
@@ -37,7 +38,7 @@ public:
             m_eof = true;
         }
 
-        this->processBlock(m_buffer.get(), out);
+        this->processBlock(m_buffer.get(), out, numSamples);
     }
 
     bool eof() const {
@@ -6,12 +6,100 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <numeric>
 #include <array>
 #include <cstddef>
 #include <bit>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
 #include "Sampler.hpp"
 #include "CustomFilterTaps.hpp"
+#include "CpuDispatch.hpp"
+#include "FFTConvolver.hpp"
+
+// Runs a FIR on a block of I and Q values at once, for the applyBlock of the
+// filters below. The history is copied from the ring buffer of the filter into
+// a linear buffer in front of the block, then each tap is a multiply-add over
+// the whole block, which vectorizes. Afterwards the last samples go back into
+// the ring buffer, so apply and applyBlock can be mixed.
+//
+// Like apply, tap k is multiplied with the sample bufferSize - 1 - k samples
+// before the current one, i.e., the newest one is not used if numTaps < bufferSize.
+// For long filters the convolution itself may be done by an FFTConvolver.
+template<size_t MaxBufferSize>
+class FIRBlock {
+public:
+    // samples filtered at once, the buffers stay in the L2 cache
+    static constexpr size_t BlockSize = 1024;
+
+    // filters n <= BlockSize values of I and Q in place, with fft if it is not null
+    STREAM1090_FORCE_INLINE void filter(const float* __restrict taps, size_t numTaps, bool symmetric,
+                                        size_t bufferSize, float* __restrict delay_I, float* __restrict delay_Q,
+                                        int& newIndex, float* __restrict I, float* __restrict Q, size_t n,
+                                        FFTConvolver* fft = nullptr) noexcept {
+        // the oldest sample of the ring is the one at newIndex, it drops out now
+        const size_t mask = bufferSize - 1;
+        const size_t numHistory = bufferSize - 1;
+        for (size_t t = 0; t < numHistory; t++) {
+            m_x_I[t] = delay_I[(size_t(newIndex) + 1 + t) & mask];
+            m_x_Q[t] = delay_Q[(size_t(newIndex) + 1 + t) & mask];
+        }
+        for (size_t i = 0; i < n; i++) {
+            m_x_I[numHistory + i] = I[i];
+            m_x_Q[numHistory + i] = Q[i];
+        }
+
+        if (fft) {
+            fft->convolve(m_x_I, m_x_Q, I, Q, n);
+        } else {
+            convolve(taps, numTaps, symmetric, m_x_I, I, n);
+            convolve(taps, numTaps, symmetric, m_x_Q, Q, n);
+        }
+
+        // the last bufferSize samples, the oldest one at the new index
+        for (size_t t = 0; t < bufferSize; t++) {
+            delay_I[t] = m_x_I[n - 1 + t];
+            delay_Q[t] = m_x_Q[n - 1 + t];
+        }
+        newIndex = 0;
+    }
+
+private:
+    STREAM1090_FORCE_INLINE static void convolve(const float* __restrict taps, size_t numTaps, bool symmetric,
+                                                 const float* __restrict x, float* __restrict out, size_t n) noexcept {
+        for (size_t i = 0; i < n; i++)
+            out[i] = 0.0f;
+
+        if (symmetric) {
+            const size_t halfNumTaps = numTaps >> 1;
+            if (numTaps & 0x1) {
+                const float center = taps[halfNumTaps];
+                for (size_t i = 0; i < n; i++)
+                    out[i] += center * x[i + halfNumTaps];
+            }
+            for (size_t k = 0; k < halfNumTaps; k++) {
+                const float tap = taps[k];
+                const float* __restrict left = x + k;
+                const float* __restrict right = x + numTaps - 1 - k;
+                for (size_t i = 0; i < n; i++)
+                    out[i] += tap * (left[i] + right[i]);
+            }
+        } else {
+            for (size_t k = 0; k < numTaps; k++) {
+                const float tap = taps[k];
+                for (size_t i = 0; i < n; i++)
+                    out[i] += tap * x[i + k];
+            }
+        }
+    }
+
+    alignas(16) float m_x_I[MaxBufferSize - 1 + BlockSize];
+    alignas(16) float m_x_Q[MaxBufferSize - 1 + BlockSize];
+};
 
 template<SampleRate inputRate, SampleRate outputRate>
 class IQLowPass {
@@ -36,7 +124,7 @@ public:
         return oss.str();
     }
 
-    void apply(float& value_I, float& value_Q) noexcept {
+    STREAM1090_FORCE_INLINE void apply(float& value_I, float& value_Q) noexcept {
         m_delay_I[m_new_index] = value_I;
         m_delay_Q[m_new_index] = value_Q;
 
@@ -57,6 +145,15 @@ public:
         value_Q = sum_Q;
     }
 
+    // same as apply on n pairs, up to rounding
+    STREAM1090_FORCE_INLINE void applyBlock(float* __restrict I, float* __restrict Q, size_t n) noexcept {
+        using Block = FIRBlock<bufferSize>;
+        for (size_t pos = 0; pos < n; pos += Block::BlockSize) {
+            m_block.filter(taps.data(), numTaps, areTapsSymmetric, bufferSize, m_delay_I, m_delay_Q,
+                           m_new_index, I + pos, Q + pos, std::min(Block::BlockSize, n - pos));
+        }
+    }
+
 private:
     void sum_not_sym(float& sum_I, float& sum_Q) const noexcept{
         // index that wraps around the ring buffer
@@ -101,12 +198,24 @@ private:
     alignas(16) float m_delay_I[bufferSize];
     alignas(16) float m_delay_Q[bufferSize];
     int m_new_index;
+    // for applyBlock
+    FIRBlock<bufferSize> m_block;
 };
 
 
-template<size_t MaxNumTaps = 64>
+template<size_t MaxNumTaps = 1024>
 class IQLowPassDynamic {
 public:
+    // how applyBlock convolves, Auto takes the FFT from FFTCrossoverTaps on
+    enum class Engine { Auto, Direct, FFT };
+
+    // From this number of taps on the FFT is faster than the direct form,
+    // measured with tools/fir_bench
+    static constexpr size_t FFTCrossoverTaps = 256;
+
+    // the FFT pays off with longer blocks than the other stages, see IQPipeline::BlockSize
+    static constexpr size_t PreferredBlockSize = 1024;
+
     IQLowPassDynamic() 
         :   m_numTaps(1),
             m_areTapsSymmetric(true),
@@ -138,7 +247,8 @@ public:
 
     std::string toString() const {
         std::ostringstream oss;
-        oss << "[IQLowPassDynamic] tap count: " << m_numTaps << " symmetric: " << m_areTapsSymmetric << "\n";
+        oss << "[IQLowPassDynamic] tap count: " << m_numTaps << " symmetric: " << m_areTapsSymmetric
+            << " engine: " << (m_useFFT ? "fft" : "direct") << "\n";
         oss << "[IQLowPassDynamic] taps: (";
         for (size_t i = 0; i < numTaps(); i++) {
             oss << m_taps[i]; //oss << std::bit_cast<uint32_t>(m_taps[i]);
@@ -182,11 +292,22 @@ public:
                 }
             }
             //printTabs();
+            updateEngine();
             return true;
         }
         return false;
     }
 
+    void setEngine(Engine engine) {
+        m_engine = engine;
+        updateEngine();
+    }
+
+    // if applyBlock currently uses the FFT
+    bool usesFFT() const noexcept {
+        return m_useFFT;
+    }
+
     bool loadFromFile(const std::string& filename) {
         std::ifstream file(filename);
         if (!file.is_open()) {
@@ -242,7 +363,7 @@ public:
     }
 
     // applies the FIR to the I and Q values.
-    void apply(float& value_I, float& value_Q) noexcept {
+    STREAM1090_FORCE_INLINE void apply(float& value_I, float& value_Q) noexcept {
         m_delay_I[m_new_index] = value_I;
         m_delay_Q[m_new_index] = value_Q;
 
@@ -263,7 +384,22 @@ public:
         value_Q = sum_Q;
     }
 
+    // same as apply on n pairs, up to rounding
+    STREAM1090_FORCE_INLINE void applyBlock(float* __restrict I, float* __restrict Q, size_t n) noexcept {
+        for (size_t pos = 0; pos < n; pos += Block::BlockSize) {
+            m_block.filter(m_taps.data(), numTaps(), m_areTapsSymmetric, bufferSize(), m_delay_I.data(), m_delay_Q.data(),
+                           m_new_index, I + pos, Q + pos, std::min(Block::BlockSize, n - pos), m_useFFT ? &m_fft : nullptr);
+        }
+    }
+
 private:
+    using Block = FIRBlock<std::bit_ceil(MaxNumTaps)>;
+
+    void updateEngine() {
+        const bool wantsFFT = (m_engine == Engine::FFT) || (m_engine == Engine::Auto && numTaps() >= FFTCrossoverTaps);
+        m_useFFT = wantsFFT && m_fft.setTaps(m_taps.data(), numTaps(), Block::BlockSize);
+    }
+
     void sum_not_sym(float& sum_I, float& sum_Q) const noexcept {
         // index that wraps around the ring buffer
         int j = m_new_index;
@@ -323,5 +459,13 @@ private:
 
     // index where a new I and Q values are stored in the delay buffers
     int m_new_index;
+
+    // for applyBlock
+    Block m_block;
+
+    // the convolution of applyBlock for long filters
+    Engine m_engine = Engine::Auto;
+    bool m_useFFT = false;
+    FFTConvolver m_fft{ MaxNumTaps - 1 + Block::BlockSize };
 };
 
@@ -12,12 +12,28 @@
 #include "SampleStream.hpp"
 #include "InputStreamReader.hpp"
 #include "InputBufferReader.hpp"
+#include "BlockTuner.hpp"
+#include "FdReadAhead.hpp"
+#include "StreamGaps.hpp"
+#include "Playlist.hpp"
+#include "SharedTrustView.hpp"
+#include "FrameMerger.hpp"
+#include "FrameSinks.hpp"
+#include "ControlSocket.hpp"
 #include "IQPipeline.hpp"
+#include "RealTime.hpp"
 #include "LowPassFilter.hpp"
 #include "devices/IniConfig.hpp"
 #include "devices/DeviceFactory.hpp"
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <sstream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <mutex>
 
 
 template<typename Sampler>
@@ -29,6 +45,8 @@ void printSamplerConfig() {
     std::cerr << "[Stream1090] Number of streams: " << Sampler::NumStreams << std::endl;
     std::cerr << "[Stream1090] Size of input buffer: " << Sampler::InputBufferSize << " samples " << std::endl;
     std::cerr << "[Stream1090] Size of sample buffer: " << Sampler::SampleBufferSize << " samples " << std::endl;  
+    std::cerr << "[Stream1090] Kernels: " << CpuDispatch::name(CpuDispatch::selected())
+              << " (cpu: " << CpuDispatch::cpuFeatures() << ")" << std::endl;
 }
 
 struct CompileTimeVars {
@@ -38,11 +56,50 @@ struct CompileTimeVars {
     IQPipelineOptions pipelineOption = IQPipelineOptions::NONE;
 };
 
+// one input when running several receivers in one process
+struct ReceiverConfig {
+    InputDeviceType deviceType = InputDeviceType::STREAM;
+    IniConfig deviceConfig;
+    IniConfig::Section deviceConfigSection;
+    // raw recording to read from if deviceType is STREAM
+    std::string inputFile;
+};
+
 struct RuntimeVars {
     InputDeviceType deviceType = InputDeviceType::STREAM;
     IniConfig deviceConfig;
     IniConfig::Section deviceConfigSection;
     std::vector<float> filterTaps;
+    std::string bitCaptureFile;
+    // if not empty, a JSON snapshot of the decoded aircraft is written here every second
+    std::string aircraftJsonFile;
+    // if not empty, the frames are also published into a shared memory ring of this name
+    std::string frameRingName;
+    // if not empty, the frames are also archived into segment files in this directory
+    std::string archiveDir;
+    // if not empty, the frames are also sent as UDP datagrams to this host:port
+    std::string udpTarget;
+    UdpOutput::Format udpFormat = UdpOutput::Format::Beast;
+    // if not empty, these receivers are run instead of the single device above
+    std::vector<ReceiverConfig> receivers;
+    // frames of different receivers closer than this are duplicates
+    uint64_t mergeWindowMicros = 1000;
+    // CPU pinning, priorities and memory locking
+    RealTime::Config realTime;
+    // input samples processed at once. 0 is the largest block of the preset
+    size_t blockSize = 0;
+    // the block size is chosen by timing a few of them at startup
+    bool autoBlockSize = false;
+    // if > 0, the block is at most this long, e.g. for a low latency setup
+    double maxBlockMillis = 0.0;
+    // capacity of the pipe on stdin, 0 keeps the one of the system
+    size_t pipeBufferSize = 1024 * 1024;
+    // if not empty, these recordings are read back to back instead of stdin
+    std::vector<Playlist::Entry> playlist;
+    // if not empty, commands are taken on a Unix domain socket of this path
+    std::string controlSocket;
+    // demodulate the coarse phases only and refine the others on demand, see DemodCore
+    bool coarsePhases = false;
     bool verbose = true;
 };
 
@@ -52,6 +109,10 @@ class MainInstance {
 public:
     MainInstance(const RuntimeVars& runtimeVars) : m_runtimeVars(runtimeVars) { 
         printSamplerConfig<SamplerType>();
+        if constexpr (preset::decimation > 1) {
+            std::cerr << "[Stream1090] Raw sampling speed: " << double(preset::inputRate) / 1000000.0
+                      << " MHz, decimated by " << preset::decimation << std::endl;
+        }
     }
 
     // we first unpack the preset
@@ -62,43 +123,297 @@ public:
     static constexpr SampleRate inputRate  = SamplerType::InputSampleRate;
     static constexpr SampleRate outputRate = SamplerType::OutputSampleRate;
     static constexpr IQPipelineOptions pipelineOption = preset::pipelineOption;
+    // the device delivers the raw IQ pairs at this rate, the IQ pipeline decimates them to inputRate
+    static constexpr SampleRate rawRate = preset::inputRate;
+    static constexpr size_t decimation = preset::decimation;
+    // raw values per input sample of the sampler
+    static constexpr size_t ValuesPerSample = 2 * decimation;
 
     // with all the compile time information available we continue now with what we need
     using DevicePtr   = std::unique_ptr<InputDeviceBase<RawType>>;
-    using RingBuffer  = RingBufferAsync<RawType, SamplerType::InputBufferSize * 2>;
+    // the blocks of the ring buffer are the smallest block the sample stream may ask for
+    static constexpr size_t RingBlockSize = SamplerType::InputBlockGranularity * ValuesPerSample;
+    static constexpr size_t NumRingBlocks = SamplerType::NumInputGranules * 8;
+    using RingBuffer  = RingBufferAsync<RawType, RingBlockSize, NumRingBlocks>;
     using Writer      = typename RingBuffer::Writer;
+    using BitCaptureWriter = BitCapture::Writer<SamplerType::NumStreams>;
+    using ReadAhead   = FdReadAhead<RawType>;
+    // zeros after a recording that is followed by a gap, so its last frames leave the demodulator
+    static constexpr size_t FlushSamples = 256 * SamplerType::NumStreams * SamplerType::RatioInput / SamplerType::RatioOutput + 1;
+
+    // only the coarse phases are demodulated continuously if requested and the sampler has enough streams
+    void setupCoarsePhases(SampleStream<SamplerType>& sampleStream) {
+        if (!m_runtimeVars.coarsePhases)
+            return;
+        if (sampleStream.setCoarsePhases(true)) {
+            log((std::ostringstream() << "[Stream1090] Coarse phases: every "
+                 << SampleStream<SamplerType>::CoarsePhaseStep << ". of " << SamplerType::NumStreams << " streams").str());
+        } else {
+            log("[Stream1090] Coarse phases need at least 16 streams, demodulating all of them");
+        }
+    }
+
+    // opens the bit capture if requested and attaches it to the sample stream
+    bool setupBitCapture(SampleStream<SamplerType>& sampleStream, BitCaptureWriter& capture) {
+        if (m_runtimeVars.bitCaptureFile.empty())
+            return true;
+
+        if (!capture.open(m_runtimeVars.bitCaptureFile, rawRate, outputRate)) {
+            log("[Stream1090] Cannot open bit capture file " + m_runtimeVars.bitCaptureFile);
+            return false;
+        }
+        log("[Stream1090] Capturing demodulated bits to " + m_runtimeVars.bitCaptureFile);
+        sampleStream.setBitCapture(&capture);
+        return true;
+    }
     
+    // creates the requested frame sinks: aircraft tracker, shared memory ring and archive
+    bool setupSinks() {
+        if (!m_runtimeVars.aircraftJsonFile.empty()) {
+            log("[Stream1090] Writing aircraft to " + m_runtimeVars.aircraftJsonFile);
+            m_tracker = std::make_unique<AircraftTracker>();
+            m_jsonWriter = std::make_unique<AircraftJsonWriter>(*m_tracker, m_runtimeVars.aircraftJsonFile);
+            m_sinks.tracker = m_tracker.get();
+        }
+
+        if (!m_runtimeVars.frameRingName.empty()) {
+            if (!m_frameRing.open(m_runtimeVars.frameRingName)) {
+                log("[Stream1090] Cannot create shared memory ring " + m_runtimeVars.frameRingName);
+                return false;
+            }
+            log("[Stream1090] Publishing frames to shared memory ring " + m_runtimeVars.frameRingName);
+            m_sinks.frameRing = &m_frameRing;
+        }
+
+        if (!m_runtimeVars.archiveDir.empty()) {
+            if (!m_archive.open(m_runtimeVars.archiveDir)) {
+                log("[Stream1090] Cannot open archive directory " + m_runtimeVars.archiveDir);
+                return false;
+            }
+            log("[Stream1090] Archiving frames to " + m_runtimeVars.archiveDir);
+            m_sinks.archive = &m_archive;
+        }
+
+        if (!m_runtimeVars.udpTarget.empty()) {
+            if (!m_udp.open(m_runtimeVars.udpTarget, m_runtimeVars.udpFormat)) {
+                log("[Stream1090] Cannot send UDP to " + m_runtimeVars.udpTarget);
+                return false;
+            }
+            log("[Stream1090] Sending frames as UDP datagrams to " + m_runtimeVars.udpTarget);
+            m_sinks.udp = &m_udp;
+        }
+        return true;
+    }
+
+    // flushes and closes the sinks. Needed before std::exit which skips the member destructors.
+    void closeSinks() {
+        if (m_jsonWriter) {
+            m_jsonWriter->stop();
+        }
+        m_frameRing.close();
+        m_archive.close();
+        if (m_udp.isOpen()) {
+            m_udp.close();
+            log((std::ostringstream() << "[Stream1090] UDP: " << m_udp.numSent() << " datagrams sent, "
+                 << m_udp.numDropped() << " dropped").str());
+        }
+        m_sinks = FrameSinks();
+    }
+
+    // Opens the control socket if requested. inputStats adds the counts of the
+    // input to the stats command. The commands are taken on the thread of the
+    // socket; the device is guarded by m_deviceMutex and the new taps go to the
+    // DSP thread through m_tapsMailbox, see Control::Server.
+    bool setupControl(std::function<std::string()> inputStats) {
+        const std::string& path = m_runtimeVars.controlSocket;
+        if (path.empty())
+            return true;
+
+        const bool hasDevice = (m_runtimeVars.deviceType != InputDeviceType::STREAM);
+
+        m_control.on("set", "set <key> <value>", [this, hasDevice](const std::vector<std::string>& args) {
+            if (args.size() != 2)
+                return Control::error("usage: set <key> <value>");
+            if (!hasDevice)
+                return Control::error("there is no device");
+            const auto& key = args[0];
+            const auto& value = args[1];
+            if (key == "serial")
+                return Control::error("serial cannot be changed");
+
+            std::lock_guard<std::mutex> lock(m_deviceMutex);
+            if (!m_device || !m_device->isRunning())
+                return Control::error("device is not running");
+            if (!m_device->applySetting(key, value))
+                return Control::error("device did not take " + key + "=" + value);
+            // a re-opened device gets it too, see recoverDevice
+            m_runtimeVars.deviceConfigSection[key] = value;
+            log("[Stream1090] Control: " + key + "=" + value);
+            return Control::ok(key + "=" + value);
+        });
+
+        m_control.on("get", "get [<key>]", [this](const std::vector<std::string>& args) {
+            std::lock_guard<std::mutex> lock(m_deviceMutex);
+            const auto& section = m_runtimeVars.deviceConfigSection;
+            if (args.size() == 1) {
+                const auto it = section.find(args[0]);
+                if (it == section.end())
+                    return Control::error(args[0] + " is not set");
+                return Control::ok(it->first + "=" + it->second);
+            }
+            std::string res;
+            for (const auto& [key, value] : section)
+                res += (res.empty() ? "" : " ") + key + "=" + value;
+            return Control::ok(res);
+        });
+
+        m_control.on("stats", "stats", [this, inputStats](const std::vector<std::string>&) {
+            const std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - m_startTime;
+            std::ostringstream res;
+            res << "uptime=" << uptime.count() << " " << inputStats()
+                << " frames=" << m_frameCounters.numShort.load() + m_frameCounters.numLong.load()
+                << " short=" << m_frameCounters.numShort.load()
+                << " long=" << m_frameCounters.numLong.load();
+            for (size_t df = 0; df < m_frameCounters.numPerDF.size(); df++) {
+                if (const uint64_t n = m_frameCounters.numPerDF[df].load())
+                    res << " df" << df << "=" << n;
+            }
+            if (m_udp.isOpen())
+                res << " udp_sent=" << m_udp.numSent() << " udp_dropped=" << m_udp.numDropped();
+            return Control::ok(res.str());
+        });
+
+        m_control.on("taps", "taps <t0> <t1> ...", [this](const std::vector<std::string>& args) {
+            if constexpr (pipelineOption != IQPipelineOptions::IQ_FIR_FILE &&
+                          pipelineOption != IQPipelineOptions::IQ_FIR_RTL_SDR_FILE) {
+                return Control::error("the taps can only be swapped when started with -f");
+            } else {
+                if (args.empty())
+                    return Control::error("usage: taps <t0> <t1> ...");
+                std::vector<float> taps;
+                for (const auto& arg : args)
+                    taps.push_back(std::stof(arg));
+                const size_t numTaps = taps.size();
+                switch (m_tapsMailbox.post(std::move(taps), std::chrono::milliseconds(1000))) {
+                    case TapsMailbox::Result::Applied:
+                        log("[Stream1090] Control: " + std::to_string(numTaps) + " new taps");
+                        return Control::ok("taps=" + std::to_string(numTaps));
+                    case TapsMailbox::Result::Pending:
+                        return Control::ok("taps=" + std::to_string(numTaps) + " pending");
+                    default:
+                        return Control::error("the filter did not take " + std::to_string(numTaps) + " taps");
+                }
+            }
+        });
+
+        m_control.on("output", "output [<name> on|off]", [this](const std::vector<std::string>& args) {
+            std::string res;
+            for (int i = 0; i < OutputSwitches::NumOutputs; i++) {
+                const auto output = OutputSwitches::Output(i);
+                if (args.empty()) {
+                    res += (res.empty() ? "" : " ") + std::string(OutputSwitches::Names[i])
+                         + (m_outputs.isOn(output) ? "=on" : "=off");
+                    continue;
+                }
+                if (args[0] != OutputSwitches::Names[i])
+                    continue;
+                if (args.size() != 2 || (args[1] != "on" && args[1] != "off"))
+                    return Control::error("usage: output <name> on|off");
+                m_outputs.set(output, args[1] == "on");
+                log("[Stream1090] Control: output " + args[0] + " " + args[1]);
+                return Control::ok(args[0] + "=" + args[1]);
+            }
+            return args.empty() ? Control::ok(res) : Control::error("unknown output " + args[0]);
+        });
+
+        if (!m_control.open(path)) {
+            log("[Stream1090] Cannot open control socket " + path + ": " + m_control.lastError());
+            return false;
+        }
+        log("[Stream1090] Taking commands on " + path);
+        m_sinks.switches = &m_outputs;
+        m_sinks.counters = &m_frameCounters;
+        return true;
+    }
+
+    // locks the memory if requested, before the large buffers are allocated
+    void setupRealTime() {
+        const auto& rt = m_runtimeVars.realTime;
+        if (rt.empty())
+            return;
+        if (rt.lockMemory)
+            log(RealTime::lockMemory());
+        m_pageFaults = RealTime::PageFaults::now();
+    }
+
+    // applies the real-time settings to a thread, by default the calling one
+    void configureThread(const std::string& name, const RealTime::ThreadConfig& config, size_t index = 0,
+                         pthread_t thread = pthread_self()) {
+        if (!config.empty())
+            log(RealTime::configureThread(name, config, index, thread));
+    }
+
+    // huge pages for the ring buffer and all its pages faulted in before the device starts
+    void prepareRingBuffer(RingBuffer& ringBuffer) {
+        const auto& rt = m_runtimeVars.realTime;
+        if (!rt.lockMemory && !rt.hugePages)
+            return;
+        const size_t advised = RealTime::prepareBuffer(ringBuffer.begin(0), RingBuffer::size() * sizeof(RawType), rt.hugePages);
+        if (rt.hugePages)
+            log((std::ostringstream() << "[Stream1090] " << advised / 1024 << " of " << RingBuffer::size() * sizeof(RawType) / 1024
+                 << " KiB of the ring buffer advised for huge pages").str());
+    }
+
+    // logs the page faults since the last call
+    void logPageFaults(const std::string& phase) {
+        if (m_runtimeVars.realTime.empty())
+            return;
+        const auto now = RealTime::PageFaults::now();
+        const auto delta = now - m_pageFaults;
+        m_pageFaults = now;
+        log((std::ostringstream() << "[Stream1090] Page faults " << phase << ": " << delta.minor << " minor, "
+             << delta.major << " major").str());
+    }
+
     bool reloadDeviceConfig() {
+        return reloadDeviceConfig(m_runtimeVars.deviceType, m_runtimeVars.deviceConfig, m_runtimeVars.deviceConfigSection);
+    }
+
+    // re-reads the INI file of a device and extracts the section for deviceType again
+    bool reloadDeviceConfig(InputDeviceType deviceType, IniConfig& deviceConfig, IniConfig::Section& section) {
         // Re-read the INI file from disk
-        if (!m_runtimeVars.deviceConfig.reload()) {
+        if (!deviceConfig.reload()) {
             log("[Stream1090] Failed to reload INI file.");
             return false;
         }
 
-        auto& cfg = m_runtimeVars.deviceConfig.get();
+        auto& cfg = deviceConfig.get();
 
         // Extract the correct section
-        if (m_runtimeVars.deviceType == InputDeviceType::AIRSPY) {
+        if (deviceType == InputDeviceType::AIRSPY) {
             if (!cfg.count("airspy")) {
                 log("[Stream1090] Reloaded INI missing [airspy] section.");
                 return false;
             }
-            m_runtimeVars.deviceConfigSection = cfg.at("airspy");
+            section = cfg.at("airspy");
         }
 
-        else if (m_runtimeVars.deviceType == InputDeviceType::RTLSDR) {
+        else if (deviceType == InputDeviceType::RTLSDR) {
             if (!cfg.count("rtlsdr")) {
                 log("[Stream1090] Reloaded INI missing [rtlsdr] section.");
                 return false;
             }
-            m_runtimeVars.deviceConfigSection = cfg.at("rtlsdr");
+            section = cfg.at("rtlsdr");
         }
 
         return true;
     }
 
     bool setup_device() {
-        const auto& cfg = m_runtimeVars.deviceConfigSection;
+        return setup_device(*m_device, m_runtimeVars.deviceConfigSection);
+    }
+
+    bool setup_device(InputDeviceBase<RawType>& device, const IniConfig::Section& cfg) {
         
         // before we open, we check the serial
         uint64_t serial = 0;
@@ -107,7 +422,7 @@ public:
         }
 
         // let us try to open the device
-        if (!m_device->open_with_serial(serial)) {
+        if (!device.open_with_serial(serial)) {
             log("[Stream1090] Opening device failed.");
             // this is not good at all
             return false;
@@ -117,7 +432,7 @@ public:
         for (auto& [key, value] : cfg) {
             if (key == "serial")
                 continue;
-            m_device->applySetting(key, value);
+            device.applySetting(key, value);
         }
 
         // we do not care if any of the properties did not work
@@ -132,11 +447,76 @@ public:
         }
     }
 
+    // Runs the sample stream. The frames are passed on to the sinks if there are any.
+    template<typename InputReaderType, MessageHandler Handler>
+    void read_stream(SampleStream<SamplerType>& sampleStream, InputReaderType& inputReader, Handler& messageHandler) {
+        if (m_sinks.empty()) {
+            sampleStream.read(inputReader, messageHandler);
+            return;
+        }
+
+        SinkMessageHandler<SamplerType, Handler, SampleStream<SamplerType>> sinkHandler(messageHandler, m_sinks, sampleStream);
+        sampleStream.read(inputReader, sinkHandler);
+    }
+
+    // Closes the lost device and opens it again, with a growing pause between the
+    // attempts, until it runs or we shut down. The sample stream continues after
+    // a gap of the time without samples, so the timestamps stay consistent.
+    void recoverDevice(CountingWriter<RawType>& deviceWriter, StreamGaps& gaps, const std::atomic<bool>& finished) {
+        using namespace std::chrono_literals;
+        const auto lastSamples = std::chrono::steady_clock::now() - m_device->lastSignOfLife();
+        {
+            std::lock_guard<std::mutex> lock(m_deviceMutex);
+            m_device->close();
+            m_device.reset();
+        }
+
+        // the last frames leave the demodulator and the gap starts at a block
+        const uint64_t padded = deviceWriter.pad(ValuesPerSample * m_blockSize, ValuesPerSample * FlushSamples) / ValuesPerSample;
+
+        auto pause = std::chrono::milliseconds(500);
+        for (size_t attempt = 1; !ProcessSignals::shutdownRequested() && !finished.load(); attempt++) {
+            log("[Stream1090] Re-opening the device, attempt " + std::to_string(attempt));
+            std::unique_lock<std::mutex> lock(m_deviceMutex);
+            m_device = DeviceFactory<RawType>::create(m_runtimeVars.deviceType, rawRate, deviceWriter);
+            if (m_device && setup_device()) {
+                m_device->setCallbackThreadConfig(m_runtimeVars.realTime.usb, "usb");
+                // queued before the first new sample, replaced by the next attempt if this one fails
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - lastSamples;
+                const uint64_t gap = uint64_t(elapsed.count() * double(inputRate));
+                gaps.push(deviceWriter.numValues() / ValuesPerSample, gap > padded ? gap - padded : 0);
+                if (m_device->start()) {
+                    m_device->markAsAlive();
+                    log((std::ostringstream() << "[Stream1090] Device is running again after "
+                         << elapsed.count() << "s").str());
+                    return;
+                }
+            }
+            if (m_device) {
+                m_device->close();
+                m_device.reset();
+            }
+            lock.unlock();
+
+            const auto retry = std::chrono::steady_clock::now() + pause;
+            while (std::chrono::steady_clock::now() < retry && !ProcessSignals::shutdownRequested() && !finished.load()) {
+                std::this_thread::sleep_for(100ms);
+            }
+            pause = std::min(pause * 2, std::chrono::milliseconds(30000));
+        }
+    }
+
     void run_async_device(auto& iqPipeline) {
         RingBuffer ringBuffer;
         Writer writer(ringBuffer);
+        prepareRingBuffer(ringBuffer);
 
-        m_device = DeviceFactory<RawType>::create(m_runtimeVars.deviceType, inputRate, writer);
+        // the device may be opened again, see recoverDevice
+        CountingWriter<RawType> deviceWriter(writer);
+        StreamGaps gaps;
+        std::atomic<bool> finished{false};
+
+        m_device = DeviceFactory<RawType>::create(m_runtimeVars.deviceType, rawRate, deviceWriter);
         if (!m_device) {
             log("[Stream1090] Device instantiation failed.");
             return;
@@ -149,6 +529,7 @@ public:
         }
         log("[Stream1090] Device successfully configured.");
 
+        m_device->setCallbackThreadConfig(m_runtimeVars.realTime.usb, "usb");
         if (!m_device->start()) {
             log("[Stream1090] Device refuses to start. Aborting.");
             return;
@@ -168,15 +549,15 @@ public:
         // -------------------------------
         // WATCHDOG THREAD
         // -------------------------------
-        std::thread watchdog([this] {
+        std::thread watchdog([&] {
             using namespace std::chrono_literals;
-            while (!ProcessSignals::shutdownRequested()) {
-                // 1) Device health check. Is the device still alive?
+            while (!ProcessSignals::shutdownRequested() && !finished.load()) {
+                // 1) Device health check. Is the device still alive? If not, the
+                // stream waits while we open it again.
                 if (m_device && m_device->lastSignOfLife() > 1000ms) {
                     log("[Stream1090] No samples for 1000ms. Device lost?");
-                    m_device->close();
-                    ProcessSignals::handle_sigint(0);
-                    break;
+                    recoverDevice(deviceWriter, gaps, finished);
+                    continue;
                 }
 
                 // 2) Reload request (SIGHUP)
@@ -184,6 +565,7 @@ public:
                     ProcessSignals::clearReload();
                     log("[Stream1090] Reload requested. Re-reading config file.");
 
+                    std::lock_guard<std::mutex> lock(m_deviceMutex);
                     if (reloadDeviceConfig()) {
                         log("[Stream1090] Applying new configuration.");
                         m_device->applyReloadedConfig(m_runtimeVars.deviceConfigSection);
@@ -194,8 +576,11 @@ public:
 
                 std::this_thread::sleep_for(200ms);
             }
+            // the stream may be waiting for samples of a lost device
+            ringBuffer.shutdown();
             log("[Stream1090] Watchdog is done.");
         });
+        configureThread("watchdog", m_runtimeVars.realTime.watchdog, 0, watchdog.native_handle());
 
 
         // -------------------------------
@@ -205,53 +590,136 @@ public:
 
         if (m_device->isRunning()) {
             log("[Stream1090] Device is running, starting stream.");
-            InputBufferReader<
+            InputBufferGapReader<
                 RawFormatType,
-                SamplerType::InputBufferSize * 2,
-                8,
+                RingBlockSize,
+                NumRingBlocks,
                 decltype(iqPipeline)
-            > inputReader(iqPipeline, ringBuffer);
+            > inputReader(iqPipeline, ringBuffer, gaps);
 
             SampleStream<SamplerType> sampleStream;
+            sampleStream.setBlockSize(m_blockSize);
+            setupCoarsePhases(sampleStream);
             auto messageHandler = constructMessageHandler(sampleStream);
-            
-            sampleStream.read(inputReader, messageHandler);
+
+            const auto inputStats = [&] {
+                return "samples=" + std::to_string(deviceWriter.numValues() / 2)
+                     + " decoder_waits=" + std::to_string(ringBuffer.getNumReaderWaits());
+            };
+            inputReader.setTapsMailbox(&m_tapsMailbox);
+
+            BitCaptureWriter bitCapture;
+            if (setupBitCapture(sampleStream, bitCapture) && setupSinks() && setupControl(inputStats)) {
+                configureThread("dsp", m_runtimeVars.realTime.dsp);
+                logPageFaults("during startup");
+                read_stream(sampleStream, inputReader, messageHandler);
+                logPageFaults("while running");
+            }
         }
 
         // -------------------------------
         // SHUTDOWN
         // -------------------------------
-        log("[Stream1090] Shutting down device.");
-        m_device->close();
-        log("[Stream1090] Device closed down.");
-
-        auto end_wct = std::chrono::steady_clock::now();
-        auto dur_wct_secs = std::chrono::duration_cast<std::chrono::milliseconds>(end_wct - start_wct).count();
+        // no more commands, then the watchdog, it may be opening the device again
+        m_control.close();
+        finished.store(true);
         if (watchdog.joinable()) {
             log("[Stream1090] Watchdog joining.");
             watchdog.join();
             log("[Stream1090] Watchdog joined.");
         }
+        log("[Stream1090] Shutting down device.");
+        if (m_device)
+            m_device->close();
+        log("[Stream1090] Device closed down.");
+        closeSinks();
+
+        auto end_wct = std::chrono::steady_clock::now();
+        auto dur_wct_secs = std::chrono::duration_cast<std::chrono::milliseconds>(end_wct - start_wct).count();
         log("[Stream1090] Shutdown completed.");
         log((std::ostringstream() << "[Stream1090] Finished. (" << dur_wct_secs/1000.0 << "s)").str());
         std::exit(0);
     }
 
 
-    void run_sync_stdin(auto& iqPipeline) {
-        log("[Stream1090] Reading from stdin");
+    // Stdin, or the recordings of the playlist, are read ahead on their own thread
+    // into the ring buffer, see FdReadAhead
+    void run_read_ahead(auto& iqPipeline) {
         auto start_wct = std::chrono::steady_clock::now();
 
-        InputStdStreamReader<
+        RingBuffer ringBuffer;
+        Writer writer(ringBuffer);
+        prepareRingBuffer(ringBuffer);
+
+        std::unique_ptr<ReadAhead> readAheadPtr;
+        const auto& playlist = m_runtimeVars.playlist;
+        if (playlist.empty()) {
+            log("[Stream1090] Reading from stdin");
+            readAheadPtr = std::make_unique<ReadAhead>(STDIN_FILENO, writer);
+        } else {
+            const auto gaps = Playlist::gaps(playlist, ValuesPerSample * sizeof(RawType), double(inputRate));
+            std::vector<typename ReadAhead::Source> sources;
+            for (size_t i = 0; i < playlist.size(); i++) {
+                sources.push_back({ playlist[i].path, gaps[i] });
+                log((std::ostringstream() << "[Stream1090] Playlist " << i << ": " << playlist[i].path << " ("
+                     << double(playlist[i].numBytes / (2 * sizeof(RawType))) / double(rawRate) << " s"
+                     << (gaps[i] > 0 ? ", after a gap of " + std::to_string(double(gaps[i]) / double(inputRate)) + " s" : "")
+                     << ")").str());
+            }
+            readAheadPtr = std::make_unique<ReadAhead>(std::move(sources), writer);
+        }
+        auto& readAhead = *readAheadPtr;
+
+        if (m_runtimeVars.pipeBufferSize > 0) {
+            const long pipeSize = readAhead.setPipeBufferSize(m_runtimeVars.pipeBufferSize);
+            if (pipeSize > 0)
+                log((std::ostringstream() << "[Stream1090] Pipe buffer: " << pipeSize / 1024 << " KiB").str());
+            else if (pipeSize < 0)
+                log((std::ostringstream() << "[Stream1090] Pipe buffer could not be set to " << m_runtimeVars.pipeBufferSize / 1024
+                     << " KiB: " << std::strerror(errno) << " (see /proc/sys/fs/pipe-max-size)").str());
+        }
+
+        InputBufferGapReader<
             RawFormatType,
-            SamplerType::InputBufferSize,
+            RingBlockSize,
+            NumRingBlocks,
             decltype(iqPipeline)
-        > inputReader(iqPipeline, std::cin);
+        > inputReader(iqPipeline, ringBuffer, readAhead.gaps());
 
-        
         SampleStream<SamplerType> sampleStream;
+        sampleStream.setBlockSize(m_blockSize);
+        setupCoarsePhases(sampleStream);
         auto messageHandler = constructMessageHandler(sampleStream);
-        sampleStream.read(inputReader, messageHandler);
+
+        const auto inputStats = [&] {
+            return "samples=" + std::to_string(readAhead.numBytesRead() / (2 * sizeof(RawType)))
+                 + " decoder_waits=" + std::to_string(ringBuffer.getNumReaderWaits());
+        };
+        inputReader.setTapsMailbox(&m_tapsMailbox);
+
+        BitCaptureWriter bitCapture;
+        if (!setupBitCapture(sampleStream, bitCapture) || !setupSinks() || !setupControl(inputStats))
+            std::exit(1);
+
+        readAhead.start(ValuesPerSample * sampleStream.blockSize(), ValuesPerSample * FlushSamples, ValuesPerSample);
+        configureThread("read-ahead", m_runtimeVars.realTime.usb, 0, readAhead.nativeHandle());
+        configureThread("dsp", m_runtimeVars.realTime.dsp);
+        logPageFaults("during startup");
+        read_stream(sampleStream, inputReader, messageHandler);
+        logPageFaults("while running");
+        m_control.close();
+        // the read ahead may wait for space if we stopped early
+        ringBuffer.shutdown();
+        readAhead.join();
+        bitCapture.close();
+        closeSinks();
+
+        if (!readAhead.error().empty())
+            log("[Stream1090] Reading failed: " + readAhead.error());
+        log((std::ostringstream() << "[Stream1090] Read " << readAhead.numBytesRead() / (1024 * 1024) << " MiB in "
+             << readAhead.numReads() << " reads. The pipe was empty " << readAhead.numPipeStalls()
+             << " times, the decoder waited for samples " << ringBuffer.getNumReaderWaits()
+             << " times, the read ahead for the decoder " << ringBuffer.getNumWriterWaits() << " times").str());
 
         auto end_wct = std::chrono::steady_clock::now();
         auto dur_wct_secs = std::chrono::duration_cast<std::chrono::milliseconds>(end_wct - start_wct).count();
@@ -259,14 +727,246 @@ public:
         std::exit(0);
     }
 
+    // The DSP part of one receiver. Runs on its own thread and pushes the frames to the merger.
+    template<typename InputReaderType>
+    void run_receiver_stream(size_t index, InputReaderType& inputReader, SharedTrustView& trustView, FrameMerger& merger) {
+        auto sampleStream = std::make_unique<SampleStream<SamplerType>>();
+        sampleStream->setBlockSize(m_blockSize);
+        sampleStream->setSharedTrustView(&trustView);
+        setupCoarsePhases(*sampleStream);
+
+        // the bit capture, if any, records the first receiver
+        BitCaptureWriter bitCapture;
+        if (index == 0 && !setupBitCapture(*sampleStream, bitCapture)) {
+            return;
+        }
+
+        MergeMessageHandler<SamplerType, SampleStream<SamplerType>> messageHandler(merger, index, *sampleStream);
+        sampleStream->read(inputReader, messageHandler);
+    }
+
+    // Runs all receivers of m_runtimeVars.receivers in this process. Every receiver
+    // has its own IQ pipeline, sample stream and demodulator on its own thread.
+    // The demodulators share their trusted addresses and a single merge stage
+    // writes the frames without the copies seen by more than one receiver.
+    void run_multi_receiver() {
+        auto& receivers = m_runtimeVars.receivers;
+        const size_t numReceivers = receivers.size();
+        log((std::ostringstream() << "[Stream1090] Running " << numReceivers << " receivers").str());
+        if (!m_runtimeVars.controlSocket.empty())
+            log("[Stream1090] The control socket is not supported with several receivers yet, ignoring --control");
+
+        auto start_wct = std::chrono::steady_clock::now();
+
+        // the ring buffers are large, keep them on the heap
+        std::vector<std::unique_ptr<RingBuffer>> ringBuffers(numReceivers);
+        std::vector<std::unique_ptr<Writer>> writers(numReceivers);
+        std::vector<DevicePtr> devices(numReceivers);
+
+        // open and start all devices first
+        for (size_t i = 0; i < numReceivers; i++) {
+            auto& rc = receivers[i];
+            if (rc.deviceType == InputDeviceType::STREAM) {
+                log("[Stream1090] Receiver " + std::to_string(i) + " reads from " + rc.inputFile);
+                continue;
+            }
+
+            ringBuffers[i] = std::make_unique<RingBuffer>();
+            prepareRingBuffer(*ringBuffers[i]);
+            writers[i] = std::make_unique<Writer>(*ringBuffers[i]);
+            devices[i] = DeviceFactory<RawType>::create(rc.deviceType, rawRate, *writers[i]);
+            if (devices[i])
+                devices[i]->setCallbackThreadConfig(m_runtimeVars.realTime.usb, "usb " + std::to_string(i), i);
+            if (!devices[i] || !setup_device(*devices[i], rc.deviceConfigSection) || !devices[i]->start()) {
+                log("[Stream1090] Receiver " + std::to_string(i) + ": device setup failed. Aborting.");
+                for (auto& d : devices) {
+                    if (d) d->close();
+                }
+                std::exit(1);
+            }
+            devices[i]->markAsAlive();
+            log("[Stream1090] Receiver " + std::to_string(i) + ": device is running.");
+        }
+
+        ProcessSignals::install();
+
+        SharedTrustView trustView;
+        FrameMerger merger(numReceivers, m_runtimeVars.mergeWindowMicros, std::cout);
+        std::atomic<bool> finished{false};
+
+        // the sinks get the merged frames on the merge thread
+        if (!setupSinks()) {
+            for (auto& d : devices) {
+                if (d) d->close();
+            }
+            closeSinks();
+            std::exit(1);
+        }
+        merger.setSinks(m_sinks);
+
+        // -------------------------------
+        // WATCHDOG THREAD
+        // -------------------------------
+        // A lost device only ends its own receiver. The others keep running.
+        std::thread watchdog([&] {
+            using namespace std::chrono_literals;
+            std::vector<bool> lost(numReceivers, false);
+            while (!ProcessSignals::shutdownRequested() && !finished.load()) {
+                const bool reload = ProcessSignals::reloadRequested();
+                if (reload) {
+                    ProcessSignals::clearReload();
+                    log("[Stream1090] Reload requested. Re-reading config files.");
+                }
+
+                for (size_t i = 0; i < numReceivers; i++) {
+                    if (!devices[i] || lost[i])
+                        continue;
+
+                    if (devices[i]->lastSignOfLife() > 1000ms) {
+                        log("[Stream1090] Receiver " + std::to_string(i) + ": no samples for 1000ms. Device lost?");
+                        devices[i]->close();
+                        ringBuffers[i]->shutdown();
+                        lost[i] = true;
+                        continue;
+                    }
+
+                    auto& rc = receivers[i];
+                    if (reload && reloadDeviceConfig(rc.deviceType, rc.deviceConfig, rc.deviceConfigSection)) {
+                        devices[i]->applyReloadedConfig(rc.deviceConfigSection);
+                    }
+                }
+                std::this_thread::sleep_for(200ms);
+            }
+            log("[Stream1090] Watchdog is done.");
+        });
+        configureThread("watchdog", m_runtimeVars.realTime.watchdog, 0, watchdog.native_handle());
+
+        // -------------------------------
+        // DSP THREADS
+        // -------------------------------
+        std::vector<std::thread> dspThreads;
+        for (size_t i = 0; i < numReceivers; i++) {
+            dspThreads.emplace_back([&, i] {
+                auto iqPipeline = IQPipelineSelector<inputRate, outputRate, pipelineOption, decimation>().make(m_runtimeVars.filterTaps);
+                if (devices[i]) {
+                    InputBufferReader<
+                        RawFormatType,
+                        RingBlockSize,
+                        NumRingBlocks,
+                        decltype(iqPipeline)
+                    > inputReader(iqPipeline, *ringBuffers[i]);
+                    run_receiver_stream(i, inputReader, trustView, merger);
+                } else {
+                    std::ifstream file(receivers[i].inputFile, std::ios::binary);
+                    if (!file.is_open()) {
+                        log("[Stream1090] Receiver " + std::to_string(i) + ": cannot open " + receivers[i].inputFile);
+                    } else {
+                        InputStdStreamReader<
+                            RawFormatType,
+                            SamplerType::InputBufferSize,
+                            decltype(iqPipeline)
+                        > inputReader(iqPipeline, file);
+                        run_receiver_stream(i, inputReader, trustView, merger);
+                    }
+                }
+                merger.finish(i);
+                log("[Stream1090] Receiver " + std::to_string(i) + " is done.");
+            });
+            configureThread("dsp " + std::to_string(i), m_runtimeVars.realTime.dsp, i, dspThreads.back().native_handle());
+        }
+
+        // the merge stage runs on this thread until all receivers are done
+        logPageFaults("during startup");
+        merger.run();
+        logPageFaults("while running");
+
+        // -------------------------------
+        // SHUTDOWN
+        // -------------------------------
+        for (auto& t : dspThreads) {
+            t.join();
+        }
+        finished.store(true);
+        if (watchdog.joinable()) {
+            watchdog.join();
+        }
+        for (auto& d : devices) {
+            if (d) d->close();
+        }
+        closeSinks();
+
+        const auto& stats = merger.stats();
+        for (size_t i = 0; i < numReceivers; i++) {
+            log((std::ostringstream() << "[Stream1090] Receiver " << i << ": " << stats[i].numFrames << " frames, "
+                 << stats[i].numWritten << " written, " << stats[i].numDuplicates << " duplicates"
+                 << (stats[i].synced ? "" : ", never synced")).str());
+        }
+
+        auto end_wct = std::chrono::steady_clock::now();
+        auto dur_wct_secs = std::chrono::duration_cast<std::chrono::milliseconds>(end_wct - start_wct).count();
+        log((std::ostringstream() << "[Stream1090] Finished. (" << dur_wct_secs/1000.0 << "s)").str());
+        std::exit(0);
+    }
+
+    // the number of input samples processed at once, see --block and --latency
+    size_t chooseBlockSize() {
+        constexpr size_t G = SamplerType::InputBlockGranularity;
+        constexpr size_t MaxBlockSize = SamplerType::InputBufferSize;
+        const auto millis = [](size_t blockSize) {
+            return double(blockSize) * 1000.0 / double(inputRate);
+        };
+
+        if constexpr (!SampleStream<SamplerType>::SupportsBlockSize) {
+            if (m_runtimeVars.autoBlockSize || m_runtimeVars.blockSize > 0 || m_runtimeVars.maxBlockMillis > 0.0)
+                log("[Stream1090] The block size of this sampler is fixed, ignoring --block and --latency");
+            return MaxBlockSize;
+        }
+
+        size_t blockSize = MaxBlockSize;
+        if (m_runtimeVars.blockSize > 0) {
+            blockSize = std::clamp(m_runtimeVars.blockSize / G * G, G, MaxBlockSize);
+        } else if (m_runtimeVars.autoBlockSize) {
+            const auto caches = BlockTuner::cacheSizes();
+            log((std::ostringstream() << "[Stream1090] Tuning the block size (L1 " << caches.l1 / 1024
+                 << " KiB, L2 " << caches.l2 / 1024 << " KiB)").str());
+            const auto results = BlockTuner::Tuner<preset>(m_runtimeVars.filterTaps).run(caches);
+            for (const auto& r : results) {
+                log((std::ostringstream() << "[Stream1090]   " << r.blockSize << " samples: "
+                     << r.nsPerSample << " ns/sample").str());
+            }
+            blockSize = results.front().blockSize;
+        }
+
+        // the low latency profile bounds the time it takes to fill a block
+        if (m_runtimeVars.maxBlockMillis > 0.0) {
+            const size_t limit = size_t(m_runtimeVars.maxBlockMillis * double(inputRate) / 1000.0) / G * G;
+            blockSize = std::min(blockSize, std::max(limit, G));
+        }
+
+        log((std::ostringstream() << "[Stream1090] Block size: " << blockSize << " samples ("
+             << millis(blockSize) << " ms, largest " << MaxBlockSize << ")").str());
+        return blockSize;
+    }
+
     void run() {
+        m_startTime = std::chrono::steady_clock::now();
+        setupRealTime();
+        m_blockSize = chooseBlockSize();
+
+        // several receivers in one process
+        if (!m_runtimeVars.receivers.empty()) {
+            log("[Stream1090] Multi Receiver Mode");
+            run_multi_receiver();
+            return;
+        }
+
         // setup pipeline
-        auto iqPipeline = IQPipelineSelector<inputRate, outputRate, pipelineOption>().make(m_runtimeVars.filterTaps);
+        auto iqPipeline = IQPipelineSelector<inputRate, outputRate, pipelineOption, decimation>().make(m_runtimeVars.filterTaps);
         log(iqPipeline.toString());
         // for sync read from std in we take a short cut
         if (m_runtimeVars.deviceType == InputDeviceType::STREAM) {
-            log("[Stream1090] Sync Stdin Mode");
-            run_sync_stdin(iqPipeline);
+            log("[Stream1090] Read Ahead Mode");
+            run_read_ahead(iqPipeline);
         } else {
             log("[Stream1090] Async Device Mode");
             run_async_device(iqPipeline);
@@ -285,17 +985,24 @@ private:
     
     DevicePtr m_device = nullptr;
     RuntimeVars m_runtimeVars;
+    size_t m_blockSize = SamplerType::InputBufferSize;
+    std::unique_ptr<AircraftTracker> m_tracker;
+    std::unique_ptr<AircraftJsonWriter> m_jsonWriter;
+    ShmFrameRing::Writer m_frameRing;
+    FrameArchive::Writer m_archive;
+    UdpOutput::Sender m_udp;
+    FrameSinks m_sinks;
+    RealTime::PageFaults m_pageFaults;
+    // see setupControl
+    Control::Server m_control;
+    OutputSwitches m_outputs;
+    FrameCounters m_frameCounters;
+    TapsMailbox m_tapsMailbox;
+    // guards m_device and the device settings against the control socket
+    std::mutex m_deviceMutex;
+    std::chrono::steady_clock::time_point m_startTime;
 };
 
-template<typename Tuple, typename F>
-constexpr bool for_each_in_tuple(const Tuple& t, F&& f) {
-    bool done = false;
-    std::apply([&](auto const&... elems) {
-        (( !done && f(elems) ? done = true : false ), ...);
-    }, t);
-    return done;
-}
-
 bool runInstanceFromPresets(const CompileTimeVars& compileTimeVars, const RuntimeVars& runtimeVars) {
     return for_each_in_tuple(presets, [&](auto const& p) {
         using P = std::decay_t<decltype(p)>;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <iostream>
+#include <array>
 #include "Bits128.hpp"
 #include "ModeS.hpp"
 #include "AVRWriter.hpp"
@@ -64,3 +65,28 @@ private:
     AVRWriter m_writer;
     const R& rssiProvider;
 };
+
+// Message handler that does not output anything. It only counts the frames 
+// per downlink format. Used by the evaluation tools to score a configuration.
+class CountingMessageHandler {
+public:
+    void handleShort(uint64_t, const uint64_t frame) {
+        m_numShort++;
+        m_perDF[(frame >> 51) & 0x1f]++;
+    }
+
+    void handleLong(uint64_t, const Bits128& frame) {
+        m_numLong++;
+        m_perDF[(frame.high() >> 43) & 0x1f]++;
+    }
+
+    uint64_t total() const noexcept { return m_numShort + m_numLong; }
+    uint64_t numShort() const noexcept { return m_numShort; }
+    uint64_t numLong() const noexcept { return m_numLong; }
+    uint64_t perDF(int df) const noexcept { return m_perDF[df]; }
+
+private:
+    uint64_t m_numShort = 0;
+    uint64_t m_numLong = 0;
+    std::array<uint64_t, 32> m_perDF{};
+};
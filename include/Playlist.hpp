@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <glob.h>
+
+// A list of raw recordings that are streamed back to back, e.g. a capture that
+// was rotated into many files. Either a glob pattern, the files are taken in
+// sorted order, or a text file with one recording per line:
+//
+//   # path                     start time in seconds (optional)
+//   rec_0001.bin               1767225600.0
+//   rec_0002.bin               1767225660.0
+//
+// Relative paths are relative to the text file. If the start times are given,
+// the time that passed between the end of a recording and the start of the
+// next one is a gap in the stream, see gaps().
+namespace Playlist {
+
+    struct Entry {
+        std::string path;
+        // seconds, negative if unknown
+        double startTime = -1.0;
+        uint64_t numBytes = 0;
+    };
+
+    inline bool isPattern(const std::string& str) {
+        return str.find_first_of("*?[") != std::string::npos;
+    }
+
+    namespace detail {
+        inline bool addFile(const std::string& path, double startTime, std::vector<Entry>& entries, std::string& error) {
+            std::error_code ec;
+            const auto numBytes = std::filesystem::file_size(path, ec);
+            if (ec) {
+                error = path + ": " + ec.message();
+                return false;
+            }
+            entries.push_back(Entry{ path, startTime, uint64_t(numBytes) });
+            return true;
+        }
+
+        inline bool loadPattern(const std::string& pattern, std::vector<Entry>& entries, std::string& error) {
+            glob_t result{};
+            const int res = glob(pattern.c_str(), 0, nullptr, &result);
+            if (res != 0) {
+                globfree(&result);
+                error = "no recordings match " + pattern;
+                return false;
+            }
+            bool ok = true;
+            for (size_t i = 0; i < result.gl_pathc && ok; i++) {
+                ok = addFile(result.gl_pathv[i], -1.0, entries, error);
+            }
+            globfree(&result);
+            return ok;
+        }
+
+        inline bool loadList(const std::string& filename, std::vector<Entry>& entries, std::string& error) {
+            std::ifstream file(filename);
+            if (!file.is_open()) {
+                error = "cannot open " + filename;
+                return false;
+            }
+            const auto dir = std::filesystem::path(filename).parent_path();
+            std::string line;
+            size_t lineNumber = 0;
+            while (std::getline(file, line)) {
+                lineNumber++;
+                std::istringstream is(line);
+                std::string path;
+                if (!(is >> path) || path[0] == '#')
+                    continue;
+
+                double startTime = -1.0;
+                std::string rest;
+                if (is >> rest) {
+                    char* end = nullptr;
+                    startTime = std::strtod(rest.c_str(), &end);
+                    if (*end != '\0' || startTime < 0.0) {
+                        error = filename + ":" + std::to_string(lineNumber) + ": invalid start time " + rest;
+                        return false;
+                    }
+                }
+
+                if (std::filesystem::path(path).is_relative())
+                    path = (dir / path).string();
+                if (!addFile(path, startTime, entries, error))
+                    return false;
+            }
+            if (entries.empty()) {
+                error = filename + " lists no recordings";
+                return false;
+            }
+            return true;
+        }
+    }
+
+    // Appends the recordings of a glob pattern or a playlist file.
+    inline bool load(const std::string& arg, std::vector<Entry>& entries, std::string& error) {
+        return isPattern(arg) ? detail::loadPattern(arg, entries, error)
+                              : detail::loadList(arg, entries, error);
+    }
+
+    // The number of input samples missing between the end of entry i - 1 and
+    // the start of entry i. 0 if a start time is unknown or the two overlap.
+    inline std::vector<uint64_t> gaps(const std::vector<Entry>& entries, size_t bytesPerSample, double sampleRate) {
+        std::vector<uint64_t> res(entries.size(), 0);
+        for (size_t i = 1; i < entries.size(); i++) {
+            const auto& prev = entries[i - 1];
+            const auto& curr = entries[i];
+            if (prev.startTime < 0.0 || curr.startTime < 0.0)
+                continue;
+            const double prevEnd = prev.startTime + double(prev.numBytes / bytesPerSample) / sampleRate;
+            const double gap = std::round((curr.startTime - prevEnd) * sampleRate);
+            if (gap > 0.0)
+                res[i] = uint64_t(gap);
+        }
+        return res;
+    }
+
+} // end of namespace Playlist
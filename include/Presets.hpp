@@ -6,10 +6,14 @@
  */
 #pragma once
 
+#include <bit>
+#include <vector>
+#include "Global.hpp"
 #include "Sampler.hpp"
 #include "RawInputFormat.hpp"
 #include "IQPipeline.hpp"
 #include "LowPassFilter.hpp"
+#include "HalfBandDecimator.hpp"
 
 enum class IQPipelineOptions {
     NONE,
@@ -20,15 +24,19 @@ enum class IQPipelineOptions {
 };
 
 
-template<typename RawFormat, typename Sampler, IQPipelineOptions Opt>
+// With Decimation > 1 the raw IQ pairs come in at Decimation times the input
+// rate of the sampler and the IQ pipeline decimates them first, see
+// make_decimating_pipeline. inputRate is always the rate of the raw pairs.
+template<typename RawFormat, typename Sampler, IQPipelineOptions Opt, size_t Decimation = 1>
 struct Preset {
     using RawFormatType = RawFormat;
     using SamplerType   = Sampler;
     using RawType       = typename RawFormat::RawType;
 
-    static constexpr SampleRate        inputRate      = SamplerType::InputSampleRate;
+    static constexpr SampleRate        inputRate      = SampleRate(SamplerType::InputSampleRate * Decimation);
     static constexpr SampleRate        outputRate     = SamplerType::OutputSampleRate;
     static constexpr IQPipelineOptions pipelineOption = Opt;
+    static constexpr size_t            decimation     = Decimation;
 };
 
 #if defined(STREAM1090_CUSTOM_INPUT) && STREAM1090_CUSTOM_INPUT
@@ -77,7 +85,12 @@ constexpr auto presets = std::make_tuple(
 
     Preset<IQ_UINT16_RAW_AIRSPY, Sampler_10_0_to_24_0_Mhz, IQPipelineOptions::NONE>{},
     Preset<IQ_UINT16_RAW_AIRSPY, Sampler_10_0_to_24_0_Mhz, IQPipelineOptions::IQ_FIR>{},
-    Preset<IQ_UINT16_RAW_AIRSPY, Sampler_10_0_to_24_0_Mhz, IQPipelineOptions::IQ_FIR_FILE>{}
+    Preset<IQ_UINT16_RAW_AIRSPY, Sampler_10_0_to_24_0_Mhz, IQPipelineOptions::IQ_FIR_FILE>{},
+
+    // 20 Mhz decimated to 10 Mhz by a half-band filter
+    Preset<IQ_UINT16_RAW_AIRSPY, Sampler_10_0_to_24_0_Mhz, IQPipelineOptions::NONE, 2>{},
+    Preset<IQ_UINT16_RAW_AIRSPY, Sampler_10_0_to_24_0_Mhz, IQPipelineOptions::IQ_FIR, 2>{},
+    Preset<IQ_UINT16_RAW_AIRSPY, Sampler_10_0_to_24_0_Mhz, IQPipelineOptions::IQ_FIR_FILE, 2>{}
 #if defined(STREAM1090_TOO_MUCH_CPU) && STREAM1090_TOO_MUCH_CPU
     ,
     // too much cpu samplers
@@ -94,38 +107,71 @@ constexpr auto presets = std::make_tuple(
 #endif
 
 
-template<SampleRate In, SampleRate Out, IQPipelineOptions sel>
+// Puts the sign flip and log2(Decimation) half-band decimators in front of the
+// stages. The sign flip moves the signal of the raw Airspy pairs to the center,
+// where the half-band filters keep it. It also moves the DC offset to the edge
+// of the band, where they remove it, hence there is no DCRemoval.
+template<size_t Decimation, typename... Stages>
+auto make_decimating_pipeline(Stages... stages) {
+    static_assert(std::has_single_bit(Decimation));
+    if constexpr (Decimation == 1)
+        return make_pipeline(FlipSigns(), std::move(stages)...);
+    else
+        return make_decimating_pipeline<Decimation / 2>(HalfBandDecimator(), std::move(stages)...);
+}
+
+template<SampleRate In, SampleRate Out, IQPipelineOptions sel, size_t Decimation = 1>
 struct IQPipelineSelector {
     static auto make(const std::vector<float>&) {
-        return make_pipeline();
+        if constexpr (Decimation == 1)
+            return make_pipeline();
+        else
+            return make_decimating_pipeline<Decimation>();
     }
 };
 
-template<SampleRate In, SampleRate Out>
-struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR> {
+template<SampleRate In, SampleRate Out, size_t Decimation>
+struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR, Decimation> {
     static auto make(const std::vector<float>&) {
-        return make_pipeline(DCRemoval(), FlipSigns(), IQLowPass<In, Out>());
+        if constexpr (Decimation == 1)
+            return make_pipeline(DCRemoval(), FlipSigns(), IQLowPass<In, Out>());
+        else
+            return make_decimating_pipeline<Decimation>(IQLowPass<In, Out>());
     }
 };
 
-template<SampleRate In, SampleRate Out>
-struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR_FILE> {
+template<SampleRate In, SampleRate Out, size_t Decimation>
+struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR_FILE, Decimation> {
     static auto make(const std::vector<float>& taps) {
-        return make_pipeline(DCRemoval(), FlipSigns(), IQLowPassDynamic(taps));
+        if constexpr (Decimation == 1)
+            return make_pipeline(DCRemoval(), FlipSigns(), IQLowPassDynamic(taps));
+        else
+            return make_decimating_pipeline<Decimation>(IQLowPassDynamic(taps));
     }
 };
 
-template<SampleRate In, SampleRate Out>
-struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR_RTL_SDR> {
+template<SampleRate In, SampleRate Out, size_t Decimation>
+struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR_RTL_SDR, Decimation> {
+    static_assert(Decimation == 1);
     static auto make(const std::vector<float>&) {
         return make_pipeline(IQLowPass<In, Out>());
     }
 };
 
-template<SampleRate In, SampleRate Out>
-struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR_RTL_SDR_FILE> {
+template<SampleRate In, SampleRate Out, size_t Decimation>
+struct IQPipelineSelector<In, Out, IQPipelineOptions::IQ_FIR_RTL_SDR_FILE, Decimation> {
+    static_assert(Decimation == 1);
     static auto make(const std::vector<float>& taps) {
         return make_pipeline(IQLowPassDynamic(taps));
     }
 };
 
+// calls f on each preset until f returns true. Returns true if one did.
+template<typename Tuple, typename F>
+constexpr bool for_each_in_tuple(const Tuple& t, F&& f) {
+    bool done = false;
+    std::apply([&](auto const&... elems) {
+        (( !done && f(elems) ? done = true : false ), ...);
+    }, t);
+    return done;
+}
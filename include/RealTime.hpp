@@ -0,0 +1,229 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "devices/IniConfig.hpp"
+
+// Real-time settings for the threads that must not fall behind: the USB
+// callback thread of the device, the DSP loop and the watchdog. Each can be
+// pinned to a CPU and run with SCHED_FIFO. The memory can be locked so the
+// DSP loop never waits for a page fault.
+//
+// The settings come from the [realtime] section of the device INI file and
+// from --rt key=value,... on the command line:
+//   usb_cpu, dsp_cpu, watchdog_cpu    CPU to pin to. A list (2:3) assigns the
+//                                     CPUs to the receivers in turn.
+//   usb_priority, dsp_priority,       SCHED_FIFO priority 1..99, 0 keeps
+//   watchdog_priority                 the default scheduler
+//   lock_memory                       lock all current and future memory
+//   huge_pages                        back the sample ring buffers with huge pages
+//
+// Failures (e.g. missing CAP_SYS_NICE) are reported but not fatal.
+namespace RealTime {
+
+    struct ThreadConfig {
+        std::vector<int> cpus;
+        int priority = 0;
+
+        bool empty() const noexcept {
+            return cpus.empty() && priority == 0;
+        }
+
+        // the CPU of the index-th thread of this kind, -1 for any
+        int cpuFor(size_t index) const noexcept {
+            return cpus.empty() ? -1 : cpus[index % cpus.size()];
+        }
+    };
+
+    struct Config {
+        ThreadConfig usb;
+        ThreadConfig dsp;
+        ThreadConfig watchdog;
+        bool lockMemory = false;
+        bool hugePages = false;
+
+        bool empty() const noexcept {
+            return usb.empty() && dsp.empty() && watchdog.empty() && !lockMemory && !hugePages;
+        }
+
+        // applies a single setting, false if the key or value is unknown
+        bool apply(const std::string& key, const std::string& value) {
+            auto toBool = [](const std::string& v) { return v == "1" || v == "true" || v == "on"; };
+            try {
+                if (key == "usb_cpu")           return parseCpus(value, usb.cpus);
+                if (key == "dsp_cpu")           return parseCpus(value, dsp.cpus);
+                if (key == "watchdog_cpu")      return parseCpus(value, watchdog.cpus);
+                if (key == "usb_priority")      return parsePriority(value, usb.priority);
+                if (key == "dsp_priority")      return parsePriority(value, dsp.priority);
+                if (key == "watchdog_priority") return parsePriority(value, watchdog.priority);
+                if (key == "lock_memory")       { lockMemory = toBool(value); return true; }
+                if (key == "huge_pages")        { hugePages = toBool(value); return true; }
+            } catch (...) {
+            }
+            return false;
+        }
+
+        bool apply(const IniConfig::Section& section) {
+            for (const auto& [key, value] : section) {
+                if (!apply(key, value))
+                    return false;
+            }
+            return true;
+        }
+
+        // key=value,key=value,...
+        bool parse(const std::string& spec) {
+            std::istringstream in(spec);
+            std::string item;
+            while (std::getline(in, item, ',')) {
+                const size_t eq = item.find('=');
+                if (eq == std::string::npos || !apply(item.substr(0, eq), item.substr(eq + 1)))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        static bool parseCpus(const std::string& value, std::vector<int>& cpus) {
+            cpus.clear();
+            std::istringstream in(value);
+            std::string item;
+            while (std::getline(in, item, ':')) {
+                const int cpu = std::stoi(item);
+                if (cpu < 0 || cpu >= CPU_SETSIZE)
+                    return false;
+                cpus.push_back(cpu);
+            }
+            return !cpus.empty();
+        }
+
+        static bool parsePriority(const std::string& value, int& priority) {
+            priority = std::stoi(value);
+            return priority >= 0 && priority <= 99;
+        }
+    };
+
+    // what the thread actually got, e.g. "cpu 2, SCHED_FIFO 50"
+    inline std::string describeThread(pthread_t thread = pthread_self()) {
+        std::ostringstream out;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (pthread_getaffinity_np(thread, sizeof(set), &set) == 0) {
+            const int count = CPU_COUNT(&set);
+            if (count == 1 || count < sysconf(_SC_NPROCESSORS_ONLN)) {
+                out << "cpu";
+                for (int i = 0; i < CPU_SETSIZE; i++) {
+                    if (CPU_ISSET(i, &set))
+                        out << " " << i;
+                }
+            } else {
+                out << "any cpu";
+            }
+        }
+
+        int policy = 0;
+        sched_param param{};
+        if (pthread_getschedparam(thread, &policy, &param) == 0) {
+            if (policy == SCHED_FIFO)
+                out << ", SCHED_FIFO " << param.sched_priority;
+            else if (policy == SCHED_RR)
+                out << ", SCHED_RR " << param.sched_priority;
+            else
+                out << ", SCHED_OTHER";
+        }
+        return out.str();
+    }
+
+    // Pins the thread and sets its priority. Returns a line for the log that
+    // tells what was requested, what failed and what the thread got.
+    inline std::string configureThread(const std::string& name, const ThreadConfig& config, size_t index = 0,
+                                       pthread_t thread = pthread_self()) {
+        std::ostringstream out;
+        out << "[Stream1090] Thread " << name << ": ";
+
+        const int cpu = config.cpuFor(index);
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (const int rc = pthread_setaffinity_np(thread, sizeof(set), &set); rc != 0)
+                out << "pinning to cpu " << cpu << " failed (" << std::strerror(rc) << "), ";
+        }
+
+        if (config.priority > 0) {
+            sched_param param{};
+            param.sched_priority = config.priority;
+            if (const int rc = pthread_setschedparam(thread, SCHED_FIFO, &param); rc != 0)
+                out << "SCHED_FIFO " << config.priority << " failed (" << std::strerror(rc) << "), ";
+        }
+
+        out << describeThread(thread);
+        return out.str();
+    }
+
+    // mlockall for the current and all future mappings. Pages are faulted in right away.
+    inline std::string lockMemory() {
+        if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            return std::string("[Stream1090] Locking memory failed (") + std::strerror(errno)
+                   + "), check ulimit -l";
+        return "[Stream1090] Memory locked";
+    }
+
+    // Prepares a large buffer: asks for huge pages for the part that covers whole
+    // huge pages and faults all pages in, so the first pass of the DSP loop
+    // does not pay for it. Returns the number of bytes advised for huge pages.
+    inline size_t prepareBuffer(void* data, size_t bytes, bool hugePages) {
+        size_t advised = 0;
+#ifdef MADV_HUGEPAGE
+        if (hugePages) {
+            constexpr uintptr_t HugePageSize = uintptr_t(2) << 20;
+            const uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + HugePageSize - 1) & ~(HugePageSize - 1);
+            const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + bytes) & ~(HugePageSize - 1);
+            if (end > begin && ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0)
+                advised = end - begin;
+        }
+#endif
+        // touch every page
+        const long pageSize = sysconf(_SC_PAGESIZE);
+        volatile uint8_t* p = static_cast<uint8_t*>(data);
+        for (size_t i = 0; i < bytes; i += size_t(pageSize)) {
+            p[i] = p[i];
+        }
+        return advised;
+    }
+
+    struct PageFaults {
+        long minor = 0;
+        long major = 0;
+
+        static PageFaults now() {
+            rusage usage{};
+            ::getrusage(RUSAGE_SELF, &usage);
+            return PageFaults{ usage.ru_minflt, usage.ru_majflt };
+        }
+
+        PageFaults operator-(const PageFaults& other) const {
+            return PageFaults{ minor - other.minor, major - other.major };
+        }
+    };
+
+} // end of namespace RealTime
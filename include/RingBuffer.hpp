@@ -128,6 +128,8 @@ public:
     // that no more data will bee written later. Returns 0 in that case.
     size_t waitForNewBlocks() noexcept {
         std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_shutdown && m_numFullBlocks == 0)
+            m_numReaderWaits++;
         m_condVar.wait(lock, [&]{
             return m_shutdown || m_numFullBlocks > 0;
         });
@@ -143,6 +145,8 @@ public:
     size_t waitForSpace(size_t desiredBlocks) noexcept {
         
         std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_shutdown && (NumBlocks - m_numFullBlocks) <= desiredBlocks)
+            m_numWriterWaits++;
         m_condVar.wait(lock, [&]{
             //std::cerr << "Waiting for desired Blocks " << desiredBlocks << " full "<< m_numFullBlocks << std::endl;
             return m_shutdown || (NumBlocks - m_numFullBlocks) > desiredBlocks;
@@ -156,12 +160,28 @@ public:
         return m_numFullBlocks;
     }
 
+    // how often the reader found the buffer empty and had to wait for the writer
+    size_t getNumReaderWaits() const noexcept {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numReaderWaits;
+    }
+
+    // how often the writer found the buffer full and had to wait for the reader
+    size_t getNumWriterWaits() const noexcept {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numWriterWaits;
+    }
+
 private:
     // number of unread full blocks
     size_t m_numFullBlocks;
     
     // signals that no more data will be written (error or end of file)        
     bool   m_shutdown;
+
+    // see getNumReaderWaits and getNumWriterWaits
+    size_t m_numReaderWaits = 0;
+    size_t m_numWriterWaits = 0;
     
     // mutex to protected the two above variables             
     mutable std::mutex m_mutex;
@@ -192,13 +212,17 @@ class RingBufferAsyncReader {
         return m_numFullBlocks == 0;
     }
 
+    // calls processingFunc(first, n) on the next n <= maxBlocks full blocks. These are
+    // consecutive in memory, hence n stops at the end of the buffer. Returns n.
     template<typename ProcessingFunc>
-    void process(ProcessingFunc processingFunc) noexcept {
-        if (m_numFullBlocks > 0) {
-            processingFunc(m_ring.begin(m_readBlockIndex));
-            m_readBlockIndex = (m_readBlockIndex + 1) % NumBlocks;
-            m_numFullBlocks = m_ring.consumeBlocks(1);
+    size_t process(size_t maxBlocks, ProcessingFunc processingFunc) noexcept {
+        const size_t n = std::min({ maxBlocks, m_numFullBlocks, NumBlocks - m_readBlockIndex });
+        if (n > 0) {
+            processingFunc(m_ring.begin(m_readBlockIndex), n);
+            m_readBlockIndex = (m_readBlockIndex + n) % NumBlocks;
+            m_numFullBlocks = m_ring.consumeBlocks(n);
         }
+        return n;
     }
     
     private:
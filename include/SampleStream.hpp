@@ -12,26 +12,34 @@
 #include <iostream>
 #include <memory>
 #include <cstring>
+#include <type_traits>
 
 #include "DemodCore.hpp"
 #include "Sampler.hpp"
 #include "MessageHandler.hpp"
+#include "BitCapture.hpp"
+#include "FusedSlicer.hpp"
+#include "CpuDispatch.hpp"
 
 #pragma once
 #include <memory>
 #include <cstring>
 #include <algorithm>
 
-template<typename T, size_t BlockSize, size_t NumBlocks, size_t Delay = 0>
+// Ring of blocks where each block is preceded by the last Delay elements of
+// the previous one. The blocks may be smaller than MaxBlockSize, see setBlockSize.
+template<typename T, size_t MaxBlockSize, size_t NumBlocks, size_t Delay = 0>
 class BlockRing {
 public:
-    static constexpr size_t TotalSize = BlockSize * NumBlocks + Delay;
+    static constexpr size_t TotalSize = MaxBlockSize * NumBlocks + Delay;
 
     BlockRing(const T& initValue)
         : m_data(
             new (std::align_val_t(16)) T[TotalSize],   // aligned allocation
             AlignedDeleter{}                           // matching deleter
         ),
+          m_blockSize(MaxBlockSize),
+          m_wrapSize(TotalSize - Delay),
           m_readPos(0),
           m_writePos(Delay),
           m_fullBlocks(0)
@@ -39,21 +47,32 @@ public:
         std::fill(m_data.get(), m_data.get() + TotalSize, initValue);
     }
 
+    // sets the size of the blocks, at most MaxBlockSize. Only before the first block is written.
+    void setBlockSize(size_t blockSize) noexcept {
+        m_blockSize = std::min(blockSize, MaxBlockSize);
+    }
+
+    size_t blockSize() const noexcept {
+        return m_blockSize;
+    }
+
     T* writePos() noexcept {
         return m_data.get() + m_writePos;
     }
 
     void advanceWritePos() noexcept {
-        m_writePos += BlockSize;
+        m_writePos += m_blockSize;
 
-        if (m_writePos + BlockSize > TotalSize) {
+        if (m_writePos + m_blockSize > TotalSize) {
+            // the next block is written at the front, after the copy of the last Delay elements
             if constexpr (Delay > 0) {
                 std::memcpy(
                     m_data.get(),
-                    m_data.get() + (TotalSize - Delay),
+                    m_data.get() + (m_writePos - Delay),
                     Delay * sizeof(T)
                 );
             }
+            m_wrapSize = m_writePos - Delay;
             m_writePos = Delay;
         }
 
@@ -65,9 +84,9 @@ public:
     }
 
     void advanceReadPos() noexcept {
-        m_readPos += BlockSize;
+        m_readPos += m_blockSize;
 
-        if (m_readPos >= BlockSize * NumBlocks) {
+        if (m_readPos + m_blockSize + Delay > TotalSize) {
             m_readPos = 0;
         }
 
@@ -83,15 +102,16 @@ public:
     }
 
     const T& lookBack(size_t k, size_t offsetInBlock = 0) const noexcept {
-        size_t absoluteIndex = m_readPos + offsetInBlock;
-        if (absoluteIndex >= TotalSize)
-            absoluteIndex -= TotalSize;
-
-        size_t lookBackIndex = absoluteIndex + TotalSize - k;
-        if (lookBackIndex >= TotalSize)
-            lookBackIndex -= TotalSize;
+        return atReadOffset(ptrdiff_t(offsetInBlock) - ptrdiff_t(k));
+    }
 
-        return m_data[lookBackIndex];
+    // element at offset relative to the read position. A negative offset reaches
+    // into the previous block, which precedes the delay copy at the end of the buffer
+    const T& atReadOffset(ptrdiff_t offset) const noexcept {
+        ptrdiff_t index = ptrdiff_t(m_readPos) + offset;
+        if (index < 0)
+            index += ptrdiff_t(m_wrapSize);
+        return m_data[size_t(index)];
     }
 
 private:
@@ -103,6 +123,9 @@ private:
 
     std::unique_ptr<T[], AlignedDeleter> m_data;
 
+    size_t m_blockSize;
+    // where the stream continues before the front copy, i.e. the end of the last block before it
+    size_t m_wrapSize;
     size_t m_readPos;
     size_t m_writePos;
     size_t m_fullBlocks;
@@ -120,26 +143,99 @@ public:
     static constexpr size_t NumSampleBuffers = 2;
     static constexpr size_t TotalSampleBufferLength = NumSampleBuffers * Sampler::SampleBufferSize + Sampler::SampleBufferOverlap;
 
-    SampleStream() : m_inputRingBuffer(0.0f), m_sampleRingBuffer(0.0f) { }
+    // Resampling with a linear interpolating sampler is fused with the slicer,
+    // see FusedSlicer. There is no buffer for the upsampled magnitudes then.
+    static constexpr bool UseFusedSlicer = !Sampler::isPassthrough && Sampler::InputBufferOverlap == 1;
+    // if the block size can be chosen at runtime, see setBlockSize
+    static constexpr bool SupportsBlockSize = Sampler::isPassthrough || UseFusedSlicer;
+    // With many streams the demodulator may run only 8 evenly spaced coarse
+    // phases and refine the others on demand, see DemodCore and setCoarsePhases
+    static constexpr int CoarsePhaseStep = coarsePhaseStep(Sampler::NumStreams);
+    static constexpr bool SupportsCoarsePhases = CoarsePhaseStep > 1;
+
+    SampleStream() : m_inputRingBuffer(0.0f) {
+        if constexpr (!UseFusedSlicer) {
+            m_sampleRingBuffer = std::make_unique<SampleRing>(0.0f);
+        }
+    }
    
     // the main method that streams from InputStream using inputReader
     template<typename InputReaderType, MessageHandler Handler>
-    void read(InputReaderType& inputReader, Handler& messageHandler);
+    void read(InputReaderType& inputReader, Handler& messageHandler) {
+        if constexpr (SupportsCoarsePhases) {
+            if (m_coarsePhases) {
+                readDispatch<CoarsePhaseStep>(inputReader, messageHandler);
+                return;
+            }
+        }
+        readDispatch<1>(inputReader, messageHandler);
+    }
+
+    // Only the coarse phases are demodulated continuously, the others around a
+    // likely frame. Returns false if the sampler has too few streams. Call before read().
+    bool setCoarsePhases(bool enabled) noexcept {
+        m_coarsePhases = enabled && SupportsCoarsePhases;
+        return m_coarsePhases == enabled;
+    }
+
+    // Sets the number of input samples processed at once, see Sampler::InputBlockGranularity.
+    // Smaller blocks mean less delay and a smaller working set. Only the passthrough
+    // and the fused samplers support it, the others always take Sampler::InputBufferSize.
+    // Returns the block size in use. Call before read().
+    size_t setBlockSize(size_t numInputSamples) noexcept {
+        if constexpr (SupportsBlockSize) {
+            constexpr size_t G = Sampler::InputBlockGranularity;
+            m_blockSize = std::clamp(numInputSamples / G * G, G, Sampler::InputBufferSize);
+            m_inputRingBuffer.setBlockSize(m_blockSize);
+            if constexpr (Sampler::isPassthrough) {
+                m_sampleRingBuffer->setBlockSize(m_blockSize);
+            }
+        }
+        return m_blockSize;
+    }
+
+    size_t blockSize() const noexcept {
+        return m_blockSize;
+    }
+
+    // if set, every tick of slicer bits and its RSSI is also written to the capture
+    void setBitCapture(BitCapture::Writer<Sampler::NumStreams>* bitCapture) noexcept {
+        m_bitCapture = bitCapture;
+    }
+
+    // the demodulator shares its trusted addresses with other receivers
+    void setSharedTrustView(SharedTrustView* shared) noexcept {
+        m_sharedTrustView = shared;
+    }
 
     uint8_t getRSSI() const noexcept {
         // we are 128 bits behind and are looking for the preamble pulse
         constexpr size_t bitDelay     = 128 - 8;
         // how much is that in samples?
         constexpr size_t samplesDelay = bitDelay * Sampler::NumStreams;
-        // how far is the demodulator in the block?
-        const auto offsetInBlock = m_demodPos - m_sampleRingBuffer.readPos();
         // check the rssi of the surounding samples. This index is the first to
         // catch the message, usually with bad RSSI
         float rssi = 0.0f;
-        for (size_t s = 0; s < Sampler::NumStreams; s++) {
-            float v = std::max(m_sampleRingBuffer.lookBack(samplesDelay + s, offsetInBlock), 
-                               m_sampleRingBuffer.lookBack(samplesDelay + s - (Sampler::NumStreams >> 1), offsetInBlock));
-            rssi = std::max(rssi, v);
+        if constexpr (UseFusedSlicer) {
+            // the upsampled magnitudes are recomputed from the input ring. Positions are relative
+            // to the current group, the first compared output of the tick is NumStreams / 2 before it
+            const ptrdiff_t groupOffset = ptrdiff_t(m_fusedGroup * FusedSlicer<Sampler>::InputsPerGroup);
+            const auto input = [&](ptrdiff_t i) { return m_inputRingBuffer.atReadOffset(groupOffset + i); };
+            const ptrdiff_t demodPos = ptrdiff_t(m_fusedTick * Sampler::NumStreams) - ptrdiff_t(Sampler::NumStreams >> 1);
+            for (size_t s = 0; s < Sampler::NumStreams; s++) {
+                const ptrdiff_t y = demodPos - ptrdiff_t(samplesDelay + s);
+                float v = std::max(m_fusedSlicer.output(y, input),
+                                   m_fusedSlicer.output(y + ptrdiff_t(Sampler::NumStreams >> 1), input));
+                rssi = std::max(rssi, v);
+            }
+        } else {
+            // how far is the demodulator in the block?
+            const auto offsetInBlock = m_demodPos - m_sampleRingBuffer->readPos();
+            for (size_t s = 0; s < Sampler::NumStreams; s++) {
+                float v = std::max(m_sampleRingBuffer->lookBack(samplesDelay + s, offsetInBlock), 
+                                   m_sampleRingBuffer->lookBack(samplesDelay + s - (Sampler::NumStreams >> 1), offsetInBlock));
+                rssi = std::max(rssi, v);
+            }
         }
         // normalize
         rssi = std::min(1.41f, rssi) / 1.41f;
@@ -148,24 +244,80 @@ public:
     }
 
 private:
+    template<int PhaseStep, typename InputReaderType, MessageHandler Handler>
+    void readDispatch(InputReaderType& inputReader, Handler& messageHandler) {
+        // the loop is compiled for each instruction set, see CpuDispatch
+        switch (CpuDispatch::selected()) {
+            case CpuDispatch::Isa::AVX512: readAVX512<PhaseStep>(inputReader, messageHandler); break;
+            case CpuDispatch::Isa::AVX2:   readAVX2<PhaseStep>(inputReader, messageHandler);   break;
+            default:                       readLoop<PhaseStep>(inputReader, messageHandler);   break;
+        }
+    }
+
+    template<int PhaseStep, typename InputReaderType, MessageHandler Handler>
+    STREAM1090_FORCE_INLINE void readLoop(InputReaderType& inputReader, Handler& messageHandler);
+
+    template<int PhaseStep, typename InputReaderType, MessageHandler Handler>
+    STREAM1090_TARGET_AVX2 void readAVX2(InputReaderType& inputReader, Handler& messageHandler) {
+        readLoop<PhaseStep>(inputReader, messageHandler);
+    }
+
+    template<int PhaseStep, typename InputReaderType, MessageHandler Handler>
+    STREAM1090_TARGET_AVX512 void readAVX512(InputReaderType& inputReader, Handler& messageHandler) {
+        readLoop<PhaseStep>(inputReader, messageHandler);
+    }
+
+    using SampleRing = BlockRing<float, Sampler::SampleBufferSize, NumSampleBuffers, Sampler::SampleBufferOverlap>;
+
     uint32_t m_newBits[Sampler::NumStreams];    
+    // number of input samples per block
+    size_t m_blockSize = Sampler::InputBufferSize;
     // we have one ring buffer for the IQ pipeline
     BlockRing<float, Sampler::InputBufferSize,  NumInputBuffers,  Sampler::InputBufferOverlap>  m_inputRingBuffer;
-    // and one for the upsampled magnitudes
-    BlockRing<float, Sampler::SampleBufferSize, NumSampleBuffers, Sampler::SampleBufferOverlap> m_sampleRingBuffer;
+    // and one for the upsampled magnitudes, unless the sampler is fused with the slicer
+    std::unique_ptr<SampleRing> m_sampleRingBuffer;
     // not nice. Will change
     const float* m_demodPos = nullptr;
+    // the fused slicer and where it is in the current block
+    struct NoFusedSlicer {};
+    std::conditional_t<UseFusedSlicer, FusedSlicer<Sampler>, NoFusedSlicer> m_fusedSlicer;
+    size_t m_fusedGroup = 0;
+    size_t m_fusedTick = 0;
+    // optional capture of the demodulated bits
+    BitCapture::Writer<Sampler::NumStreams>* m_bitCapture = nullptr;
+    // optional trust view shared with other receivers
+    SharedTrustView* m_sharedTrustView = nullptr;
+    // demodulate the coarse phases only, see setCoarsePhases
+    bool m_coarsePhases = false;
 };
 
 
 template<typename Sampler>
-template<typename InputReaderType, MessageHandler Handler>
-inline void SampleStream<Sampler>::read(InputReaderType& inputReader, Handler& messageHandler) {  
+template<int PhaseStep, typename InputReaderType, MessageHandler Handler>
+STREAM1090_FORCE_INLINE void SampleStream<Sampler>::readLoop(InputReaderType& inputReader, Handler& messageHandler) {  
     // the core logic for message recognition
-    DemodCore<Sampler::NumStreams, Handler> demodCore(messageHandler);
+    DemodCore<Sampler::NumStreams, Handler, DefaultDemodPolicy, PhaseStep> demodCore(messageHandler);
+    demodCore.setSharedTrustView(m_sharedTrustView);
+
+    // hands the bits of one tick to the demodulator
+    const auto demodTick = [&]() {
+        // record the bits before the demodulator sees them. The RSSI is taken
+        // here, which is the same value a handler would get for this tick.
+        if (m_bitCapture) {
+            m_bitCapture->push(m_newBits, getRSSI());
+        }
+        // and tell the demodulator to deal with the new bits
+        demodCore.shiftInNewBits(m_newBits);
+    };
 
      // the main loop for reading the stream
     while (!inputReader.eof()) {
+        // the time between two recordings that is not in the stream, see FdReadAhead
+        if constexpr (requires { inputReader.takeGap(); }) {
+            if (const uint64_t gap = inputReader.takeGap(); gap > 0)
+                demodCore.skip(gap * Sampler::RatioOutput / Sampler::RatioInput);
+        }
+
         // the read and write positions for the current sample buffer based its index.
         // we start reading at 0 + i * size           
         // however, new values will be written NumStream / 2 later which is the overlap. 
@@ -175,26 +327,46 @@ inline void SampleStream<Sampler>::read(InputReaderType& inputReader, Handler& m
             // we will directly read into the samples buffer. There is no need for using the sampler at all.
             // This works because the amount the input reader is getting us in this particular case is exactly the ChunkSize
             static_assert(Sampler::NumBlocks == Sampler::InputBufferSize);
-            inputReader.readMagnitude(m_sampleRingBuffer.writePos());
-            m_sampleRingBuffer.advanceWritePos();
+            inputReader.readMagnitude(m_sampleRingBuffer->writePos(), m_blockSize);
+            m_sampleRingBuffer->advanceWritePos();
+        } else if constexpr (UseFusedSlicer) {
+            inputReader.readMagnitude(m_inputRingBuffer.writePos(), m_blockSize);
+            m_inputRingBuffer.advanceWritePos();
+            if (m_inputRingBuffer.isReadable()) {
+                // the slicer works on the input magnitudes directly
+                const float* groupPos = m_inputRingBuffer.readPos();
+                const size_t numGroups = m_blockSize / FusedSlicer<Sampler>::InputsPerGroup;
+                for (m_fusedGroup = 0; m_fusedGroup < numGroups; m_fusedGroup++) {
+                    for (m_fusedTick = 0; m_fusedTick < FusedSlicer<Sampler>::TicksPerGroup; m_fusedTick++) {
+                        m_fusedSlicer.slice(groupPos, m_fusedTick, m_newBits);
+                        demodTick();
+                    }
+                    groupPos += FusedSlicer<Sampler>::InputsPerGroup;
+                }
+                m_inputRingBuffer.advanceReadPos();
+            }
+            // there is no sample ring buffer to slice
+            continue;
         } else {
             // tell the input reader to get us some data. Directly as magnitude.
-            inputReader.readMagnitude(m_inputRingBuffer.writePos());
+            inputReader.readMagnitude(m_inputRingBuffer.writePos(), m_blockSize);
             m_inputRingBuffer.advanceWritePos();
             // now ask the Sampler to resample the input magnitude to the output samples
             // similar to the input buffer, write after the overlap to keep some old values for the next iteration
             if (m_inputRingBuffer.isReadable()) {
-                Sampler::sample(m_inputRingBuffer.readPos(), m_sampleRingBuffer.writePos());
+                Sampler::sample(m_inputRingBuffer.readPos(), m_sampleRingBuffer->writePos());
                 m_inputRingBuffer.advanceReadPos();
-                m_sampleRingBuffer.advanceWritePos();
+                m_sampleRingBuffer->advanceWritePos();
             }
         }
         
 
-        if (m_sampleRingBuffer.isReadable()) {
-            m_demodPos = m_sampleRingBuffer.readPos();
+        if (m_sampleRingBuffer->isReadable()) {
+            m_demodPos = m_sampleRingBuffer->readPos();
+            // a passthrough block may be smaller, see setBlockSize
+            const size_t numSamples = Sampler::isPassthrough ? m_blockSize : Sampler::SampleBufferSize;
             // extract phase shifted bits using manchester encoding
-            for (size_t i = 0; i < Sampler::SampleBufferSize; i += Sampler::NumStreams) {
+            for (size_t i = 0; i < numSamples; i += Sampler::NumStreams) {
                 for (size_t j = 0; j < Sampler::NumStreams; j++) {
                     // Think of having a sample stream of 2Mhz (so what we get from the planes)
                     // stream 0 << compare 0 and 1 
@@ -207,12 +379,11 @@ inline void SampleStream<Sampler>::read(InputReaderType& inputReader, Handler& m
                     m_newBits[j] = m_demodPos[j] > m_demodPos[j + (Sampler::NumStreams >> 1)]; 
                     //m_sampleReadPos[i + j] > sampleReadPos[i + j + Sampler::SampleBufferOverlap];  
                 }
-                // and tell the demodulator to deal with the new bits
-                demodCore.shiftInNewBits(m_newBits);
+                demodTick();
                 // advance the readpos
                 m_demodPos += Sampler::NumStreams;
             }
-            m_sampleRingBuffer.advanceReadPos();
+            m_sampleRingBuffer->advanceReadPos();
         }
     }
-}
+}
\ No newline at end of file
@@ -143,6 +143,13 @@ class SamplerBase {
     static constexpr size_t InputBufferOverlap  = _InputBufferOverlap;
     static constexpr size_t SampleBufferOverlap = SampleBlockSize;
 
+    // The buffer sizes above are the largest block that is processed at once. At runtime
+    // a smaller block may be chosen (see SampleStream::setBlockSize) which has to be a
+    // multiple of this many input samples. It maps to a whole number of ticks of all streams.
+    static constexpr size_t InputBlockGranularity = RatioInput * NumStreams;
+    static constexpr size_t NumInputGranules = InputBufferSize / InputBlockGranularity;
+    static_assert(InputBufferSize % InputBlockGranularity == 0);
+
     // if the input equals the output sample rate
     static constexpr bool isPassthrough = (InputSampleRate == OutputSampleRate);
 
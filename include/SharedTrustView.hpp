@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Addresses trusted by any of the receivers running in this process.
+// Every receiver has its own ICAOTable. When a receiver trusts an address
+// (DF17 with a good crc), it publishes it here. The tables of the other
+// receivers fall back to this view when they do not know an address, so a
+// DF17 received on one antenna unlocks the Comm-B and surveillance replies
+// of the same plane on the other one.
+//
+// Lock free: one relaxed 64-bit atomic per slot, same hashing as ICAOTable.
+// A slot holds the address including CA and the time in milliseconds (on the
+// clock of the publishing receiver) it was published.
+class SharedTrustView {
+public:
+    static constexpr auto NumBits { 16 };
+    static constexpr auto Size { 0x1 << NumBits };
+    static constexpr uint32_t HashMask { (0x1 << NumBits) - 1 };
+
+    SharedTrustView() : m_slots(std::make_unique<std::atomic<uint64_t>[]>(Size)) {
+        for (size_t i = 0; i < Size; i++) {
+            m_slots[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void publish(uint32_t icaoWithCA, uint32_t millis) noexcept {
+        m_slots[icaoWithCA & HashMask].store((uint64_t(millis) << 32) | icaoWithCA, std::memory_order_relaxed);
+    }
+
+    // Looks up the slot of icao. Returns the address with CA that was
+    // published there (0 if none) and the time it was published.
+    uint32_t lookup(uint32_t icao, uint32_t& millis) const noexcept {
+        const uint64_t v = m_slots[icao & HashMask].load(std::memory_order_relaxed);
+        millis = uint32_t(v >> 32);
+        return uint32_t(v);
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> m_slots;
+};
@@ -9,6 +9,7 @@
 
 #include "Bits128.hpp"
 #include "CRC.hpp"
+#include "CpuDispatch.hpp"
 
 template<int NumStreams>
 class alignas(16) ShiftRegistersBase {
@@ -56,7 +57,7 @@ class alignas(16) ShiftRegisters : public ShiftRegistersBase<NumStreams> {
     public:
         constexpr ShiftRegisters() : ShiftRegistersBase<NumStreams>() { }
 
-        constexpr void shiftInNewBits(const uint32_t* cmp) noexcept {
+        STREAM1090_FORCE_INLINE constexpr void shiftInNewBits(const uint32_t* cmp) noexcept {
             for (auto i = 0; i < NumStreams; i++) {
                 // check if we shift out the msb 
                 if (this->m_df[i] > 0xf) {
@@ -85,6 +86,17 @@ class alignas(16) ShiftRegisters : public ShiftRegistersBase<NumStreams> {
             }
         }
 
+        // Replaces stream i by the given 128 bits, e.g. a phase that was not
+        // shifted in. The crc's are computed from scratch, same values as the
+        // ones shifting in these bits one by one would have.
+        constexpr void loadStream(auto i, uint64_t high, uint64_t low) noexcept {
+            this->m_high[i] = high;
+            this->m_low[i] = low;
+            this->m_df[i] = high >> 59;
+            this->m_crc_56[i] = CRC::compute<56>(Bits128(high >> 8));
+            this->m_crc_112[i] = CRC::compute<112>(extractAlignedFrameLong(i));
+        }
+
         constexpr Bits128 extractAlignedFrameLong(auto i) const noexcept {
             return Bits128(this->m_high[i] >> 16, (this->m_low[i] >> 16) | (this->m_high[i] << 48));
         }
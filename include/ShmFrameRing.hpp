@@ -0,0 +1,297 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Bits128.hpp"
+
+// A ring of frames in POSIX shared memory. stream1090 is the only writer, any
+// number of local processes may map the ring read-only and poll it. The writer
+// never waits for a reader. A reader that is too slow is lapped and notices it.
+//
+// Layout of the shared memory object:
+//   Header
+//   Slot[capacity]
+//
+// Frame n (counting from 0) goes into slot n % capacity. Every slot has its own
+// sequence number: 2n + 1 while frame n is written, 2n + 2 when it is complete.
+// A reader that expects frame n reads the sequence number, the payload and the
+// sequence number again. Only if both are 2n + 2 the payload is frame n. All
+// fields are atomics, so readers never see torn words.
+namespace ShmFrameRing {
+
+    static constexpr uint64_t Magic = 0x474e495230393031ull; // "1090RING"
+    static constexpr uint32_t Version = 1;
+    static constexpr uint32_t DefaultCapacity = 1 << 16;
+
+    // flags in the upper byte of Slot::high
+    static constexpr uint64_t FlagLong = 0x1;
+
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        // number of slots, a power of two
+        uint32_t capacity;
+        // number of frames written so far
+        std::atomic<uint64_t> writeCount;
+        uint64_t reserved[5];
+    };
+    static_assert(sizeof(Header) == 64);
+
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        // MLAT timestamp (12 MHz)
+        std::atomic<uint64_t> mlat;
+        // upper 48 bits of a long frame | rssi << 48 | flags << 56
+        std::atomic<uint64_t> high;
+        // lower 64 bits of a long frame or the 56-bit short frame
+        std::atomic<uint64_t> low;
+    };
+    static_assert(sizeof(Slot) == 32);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+    // a frame as read from the ring
+    struct Frame {
+        uint64_t index;
+        uint64_t mlat;
+        Bits128 frame;
+        uint8_t rssi;
+        bool isLong;
+    };
+
+    inline size_t mappingSize(uint32_t capacity) {
+        return sizeof(Header) + size_t(capacity) * sizeof(Slot);
+    }
+
+    // Creates the shared memory object and publishes frames into it
+    class Writer {
+    public:
+        ~Writer() {
+            close();
+        }
+
+        // name as for shm_open, e.g. "/stream1090". capacity is rounded up to a power of two.
+        bool open(const std::string& name, uint32_t capacity = DefaultCapacity) {
+            uint32_t c = 1;
+            while (c < capacity)
+                c <<= 1;
+
+            const int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+            if (fd < 0)
+                return false;
+
+            const size_t size = mappingSize(c);
+            if (::ftruncate(fd, off_t(size)) != 0) {
+                ::close(fd);
+                return false;
+            }
+
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED)
+                return false;
+
+            m_name = name;
+            m_size = size;
+            m_header = static_cast<Header*>(p);
+            m_slots = reinterpret_cast<Slot*>(static_cast<char*>(p) + sizeof(Header));
+            m_mask = c - 1;
+
+            // invalidate everything a previous run left behind before the magic is set
+            m_header->magic = 0;
+            std::atomic_thread_fence(std::memory_order_release);
+            for (uint32_t i = 0; i < c; i++) {
+                m_slots[i].seq.store(0, std::memory_order_relaxed);
+            }
+            m_header->writeCount.store(0, std::memory_order_relaxed);
+            m_header->version = Version;
+            m_header->capacity = c;
+            std::atomic_thread_fence(std::memory_order_release);
+            m_header->magic = Magic;
+            m_count = 0;
+            return true;
+        }
+
+        bool isOpen() const noexcept {
+            return m_header != nullptr;
+        }
+
+        // The shared memory object is removed, readers that have it mapped keep their mapping
+        void close() {
+            if (!m_header)
+                return;
+            ::munmap(m_header, m_size);
+            ::shm_unlink(m_name.c_str());
+            m_header = nullptr;
+            m_slots = nullptr;
+        }
+
+        void push(uint64_t mlat, const Bits128& frame, uint8_t rssi, bool isLong) noexcept {
+            const uint64_t n = m_count++;
+            Slot& slot = m_slots[n & m_mask];
+
+            slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            slot.mlat.store(mlat, std::memory_order_relaxed);
+            slot.high.store((frame.high() & 0xffffffffffffull) | (uint64_t(rssi) << 48)
+                            | ((isLong ? FlagLong : 0) << 56), std::memory_order_relaxed);
+            slot.low.store(frame.low(), std::memory_order_relaxed);
+
+            slot.seq.store(2 * n + 2, std::memory_order_release);
+            m_header->writeCount.store(n + 1, std::memory_order_release);
+        }
+
+    private:
+        std::string m_name;
+        size_t m_size = 0;
+        Header* m_header = nullptr;
+        Slot* m_slots = nullptr;
+        uint64_t m_mask = 0;
+        uint64_t m_count = 0;
+    };
+
+    // Maps the ring read-only and polls it. Does not touch the shared memory,
+    // so readers do not disturb the writer or each other.
+    class Reader {
+    public:
+        enum class Result {
+            // frame holds the next frame
+            Ok,
+            // nothing new
+            Empty,
+            // the writer overwrote frames before we read them. The reader
+            // continues with the oldest frame in the ring, lost says how many were skipped.
+            Lapped
+        };
+
+        ~Reader() {
+            close();
+        }
+
+        // Attaches to the ring. Starts with the next frame written unless fromOldest is set.
+        bool open(const std::string& name, bool fromOldest = false) {
+            const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+                ::close(fd);
+                return false;
+            }
+
+            void* p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED)
+                return false;
+
+            m_size = size_t(st.st_size);
+            m_header = static_cast<const Header*>(p);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_header->magic != Magic || m_header->version != Version
+                || mappingSize(m_header->capacity) > m_size) {
+                close();
+                return false;
+            }
+
+            m_slots = reinterpret_cast<const Slot*>(static_cast<const char*>(p) + sizeof(Header));
+            m_capacity = m_header->capacity;
+            const uint64_t count = writeCount();
+            m_next = fromOldest ? oldest(count) : count;
+            return true;
+        }
+
+        void close() {
+            if (!m_header)
+                return;
+            ::munmap(const_cast<Header*>(m_header), m_size);
+            m_header = nullptr;
+            m_slots = nullptr;
+        }
+
+        uint32_t capacity() const noexcept { return m_capacity; }
+
+        // number of frames written so far
+        uint64_t writeCount() const noexcept {
+            return m_header->writeCount.load(std::memory_order_acquire);
+        }
+
+        // index of the frame the next call to poll will return
+        uint64_t next() const noexcept { return m_next; }
+
+        Result poll(Frame& out, uint64_t& lost) noexcept {
+            lost = 0;
+            const uint64_t count = writeCount();
+            if (m_next >= count)
+                return Result::Empty;
+
+            if (count - m_next > m_capacity) {
+                const uint64_t o = oldest(count);
+                lost = o - m_next;
+                m_next = o;
+                return Result::Lapped;
+            }
+
+            const Slot& slot = m_slots[m_next & (m_capacity - 1)];
+            const uint64_t expected = 2 * m_next + 2;
+            const uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+            if (s1 != expected) {
+                // the writer is already writing frame m_next + capacity or later into this slot
+                if (s1 > expected)
+                    return lapped(lost);
+                return Result::Empty;
+            }
+
+            out.mlat = slot.mlat.load(std::memory_order_relaxed);
+            const uint64_t high = slot.high.load(std::memory_order_relaxed);
+            const uint64_t low = slot.low.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != expected)
+                return lapped(lost);
+
+            out.index = m_next;
+            out.frame = Bits128(high & 0xffffffffffffull, low);
+            out.rssi = uint8_t(high >> 48);
+            out.isLong = ((high >> 56) & FlagLong) != 0;
+            m_next++;
+            return Result::Ok;
+        }
+
+    private:
+        uint64_t oldest(uint64_t count) const noexcept {
+            return (count > m_capacity) ? count - m_capacity : 0;
+        }
+
+        Result lapped(uint64_t& lost) noexcept {
+            // leave some room, the writer is right behind us
+            const uint64_t o = oldest(writeCount()) + (m_capacity >> 4);
+            lost = (o > m_next) ? o - m_next : 0;
+            m_next = std::max(o, m_next + 1);
+            return Result::Lapped;
+        }
+
+        size_t m_size = 0;
+        const Header* m_header = nullptr;
+        const Slot* m_slots = nullptr;
+        uint32_t m_capacity = 0;
+        uint64_t m_next = 0;
+    };
+
+} // end of namespace ShmFrameRing
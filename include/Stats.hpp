@@ -15,7 +15,9 @@
 namespace Stats {
 
     enum EventType {
-        NUM_STREAMS = 0,
+        NUM_STREAMS = 0,      // streams examined, NumStreams per iteration
+        DF_CANDIDATES,        // streams with a supported DF that were dispatched
+        PHASES_REFINED,       // fine phases rebuilt around a coarse one, see DemodCore
         
         //SAMPLES_PROCESSED,    // sample has been processed
         NUM_ITERATIONS,
@@ -51,7 +53,7 @@ namespace Stats {
 class StatsLog {
     public:
 
-    constexpr StatsLog() : m_events(), m_sent(), m_dups() {
+    constexpr StatsLog() : m_events(), m_sent(), m_dups(), m_repaired() {
         reset();
     }
 
@@ -63,6 +65,7 @@ class StatsLog {
         for (auto i = 0; i < 25; i++) {
             m_sent[i] = 0;
             m_dups[i] = 0;
+            m_repaired[i] = 0;
         }
     }
 
@@ -93,6 +96,11 @@ class StatsLog {
         m_dups[df]++;
     }
 
+    // a frame with address parity that was repaired, see DemodCore
+    constexpr void logRepaired(int df) {
+        m_repaired[df]++;
+    }
+
     constexpr uint64_t getCount(EventType evt) const {
         return m_events[evt];
     }
@@ -105,6 +113,10 @@ class StatsLog {
         return m_dups[df];
     }
 
+    constexpr int getRepaired(int df) const {
+        return m_repaired[df];
+    }
+
     constexpr double maxMsgsPerSec() const {
         return m_maxMsgsPerSecond;
     }
@@ -116,6 +128,7 @@ private:
     std::array<uint64_t, Stats::NUM_EVENTS> m_events;
     std::array<int, 25> m_sent;
     std::array<int, 25> m_dups;
+    std::array<int, 25> m_repaired;
     double m_maxMsgsPerSecond = 0.0;
     int m_totalMsgsSent = 0;
 };
@@ -206,12 +219,15 @@ private:
 
         const auto Surv_sent = s.getSent(4) + s.getSent(5);
         const auto Surv_dups = s.getDups(4) + s.getDups(5);
+        const auto Surv_repaired = s.getRepaired(4) + s.getRepaired(5);
 
         const auto ACAS_sent = s.getSent(0) + s.getSent(16);
         const auto ACAS_dups = s.getDups(0) + s.getDups(16);
+        const auto ACAS_repaired = s.getRepaired(0) + s.getRepaired(16);
 
         const auto COMM_B_sent = s.getSent(20) + s.getSent(21);
         const auto COMM_B_dups = s.getDups(20) + s.getDups(21);
+        const auto COMM_B_repaired = s.getRepaired(20) + s.getRepaired(21);
          
         const auto ES_sent = s.getSent(17) + s.getSent(18) + s.getSent(19);
         const auto ES_dups = s.getDups(17) + s.getDups(18) + s.getDups(19);
@@ -219,11 +235,11 @@ private:
         
         const auto Short_sent = DF11_sent + Surv_sent + s.getSent(0);
         const auto Short_dups = DF11_dups + Surv_dups + s.getDups(0);
-        const auto Short_repaired = DF11_repaired;
+        const auto Short_repaired = DF11_repaired + Surv_repaired + s.getRepaired(0);
 
         const auto Long_sent = s.getSent(16) + COMM_B_sent + ES_sent;
         const auto Long_dups = s.getDups(16) + COMM_B_dups + ES_dups;
-        const auto Long_repaired = ES_repaired;
+        const auto Long_repaired = ES_repaired + s.getRepaired(16) + COMM_B_repaired;
 
         const auto total_sent = Long_sent + Short_sent;
         const auto total_dups = Long_dups + Short_dups;
@@ -235,9 +251,9 @@ private:
         printHeaderLine(out);
         printLine(out);
         printStatsLine(out, "ADS-B", ES_sent, ES_dups, ES_repaired, total_sent, time_elapsed);
-        printStatsLine(out, "Comm-B", COMM_B_sent, COMM_B_dups, -1, total_sent, time_elapsed);
-        printStatsLine(out, "ACAS", ACAS_sent, ACAS_dups, -1, total_sent, time_elapsed);
-        printStatsLine(out, "Surv", Surv_sent, Surv_dups, -1, total_sent, time_elapsed);
+        printStatsLine(out, "Comm-B", COMM_B_sent, COMM_B_dups, COMM_B_repaired, total_sent, time_elapsed);
+        printStatsLine(out, "ACAS", ACAS_sent, ACAS_dups, ACAS_repaired, total_sent, time_elapsed);
+        printStatsLine(out, "Surv", Surv_sent, Surv_dups, Surv_repaired, total_sent, time_elapsed);
         printStatsLine(out, "DF-11", DF11_sent, DF11_dups, DF11_repaired, total_sent, time_elapsed);
         printLine(out);
         printStatsLine(out, "112-bit", Long_sent, Long_dups, Long_repaired, total_sent, time_elapsed);
@@ -253,6 +269,14 @@ private:
             }
         }
         out << s.getCount(NUM_ITERATIONS) << " iterations @1MHz" << std::endl; 
+        if (s.getCount(NUM_STREAMS) > 0) {
+            out << "Dispatched " << s.getCount(DF_CANDIDATES) << " of " << s.getCount(NUM_STREAMS) << " streams (";
+            printPerc(out, (double)s.getCount(DF_CANDIDATES) / (double)s.getCount(NUM_STREAMS), 0);
+            out << ")" << std::endl;
+        }
+        if (s.getCount(PHASES_REFINED) > 0) {
+            out << "Refined " << s.getCount(PHASES_REFINED) << " phases" << std::endl;
+        }
     }
 
     inline void printTick(StatsLog& stats, std::ostream& out) {
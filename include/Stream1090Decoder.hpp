@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The API of libstream1090, for embedding the decoder into another program.
+// This header does not pull in the templates of the decoder, the preset that
+// matches the configuration is picked when the decoder is created.
+//
+//   auto decoder = Stream1090::Decoder::create(config, [](const Stream1090::Frame& frame) {
+//       ...
+//   }, &error);
+//   while (...)
+//       decoder->push(buffer, numBytes);
+//   decoder->finish();
+//
+namespace Stream1090 {
+
+    // the raw IQ values pushed into the decoder
+    enum class Format {
+        // interleaved uint8 IQ as delivered by an RTL-SDR
+        IQ_UINT8,
+        // interleaved 12 bit IQ in uint16 as delivered by an Airspy in raw mode
+        IQ_UINT16,
+        // interleaved float32 IQ, only if built with ENABLE_CUSTOM_INPUT
+        IQ_FLOAT32
+    };
+
+    struct DecoderConfig {
+        Format format = Format::IQ_UINT8;
+        // in Hz, e.g. 2400000 or 6000000
+        uint32_t inputRate = 2400000;
+        // in Hz, 0 for the default of the input rate (the same as stream1090 -s without -u)
+        uint32_t outputRate = 0;
+        // the built-in IQ low pass (stream1090 -q)
+        bool iqFilter = false;
+        // custom IQ low pass taps (stream1090 -f), overrides iqFilter
+        std::vector<float> filterTaps;
+        // input samples processed at once, 0 for the largest
+        size_t blockSize = 0;
+        // demodulate 8 phases and refine the others on demand (stream1090 --coarse).
+        // Ignored with less than 16 streams, config() tells if it is in use
+        bool coarsePhases = false;
+    };
+
+    // A frame that passed the CRC check
+    struct Frame {
+        // 12 MHz ticks since the first pushed sample, the MLAT timestamp of the AVR output
+        uint64_t mlatTime;
+        // the sample at the output rate the frame was found at
+        uint64_t sampleIndex;
+        // 0..255, the same scale as the RSSI of the AVR output
+        uint8_t rssi;
+        // 7 for short and 14 for long frames
+        uint8_t numBytes;
+        uint8_t bytes[14];
+
+        uint8_t downlinkFormat() const noexcept { return bytes[0] >> 3; }
+    };
+
+    // Called for every frame on the thread of the decoder while push() or
+    // finish() waits for it. The frame is only valid during the call.
+    using FrameCallback = std::function<void(const Frame&)>;
+
+    // Called for every block of magnitudes after the IQ pipeline, at the input
+    // rate and in the same way as FrameCallback. The last block is padded.
+    using MagnitudeCallback = std::function<void(const float* magnitudes, size_t numSamples)>;
+
+    // what went through the stages, exact after finish()
+    struct DecoderStats {
+        // raw IQ pairs pushed
+        uint64_t inputSamples = 0;
+        // blocks converted to magnitudes, including the padded last one
+        uint64_t blocks = 0;
+        // magnitudes at the output rate the slicer has seen
+        uint64_t outputSamples = 0;
+        // frames handed to the callback
+        uint64_t shortFrames = 0;
+        uint64_t longFrames = 0;
+        std::array<uint64_t, 32> framesPerDF{};
+    };
+
+    class Decoder {
+    public:
+        // nullptr if the configuration is not supported, error tells why
+        static std::unique_ptr<Decoder> create(const DecoderConfig& config, FrameCallback callback,
+                                               std::string* error = nullptr);
+
+        // finishes the stream if that was not done yet
+        virtual ~Decoder() = default;
+
+        // Decodes numBytes of raw IQ values in the format of the configuration.
+        // The buffer is not copied, the samples are converted right from it.
+        // Returns when the decoder is done with the buffer. Only a partial block
+        // at its end is kept for the next call. Returns false if numBytes is no
+        // multiple of the size of a value or the stream was finished.
+        virtual bool push(const void* data, size_t numBytes) = 0;
+
+        // Ends the stream. The last partial block is padded with zeros and the
+        // frames still in the decoder are delivered before it returns.
+        virtual void finish() = 0;
+
+        // Only before the first push()
+        virtual void setMagnitudeCallback(MagnitudeCallback callback) = 0;
+
+        // the configuration of the preset that was picked
+        virtual const DecoderConfig& config() const noexcept = 0;
+
+        // input samples pushed so far
+        virtual uint64_t numSamples() const noexcept = 0;
+
+        virtual DecoderStats stats() const = 0;
+
+        // Resamples magnitudes at the input rate, e.g. from the MagnitudeCallback,
+        // to the output rate with the sampler of the preset, i.e., the magnitudes
+        // the slicer compares. The end is padded to a full block.
+        virtual std::vector<float> upsample(const float* magnitudes, size_t numSamples) const = 0;
+    };
+
+} // end of namespace Stream1090
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "RingBuffer.hpp"
+
+// Time that passed without samples, e.g. between two recordings or while a
+// lost device is opened again. The writer of the samples queues a gap at the
+// input sample position it starts at, before it writes the samples after it.
+// The reader takes it when it gets there (see InputBufferGapReader) and the
+// sample stream advances the time of the demodulator.
+class StreamGaps {
+public:
+    // a gap of numSamples input samples right before input sample atSample.
+    // Replaces the last one if that is at the same position.
+    void push(uint64_t atSample, uint64_t numSamples) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_gaps.empty() && m_gaps.back().atSample == atSample) {
+            m_gaps.back().numSamples = numSamples;
+            return;
+        }
+        m_gaps.push_back(Gap{ atSample, numSamples });
+        m_numGaps.fetch_add(1, std::memory_order_release);
+    }
+
+    // the input samples missing before position, usually 0
+    uint64_t take(uint64_t position) {
+        if (m_numGaps.load(std::memory_order_acquire) == 0)
+            return 0;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_gaps.empty() || m_gaps.front().atSample != position)
+            return 0;
+        const uint64_t numSamples = m_gaps.front().numSamples;
+        m_gaps.pop_front();
+        m_numGaps.fetch_sub(1, std::memory_order_release);
+        return numSamples;
+    }
+
+private:
+    struct Gap {
+        uint64_t atSample;
+        uint64_t numSamples;
+    };
+
+    std::mutex m_mutex;
+    std::deque<Gap> m_gaps;
+    // to skip the lock while there are none
+    std::atomic<size_t> m_numGaps{0};
+};
+
+// Writes through to another writer and counts the values, so a gap can be placed
+// right after them. The stream does not end with the shutdown of this writer,
+// e.g. a device may be closed and opened again with it. Whoever owns the ring
+// buffer shuts it down.
+template<typename T>
+class CountingWriter : public IAsyncWriter<T> {
+public:
+    explicit CountingWriter(IAsyncWriter<T>& writer) : m_writer(writer) {}
+
+    size_t write(const T* newData, size_t n) override {
+        m_numValues.fetch_add(n, std::memory_order_relaxed);
+        return m_writer.write(newData, n);
+    }
+
+    void shutdown() override { }
+
+    uint64_t numValues() const noexcept {
+        return m_numValues.load(std::memory_order_relaxed);
+    }
+
+    // Writes zeros up to the next multiple of blockValues after at least minValues.
+    // Returns the number of zeros. Only while nobody else writes.
+    uint64_t pad(size_t blockValues, size_t minValues) {
+        const uint64_t end = numValues() + minValues;
+        const std::vector<T> padding(blockValues - end % blockValues + minValues, T(0));
+        write(padding.data(), padding.size());
+        return padding.size();
+    }
+
+private:
+    IAsyncWriter<T>& m_writer;
+    std::atomic<uint64_t> m_numValues{0};
+};
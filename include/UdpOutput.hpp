@@ -0,0 +1,312 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Bits128.hpp"
+#include "AVRWriter.hpp"
+#include "BeastWriter.hpp"
+
+// Sends the frames as UDP datagrams to a unicast or multicast address. Lossy,
+// but never blocks the demodulator. As many frames as fit are packed into one
+// datagram, frames are never split. Datagrams are sent in batches with
+// sendmmsg from a thread of their own.
+//
+// Every datagram starts with an 8-byte header:
+//   'S', 'U', version, format ('B' Beast, 'A' AVR), 4 bytes sequence number (big endian)
+// followed by the frames in the given format. The sequence number counts the
+// datagrams, so receivers can tell how many were lost.
+namespace UdpOutput {
+
+    enum class Format : uint8_t {
+        Beast = 'B',
+        AVR = 'A'
+    };
+
+    static constexpr uint8_t Version = 1;
+    static constexpr size_t HeaderSize = 8;
+    // 1500 bytes ethernet MTU - IPv4 and UDP header
+    static constexpr size_t DefaultMaxDatagram = 1472;
+    // a partially filled datagram is sent after this
+    static constexpr auto FlushInterval = std::chrono::milliseconds(10);
+    // datagrams per sendmmsg call
+    static constexpr size_t BatchSize = 64;
+    // datagrams waiting for the thread, older ones are dropped beyond this
+    static constexpr size_t MaxQueued = 1024;
+
+    // longest encoded frame of both formats
+    static constexpr size_t MaxFrameSize = std::max(BeastWriter::MaxEncodedSize, AVRWriter::MaxEncodedSize);
+
+    inline void writeHeader(uint8_t* out, Format format, uint32_t seq) {
+        out[0] = 'S';
+        out[1] = 'U';
+        out[2] = Version;
+        out[3] = uint8_t(format);
+        out[4] = uint8_t(seq >> 24);
+        out[5] = uint8_t(seq >> 16);
+        out[6] = uint8_t(seq >> 8);
+        out[7] = uint8_t(seq);
+    }
+
+    // checks the header and extracts format and sequence number
+    inline bool readHeader(const uint8_t* in, size_t size, Format& format, uint32_t& seq) {
+        if (size < HeaderSize || in[0] != 'S' || in[1] != 'U' || in[2] != Version)
+            return false;
+        format = Format(in[3]);
+        seq = (uint32_t(in[4]) << 24) | (uint32_t(in[5]) << 16) | (uint32_t(in[6]) << 8) | uint32_t(in[7]);
+        return true;
+    }
+
+    // splits host:port, [v6 address]:port also works
+    inline bool splitHostPort(const std::string& s, std::string& host, std::string& port) {
+        const size_t colon = s.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == s.size())
+            return false;
+        host = s.substr(0, colon);
+        port = s.substr(colon + 1);
+        if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+            host = host.substr(1, host.size() - 2);
+        return true;
+    }
+
+    class Sender {
+    public:
+        ~Sender() {
+            close();
+        }
+
+        // target is host:port. For a multicast group the TTL (hop limit) is ttl.
+        bool open(const std::string& target, Format format, size_t maxDatagram = DefaultMaxDatagram, int ttl = 1) {
+            std::string host, port;
+            if (!splitHostPort(target, host, port))
+                return false;
+
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_DGRAM;
+            addrinfo* res = nullptr;
+            if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res)
+                return false;
+
+            const int fd = ::socket(res->ai_family, SOCK_DGRAM, 0);
+            bool ok = fd >= 0;
+            if (ok && res->ai_family == AF_INET) {
+                const auto* a = reinterpret_cast<const sockaddr_in*>(res->ai_addr);
+                if (IN_MULTICAST(ntohl(a->sin_addr.s_addr))) {
+                    const unsigned char t = (unsigned char)ttl;
+                    const unsigned char loop = 1;
+                    ::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &t, sizeof(t));
+                    ::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+                }
+            } else if (ok && res->ai_family == AF_INET6) {
+                const auto* a = reinterpret_cast<const sockaddr_in6*>(res->ai_addr);
+                if (IN6_IS_ADDR_MULTICAST(&a->sin6_addr)) {
+                    const int loop = 1;
+                    ::setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &ttl, sizeof(ttl));
+                    ::setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &loop, sizeof(loop));
+                }
+            }
+            // connected, so sendmmsg needs no addresses
+            ok = ok && ::connect(fd, res->ai_addr, res->ai_addrlen) == 0;
+            ::freeaddrinfo(res);
+            if (!ok) {
+                if (fd >= 0)
+                    ::close(fd);
+                return false;
+            }
+
+            m_fd = fd;
+            m_format = format;
+            m_maxDatagram = std::max(maxDatagram, HeaderSize + MaxFrameSize);
+            m_stop = false;
+            m_thread = std::thread([this] { loop(); });
+            return true;
+        }
+
+        bool isOpen() const noexcept {
+            return m_fd >= 0;
+        }
+
+        void push(uint64_t mlat, const Bits128& frame, uint8_t rssi, bool isLong) {
+            uint8_t buf[MaxFrameSize];
+            size_t n;
+            if (m_format == Format::Beast) {
+                n = isLong ? BeastWriter::encodeLong(buf, mlat, frame, rssi)
+                           : BeastWriter::encodeShort(buf, mlat, frame.low(), rssi);
+            } else {
+                char* c = reinterpret_cast<char*>(buf);
+                n = isLong ? AVRWriter::encodeLong_MLAT_RSSI(c, mlat, frame, rssi)
+                           : AVRWriter::encodeShort_MLAT_RSSI(c, mlat, frame.low(), rssi);
+            }
+
+            bool notify = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_current.empty() && m_current.size() + n > m_maxDatagram) {
+                    finishCurrent();
+                    notify = true;
+                }
+                if (m_current.empty()) {
+                    m_current.resize(HeaderSize);
+                    m_currentStart = std::chrono::steady_clock::now();
+                }
+                m_current.insert(m_current.end(), buf, buf + n);
+            }
+            if (notify)
+                m_condVar.notify_one();
+        }
+
+        // sends what is left and stops the thread
+        void close() {
+            if (m_fd < 0)
+                return;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_condVar.notify_one();
+            m_thread.join();
+            ::close(m_fd);
+            m_fd = -1;
+        }
+
+        uint64_t numSent() const noexcept { return m_numSent; }
+        uint64_t numDropped() const noexcept { return m_numDropped; }
+
+    private:
+        // moves the current datagram to the queue. Requires the lock.
+        void finishCurrent() {
+            writeHeader(m_current.data(), m_format, m_seq++);
+            m_full.push_back(std::move(m_current));
+            if (m_full.size() > MaxQueued) {
+                // the network does not keep up, drop the oldest
+                m_free.push_back(std::move(m_full.front()));
+                m_full.pop_front();
+                m_numDropped++;
+            }
+            if (!m_free.empty()) {
+                m_current = std::move(m_free.back());
+                m_free.pop_back();
+            } else {
+                m_current = std::vector<uint8_t>();
+                m_current.reserve(m_maxDatagram);
+            }
+            m_current.clear();
+        }
+
+        void loop() {
+            std::vector<std::vector<uint8_t>> batch;
+            std::vector<mmsghdr> msgs;
+            std::vector<iovec> iovs;
+            bool stop = false;
+
+            while (!stop) {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condVar.wait_for(lock, FlushInterval, [&] { return m_stop || !m_full.empty(); });
+                    stop = m_stop;
+                    // a partially filled datagram is not held back for long
+                    if (!m_current.empty()
+                        && (stop || std::chrono::steady_clock::now() - m_currentStart >= FlushInterval)) {
+                        finishCurrent();
+                    }
+                    while (!m_full.empty()) {
+                        batch.push_back(std::move(m_full.front()));
+                        m_full.pop_front();
+                    }
+                }
+
+                for (size_t first = 0; first < batch.size(); first += BatchSize) {
+                    const size_t count = std::min(BatchSize, batch.size() - first);
+                    msgs.assign(count, mmsghdr{});
+                    iovs.resize(count);
+                    for (size_t i = 0; i < count; i++) {
+                        iovs[i].iov_base = batch[first + i].data();
+                        iovs[i].iov_len = batch[first + i].size();
+                        msgs[i].msg_hdr.msg_iov = &iovs[i];
+                        msgs[i].msg_hdr.msg_iovlen = 1;
+                    }
+                    send(msgs.data(), count);
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (auto& d : batch) {
+                    m_free.push_back(std::move(d));
+                }
+                batch.clear();
+            }
+        }
+
+        // sends count datagrams, what cannot be sent is dropped
+        void send(mmsghdr* msgs, size_t count) {
+            size_t done = 0;
+            bool refused = false;
+            while (done < count) {
+                const int r = ::sendmmsg(m_fd, msgs + done, unsigned(count - done), 0);
+                if (r < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    // an ICMP port unreachable for an earlier datagram, nobody listening (yet).
+                    // The error is cleared by reporting it, so try once more.
+                    if (errno == ECONNREFUSED && !refused) {
+                        refused = true;
+                        continue;
+                    }
+                    if (!m_errorReported) {
+                        std::cerr << "[Stream1090] UDP send failed: " << std::strerror(errno) << std::endl;
+                        m_errorReported = true;
+                    }
+                    m_numDropped += count - done;
+                    return;
+                }
+                done += size_t(r);
+                refused = false;
+                m_numSent += uint64_t(r);
+            }
+        }
+
+        int m_fd = -1;
+        Format m_format = Format::Beast;
+        size_t m_maxDatagram = DefaultMaxDatagram;
+        bool m_errorReported = false;
+
+        // shared with the thread
+        std::mutex m_mutex;
+        std::condition_variable m_condVar;
+        std::vector<uint8_t> m_current;
+        std::chrono::steady_clock::time_point m_currentStart;
+        std::deque<std::vector<uint8_t>> m_full;
+        std::vector<std::vector<uint8_t>> m_free;
+        uint32_t m_seq = 0;
+        bool m_stop = false;
+
+        std::atomic<uint64_t> m_numSent{0};
+        std::atomic<uint64_t> m_numDropped{0};
+
+        std::thread m_thread;
+    };
+
+} // end of namespace UdpOutput
@@ -9,7 +9,10 @@
 #include "Sampler.hpp"
 #include "RingBuffer.hpp"
 #include "IniConfig.hpp"
+#include "RealTime.hpp"
 #include <atomic>
+#include <iostream>
+#include <string>
 
 template<typename T>
 class InputDeviceBase {
@@ -47,6 +50,24 @@ public:
                              std::memory_order_relaxed);
     }
     
+    // Real-time settings for the thread that calls the device callback. The
+    // thread belongs to the driver library, so it applies them itself on the first callback.
+    void setCallbackThreadConfig(const RealTime::ThreadConfig& config, const std::string& name, size_t index = 0) {
+        m_callbackThreadConfig = config;
+        m_callbackThreadName = name;
+        m_callbackThreadIndex = index;
+    }
+
+    // Called by device callback threads
+    void configureCallbackThread() {
+        if (m_callbackThreadConfigured.load(std::memory_order_relaxed))
+            return;
+        m_callbackThreadConfigured.store(true, std::memory_order_relaxed);
+        if (!m_callbackThreadConfig.empty()) {
+            std::cerr << RealTime::configureThread(m_callbackThreadName, m_callbackThreadConfig, m_callbackThreadIndex) + "\n";
+        }
+    }
+
     // Used by watchdog to detect cable pulls
     std::chrono::milliseconds lastSignOfLife() const {
         auto now  = std::chrono::steady_clock::now();
@@ -77,4 +98,9 @@ protected:
 
     // timestamp when the last time the callback was called.
     std::atomic<std::chrono::steady_clock::time_point> m_lastSignOfLife;
+
+    RealTime::ThreadConfig m_callbackThreadConfig;
+    std::string m_callbackThreadName = "usb";
+    size_t m_callbackThreadIndex = 0;
+    std::atomic<bool> m_callbackThreadConfigured{false};
 };
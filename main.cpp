@@ -12,10 +12,12 @@
 #include <thread>
 #include <chrono>
 #include <optional>
+#include <cstdlib>
 
 #define STREAM1090_VERSION "260617"
 
 #include "MainInstance.hpp"
+#include "CliHelpers.hpp"
 
 
 struct RatePair {
@@ -117,8 +119,29 @@ void print_help() {
     "  -u <rate>            Upsample rate in MHz\n"
     "  -d <file.ini>        Device configuration INI file for native devices\n"
     "                       See configs/airspy.ini or configs/rtlsdr.ini\n"                       
+    "                       May be given multiple times to run several receivers\n"
+    "  -i <recording>       Read from a raw recording instead of stdin. May be given\n"
+    "                       multiple times, also together with -d\n"
+    "  --playlist <list>    Read the recordings of a glob pattern (quoted) or a playlist file back\n"
+    "                       to back, with continuous timestamps. May be given multiple times\n"
+    "  -w <us>              Merge window for several receivers in microseconds (default: 1000)\n"
     "  -q                   Enables IQ FIR filter with built-in taps\n"
     "  -f <taps file>       Taps to load that are used for the IQ FIR filter\n"
+    "  -b <capture file>    Capture the demodulated bitstream for tools/demod_replay\n"
+    "  -j <json file>       Decode the aircraft and write them to the file every second\n"
+    "  -m <name>            Also publish the frames into a shared memory ring, e.g. /stream1090\n"
+    "                       See tools/shm_reader.cpp\n"
+    "  -a <directory>       Also archive the frames into hourly segment files in the directory\n"
+    "  -U <host:port>[,avr] Also send the frames as UDP datagrams (Beast or AVR), unicast or multicast\n"
+    "  --rt <key=value,...> Real-time settings, see the [realtime] section in configs/rtlsdr.ini\n"
+    "                       e.g. --rt dsp_cpu=2,dsp_priority=50,usb_cpu=3,lock_memory=1\n"
+    "  --isa <level>        Use at most these kernels: baseline, avx2 or avx512 (default: best the CPU supports)\n"
+    "  --block <n|auto>     Input samples processed at once, or auto to time a few at startup (default: largest)\n"
+    "  --latency <ms>       Low latency profile, a block takes at most this long to fill, e.g. 0.5\n"
+    "  --pipe-buffer <KiB>  Capacity of the pipe on stdin, 0 keeps the system default (default: 1024)\n"
+    "  --control <path>     Take commands on a Unix domain socket, e.g. set gain 40.2, stats, output udp off\n"
+    "  --coarse             Demodulate 8 phases continuously and the others only around likely frames.\n"
+    "                       For 16 streams or more, e.g. -u 24 at close to the CPU cost of -u 8\n"
     "  -v                   Verbose output\n"
     "  -h, --help           Show this help message\n\n";
 
@@ -127,15 +150,31 @@ void print_help() {
     std::cout <<
     "Examples:\n"
     "  ./build/stream1090 -s 2.4 -u 8 -q -d ./configs/rtlsdr.ini\n"
-    "  ./build/stream1090 -s 6 -u 12 -q -d ./configs/airspy.ini\n\n";
+    "  ./build/stream1090 -s 6 -u 12 -q -d ./configs/airspy.ini\n"
+    "  ./build/stream1090 -s 10 -u 24 -q -d ./configs/airspy.ini -d ./configs/airspy2.ini\n\n";
 }
 
 
 struct CliArgs {
     std::string sampleRate = "";
     std::string upsampleRate = "";
-    std::string deviceConfig = "";
+    std::vector<std::string> deviceConfigs;
+    std::vector<std::string> inputFiles;
+    std::vector<std::string> playlists;
+    uint64_t mergeWindowMicros = 1000;
     std::string tapsFile = "";
+    std::string bitCaptureFile = "";
+    std::string aircraftJsonFile = "";
+    std::string frameRingName = "";
+    std::string archiveDir = "";
+    std::string udpTarget = "";
+    std::string realTime = "";
+    std::string isa = "";
+    std::string blockSize = "";
+    std::string latency = "";
+    std::string pipeBuffer = "";
+    std::string controlSocket = "";
+    bool coarsePhases = false;
     bool iq_filter = false;
     bool verbose = false;
 };
@@ -160,7 +199,22 @@ bool parse_cli(int argc, char** argv, CliArgs& out) {
         }
 
         if (arg == "-d" && i + 1 < argc) {
-            out.deviceConfig = argv[++i];
+            out.deviceConfigs.push_back(argv[++i]);
+            continue;
+        }
+
+        if (arg == "--playlist" && i + 1 < argc) {
+            out.playlists.push_back(argv[++i]);
+            continue;
+        }
+
+        if (arg == "-i" && i + 1 < argc) {
+            out.inputFiles.push_back(argv[++i]);
+            continue;
+        }
+
+        if (arg == "-w" && i + 1 < argc) {
+            out.mergeWindowMicros = std::stoull(argv[++i]);
             continue;
         }
 
@@ -169,6 +223,66 @@ bool parse_cli(int argc, char** argv, CliArgs& out) {
             continue;
         }
 
+        if (arg == "-b" && i + 1 < argc) {
+            out.bitCaptureFile = argv[++i];
+            continue;
+        }
+
+        if (arg == "-j" && i + 1 < argc) {
+            out.aircraftJsonFile = argv[++i];
+            continue;
+        }
+
+        if (arg == "-m" && i + 1 < argc) {
+            out.frameRingName = argv[++i];
+            continue;
+        }
+
+        if (arg == "-a" && i + 1 < argc) {
+            out.archiveDir = argv[++i];
+            continue;
+        }
+
+        if (arg == "-U" && i + 1 < argc) {
+            out.udpTarget = argv[++i];
+            continue;
+        }
+
+        if (arg == "--rt" && i + 1 < argc) {
+            out.realTime = argv[++i];
+            continue;
+        }
+
+        if (arg == "--isa" && i + 1 < argc) {
+            out.isa = argv[++i];
+            continue;
+        }
+
+        if (arg == "--block" && i + 1 < argc) {
+            out.blockSize = argv[++i];
+            continue;
+        }
+
+        if (arg == "--latency" && i + 1 < argc) {
+            out.latency = argv[++i];
+            continue;
+        }
+
+        if (arg == "--pipe-buffer" && i + 1 < argc) {
+            out.pipeBuffer = argv[++i];
+            continue;
+        }
+
+        if (arg == "--control" && i + 1 < argc) {
+            out.controlSocket = argv[++i];
+            continue;
+        }
+
+        if (arg == "--coarse") {
+            out.coarsePhases = true;
+            continue;
+        }
+
         if (arg == "-q") {
             out.iq_filter = true;
             continue;
@@ -186,80 +300,46 @@ bool parse_cli(int argc, char** argv, CliArgs& out) {
     return true;
 }
 
-SampleRate parse_sample_rate(const std::string& raw) {
-    // Strip optional trailing 'M' or 'm'
-    std::string s = raw;
-    if (!s.empty() && (s.back() == 'M' || s.back() == 'm'))
-        s.pop_back();
-
-    // Parse as float MHz
-    float mhz = 0.0f;
-    try {
-        mhz = std::stof(s);
-    } catch (...) {
-        std::cerr << "Invalid sample rate: " << raw << "\n";
-        std::exit(1);
-    }
+// loads a device INI file and detects the device type
+bool load_device_config(const std::string& filename, ReceiverConfig& out) {
+    // Load config file
+    IniConfig dev_ini(filename);
 
-    // Convert MHz → Hz
-    int hz = static_cast<int>(mhz * 1'000'000.0f + 0.5f);
-
-    // Match directly against enum values
-    switch (hz) {
-        case Rate_1_0_Mhz:  return Rate_1_0_Mhz;
-        case Rate_2_0_Mhz:  return Rate_2_0_Mhz;
-        case Rate_2_4_Mhz:  return Rate_2_4_Mhz;
-        case Rate_2_56_Mhz:  return Rate_2_56_Mhz;
-        case Rate_3_0_Mhz:  return Rate_3_0_Mhz;
-        case Rate_3_2_Mhz:  return Rate_3_2_Mhz;
-        case Rate_4_0_Mhz:  return Rate_4_0_Mhz;
-        case Rate_6_0_Mhz:  return Rate_6_0_Mhz;
-        case Rate_8_0_Mhz:  return Rate_8_0_Mhz;
-        case Rate_10_0_Mhz: return Rate_10_0_Mhz;
-        case Rate_12_0_Mhz: return Rate_12_0_Mhz;
-        case Rate_16_0_Mhz: return Rate_16_0_Mhz;
-        case Rate_20_0_Mhz: return Rate_20_0_Mhz;
-        case Rate_24_0_Mhz: return Rate_24_0_Mhz;
-        case Rate_40_0_Mhz: return Rate_40_0_Mhz;
-        case Rate_48_0_Mhz: return Rate_48_0_Mhz;
+    if (!dev_ini.load()) {
+        std::cerr << "[Stream1090] Cannot load device config from "
+                << filename << std::endl;
+        return false;
     }
 
-    std::cerr << "Unsupported sample rate: " << raw << "\n";
-    std::exit(1);
-}
+    // Store full config (including filename)
+    out.deviceConfig = dev_ini;
 
-std::vector<float> load_taps_from_file(const std::string& filename) {
-    std::vector<float> taps;
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        return taps;
-    }
+    // Detect device type
+    auto& cfg = dev_ini.get();
 
-    std::string line;
-    while (std::getline(file, line)) {
-        // trim whitespace
-        if (line.empty()) continue;
+    if (cfg.count("airspy")) {
+        out.deviceType = InputDeviceType::AIRSPY;
+        out.deviceConfigSection = cfg.at("airspy");
 
-        // skip comments
-        if (line[0] == '#') continue;
-
-        // parse float
-        try {
-            //float v = std::stof(line);
-            double v = std::stod(line);
-            taps.push_back((float)v);
-        } catch (...) {
-            // malformed line
-            return std::vector<float>();;
+        if (!GlobalOptions::NativeAirspySupport) {
+            std::cerr << "[Stream1090] Error. No native device support for airspy" << std::endl;
+            return false;
         }
 
-        // too many taps
-        if (taps.size() > 64) {
-            return std::vector<float>();
+    } else if (cfg.count("rtlsdr")) {
+        out.deviceType = InputDeviceType::RTLSDR;
+        out.deviceConfigSection = cfg.at("rtlsdr");
+
+        if (!GlobalOptions::NativeRtlSdrSupport) {
+            std::cerr << "[Stream1090] Error. No native device support for rtlsdr" << std::endl;
+            return false;
         }
-    }
 
-    return taps;
+    } else {
+        std::cerr << "[Stream1090] Error. Config file does not contain [airspy] or [rtlsdr] section." << std::endl;
+        return false;
+    }
+    return true;
 }
 
 int main(int argc, char** argv) {
@@ -268,7 +348,7 @@ int main(int argc, char** argv) {
 
     CliArgs args;
     if (!parse_cli(argc, argv, args)) {
-        std::cerr << "Usage: stream1090 -s <rate> -u <rate> [-d <device.ini>] [-f <taps file>] [-q] [-v] [-h]\n";
+        std::cerr << "Usage: stream1090 -s <rate> -u <rate> [-d <device.ini>]... [-i <recording>]... [--playlist <list>]... [-w <us>] [-f <taps file>] [-b <capture file>] [-j <json file>] [-m <name>] [-a <directory>] [-U <host:port>[,avr]] [--rt <settings>] [--isa <level>] [--block <n|auto>] [--latency <ms>] [--pipe-buffer <KiB>] [--control <path>] [--coarse] [-q] [-v] [-h]\n";
         return 1;
     }
 
@@ -281,51 +361,106 @@ int main(int argc, char** argv) {
     // Device config loading
     // ------------------------
 
-    if (args.deviceConfig.empty()) {
-        // No config file → stdin mode
-        r_vars.deviceType = InputDeviceType::STREAM;
-        std::cerr << "[Stream1090] Reading from Stdin" << std::endl;
-    } else {
-        // Load config file
-        IniConfig dev_ini(args.deviceConfig);
+    std::vector<ReceiverConfig> receivers;
+    for (const auto& deviceConfig : args.deviceConfigs) {
+        ReceiverConfig rc;
+        if (!load_device_config(deviceConfig, rc))
+            return 1;
+        // the [realtime] section of any device file applies to the whole process
+        if (rc.deviceConfig.get().count("realtime") && !r_vars.realTime.apply(rc.deviceConfig.get().at("realtime"))) {
+            std::cerr << "[Stream1090] Error. Invalid [realtime] section in " << deviceConfig << std::endl;
+            return 1;
+        }
+        receivers.push_back(rc);
+    }
+
+    // the command line overrides the INI files
+    if (!args.realTime.empty() && !r_vars.realTime.parse(args.realTime)) {
+        std::cerr << "[Stream1090] Error. Invalid real-time settings " << args.realTime << std::endl;
+        return 1;
+    }
 
-        if (!dev_ini.load()) {
-            std::cerr << "[Stream1090] Cannot load device config from "
-                    << args.deviceConfig << std::endl;
+    if (!args.isa.empty()) {
+        CpuDispatch::Isa isa;
+        if (!CpuDispatch::parse(args.isa, isa)) {
+            std::cerr << "[Stream1090] Error. Unknown kernel level " << args.isa << std::endl;
             return 1;
         }
+        CpuDispatch::limit(isa);
+    }
+
+    if (args.blockSize == "auto") {
+        r_vars.autoBlockSize = true;
+    } else if (!args.blockSize.empty()) {
+        char* end = nullptr;
+        r_vars.blockSize = std::strtoull(args.blockSize.c_str(), &end, 10);
+        if (*end != '\0' || r_vars.blockSize == 0) {
+            std::cerr << "[Stream1090] Error. Invalid block size " << args.blockSize << std::endl;
+            return 1;
+        }
+    }
 
-        // Store full config (including filename)
-        r_vars.deviceConfig = dev_ini;
+    if (!args.latency.empty()) {
+        char* end = nullptr;
+        r_vars.maxBlockMillis = std::strtod(args.latency.c_str(), &end);
+        if (*end != '\0' || r_vars.maxBlockMillis <= 0.0) {
+            std::cerr << "[Stream1090] Error. Invalid latency " << args.latency << std::endl;
+            return 1;
+        }
+    }
 
-        // Detect device type
-        auto& cfg = dev_ini.get();
+    if (!args.pipeBuffer.empty()) {
+        char* end = nullptr;
+        r_vars.pipeBufferSize = std::strtoull(args.pipeBuffer.c_str(), &end, 10) * 1024;
+        if (*end != '\0') {
+            std::cerr << "[Stream1090] Error. Invalid pipe buffer size " << args.pipeBuffer << std::endl;
+            return 1;
+        }
+    }
 
-        if (cfg.count("airspy")) {
-            r_vars.deviceType = InputDeviceType::AIRSPY;
-            r_vars.deviceConfigSection = cfg.at("airspy");
+    for (const auto& inputFile : args.inputFiles) {
+        ReceiverConfig rc;
+        rc.deviceType = InputDeviceType::STREAM;
+        rc.inputFile = inputFile;
+        receivers.push_back(rc);
+    }
 
-            if (!GlobalOptions::NativeAirspySupport) {
-                std::cerr << "[Stream1090] Error. No native device support for airspy" << std::endl;
-                return 1;
-            }
+    if (receivers.size() > FrameMerger::MaxReceivers) {
+        std::cerr << "[Stream1090] Error. At most " << FrameMerger::MaxReceivers << " receivers are supported." << std::endl;
+        return 1;
+    }
 
-        } else if (cfg.count("rtlsdr")) {
-            r_vars.deviceType = InputDeviceType::RTLSDR;
-            r_vars.deviceConfigSection = cfg.at("rtlsdr");
+    if (!args.playlists.empty() && !receivers.empty()) {
+        std::cerr << "[Stream1090] Error. --playlist cannot be combined with -d or -i" << std::endl;
+        return 1;
+    }
 
-            if (!GlobalOptions::NativeRtlSdrSupport) {
-                std::cerr << "[Stream1090] Error. No native device support for rtlsdr" << std::endl;
+    if (!args.playlists.empty()) {
+        // recordings back to back, read like stdin
+        r_vars.deviceType = InputDeviceType::STREAM;
+        for (const auto& playlist : args.playlists) {
+            std::string error;
+            if (!Playlist::load(playlist, r_vars.playlist, error)) {
+                std::cerr << "[Stream1090] Error. Playlist " << error << std::endl;
                 return 1;
             }
-
-        } else {
-            std::cerr << "[Stream1090] Error. Config file does not contain [airspy] or [rtlsdr] section." << std::endl;
-            return 1;
         }
+        std::cerr << "[Stream1090] Reading " << r_vars.playlist.size() << " recordings" << std::endl;
+    } else if (receivers.empty()) {
+        // No config file → stdin mode
+        r_vars.deviceType = InputDeviceType::STREAM;
+        std::cerr << "[Stream1090] Reading from Stdin" << std::endl;
+    } else if (receivers.size() == 1 && args.inputFiles.empty()) {
+        // the classic single device
+        r_vars.deviceType = receivers[0].deviceType;
+        r_vars.deviceConfig = receivers[0].deviceConfig;
+        r_vars.deviceConfigSection = receivers[0].deviceConfigSection;
+    } else {
+        // several receivers in one process, or recordings
+        r_vars.receivers = receivers;
+        r_vars.mergeWindowMicros = args.mergeWindowMicros;
     }
 
-
     // ------------------------
     // FIR taps loading
     // ------------------------
@@ -339,6 +474,23 @@ int main(int argc, char** argv) {
 
     // set the verbose flag
     r_vars.verbose = args.verbose;
+    r_vars.bitCaptureFile = args.bitCaptureFile;
+    r_vars.aircraftJsonFile = args.aircraftJsonFile;
+    r_vars.frameRingName = args.frameRingName;
+    r_vars.archiveDir = args.archiveDir;
+    r_vars.udpTarget = args.udpTarget;
+    r_vars.controlSocket = args.controlSocket;
+    r_vars.coarsePhases = args.coarsePhases;
+    // host:port,format
+    if (const size_t comma = args.udpTarget.find(','); comma != std::string::npos) {
+        const std::string format = args.udpTarget.substr(comma + 1);
+        if (format != "avr" && format != "beast") {
+            std::cerr << "[Stream1090] Unknown UDP format " << format << std::endl;
+            return 1;
+        }
+        r_vars.udpTarget = args.udpTarget.substr(0, comma);
+        r_vars.udpFormat = (format == "avr") ? UdpOutput::Format::AVR : UdpOutput::Format::Beast;
+    }
 
     // ------------------------
     // Sample speed parsing
@@ -13,6 +13,7 @@ int airspy_callback(airspy_transfer_t* transfer) {
     if (!self->isRunning())
         return 0;
 
+    self->configureCallbackThread();
     self->markAsAlive();
 
     const uint16_t* samples = reinterpret_cast<const uint16_t*>(transfer->samples);
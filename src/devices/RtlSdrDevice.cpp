@@ -13,6 +13,7 @@ static void rtlsdr_callback(unsigned char* buf, uint32_t len, void* ctx) {
     if (!self->isRunning())
         return;
 
+    self->configureCallbackThread();
     self->markAsAlive();
     self->writeDataToBuffer(buf, len);
 }
@@ -0,0 +1,231 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include "Stream1090Decoder.hpp"
+
+#include "Presets.hpp"
+#include "SampleStream.hpp"
+#include "InputPushReader.hpp"
+#include "ModeS.hpp"
+
+namespace Stream1090 {
+
+namespace {
+
+    // Runs the sample stream of a preset on its own thread and feeds it with
+    // the pushed buffers, see InputPushReader.
+    template<typename preset>
+    class PresetDecoder final : public Decoder {
+    public:
+        using RawFormatType = typename preset::RawFormatType;
+        using RawType       = typename preset::RawType;
+        using SamplerType   = typename preset::SamplerType;
+        using PipelineType  = decltype(IQPipelineSelector<SamplerType::InputSampleRate, preset::outputRate,
+                                                          preset::pipelineOption, preset::decimation>::make(std::vector<float>()));
+
+        PresetDecoder(const DecoderConfig& config, FrameCallback callback)
+            : m_config(config),
+              m_callback(std::move(callback)),
+              m_pipeline(IQPipelineSelector<SamplerType::InputSampleRate, preset::outputRate,
+                                            preset::pipelineOption, preset::decimation>::make(config.filterTaps)),
+              m_reader(m_pipeline),
+              // the sample stream has large buffers, keep it off the stack
+              m_sampleStream(std::make_unique<SampleStream<SamplerType>>()),
+              m_handler(*this)
+        {
+            m_config.outputRate = preset::outputRate;
+            m_config.blockSize = m_sampleStream->setBlockSize(
+                config.blockSize > 0 ? config.blockSize : SamplerType::InputBufferSize);
+            m_reader.setBlockSize(m_config.blockSize);
+            m_config.coarsePhases = config.coarsePhases && m_sampleStream->setCoarsePhases(true);
+            m_thread = std::thread([this] { m_sampleStream->read(m_reader, m_handler); });
+        }
+
+        ~PresetDecoder() override {
+            finish();
+        }
+
+        bool push(const void* data, size_t numBytes) override {
+            if (m_finished || numBytes % sizeof(RawType) != 0)
+                return false;
+            const size_t numValues = numBytes / sizeof(RawType);
+            m_numValues.fetch_add(numValues, std::memory_order_relaxed);
+            m_reader.push(static_cast<const RawType*>(data), numValues);
+            return true;
+        }
+
+        void finish() override {
+            if (m_finished)
+                return;
+            m_finished = true;
+            m_reader.finish();
+            m_thread.join();
+        }
+
+        const DecoderConfig& config() const noexcept override {
+            return m_config;
+        }
+
+        uint64_t numSamples() const noexcept override {
+            return m_numValues.load(std::memory_order_relaxed) / 2;
+        }
+
+        void setMagnitudeCallback(MagnitudeCallback callback) override {
+            m_reader.setBlockCallback(std::move(callback));
+        }
+
+        DecoderStats stats() const override {
+            DecoderStats res;
+            res.inputSamples = numSamples();
+            res.blocks = m_reader.numBlocks();
+            res.outputSamples = res.blocks * m_config.blockSize * SamplerType::RatioOutput / SamplerType::RatioInput;
+            res.shortFrames = m_shortFrames.load(std::memory_order_relaxed);
+            res.longFrames = m_longFrames.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < res.framesPerDF.size(); i++)
+                res.framesPerDF[i] = m_framesPerDF[i].load(std::memory_order_relaxed);
+            return res;
+        }
+
+        std::vector<float> upsample(const float* magnitudes, size_t numSamples) const override {
+            if constexpr (SamplerType::isPassthrough) {
+                return std::vector<float>(magnitudes, magnitudes + numSamples);
+            } else {
+                // the blocks overlap the same way as in the input ring of the sample stream
+                constexpr size_t In      = SamplerType::InputBufferSize;
+                constexpr size_t Out     = SamplerType::SampleBufferSize;
+                constexpr size_t Overlap = SamplerType::InputBufferOverlap;
+                const size_t numBlocks = (numSamples + In - 1) / In;
+                std::vector<float> in(Overlap + numBlocks * In, 0.0f);
+                std::copy(magnitudes, magnitudes + numSamples, in.begin() + Overlap);
+                std::vector<float> res(numBlocks * Out);
+                for (size_t b = 0; b < numBlocks; b++)
+                    SamplerType::sample(in.data() + b * In, res.data() + b * Out);
+                return res;
+            }
+        }
+
+    private:
+        // hands the frames with their metadata to the callback
+        struct CallbackHandler {
+            PresetDecoder& decoder;
+
+            void handleShort(uint64_t sampleIndex, const uint64_t frame) {
+                Frame res = makeFrame(sampleIndex, 7);
+                for (int i = 0; i < 7; i++)
+                    res.bytes[i] = uint8_t(frame >> (8 * (6 - i)));
+                decoder.m_shortFrames.fetch_add(1, std::memory_order_relaxed);
+                decoder.countDF(res);
+                decoder.m_callback(res);
+            }
+
+            void handleLong(uint64_t sampleIndex, const Bits128& frame) {
+                Frame res = makeFrame(sampleIndex, 14);
+                for (int i = 0; i < 6; i++)
+                    res.bytes[i] = uint8_t(frame.high() >> (8 * (5 - i)));
+                for (int i = 0; i < 8; i++)
+                    res.bytes[6 + i] = uint8_t(frame.low() >> (8 * (7 - i)));
+                decoder.m_longFrames.fetch_add(1, std::memory_order_relaxed);
+                decoder.countDF(res);
+                decoder.m_callback(res);
+            }
+
+            Frame makeFrame(uint64_t sampleIndex, uint8_t numBytes) const {
+                Frame res{};
+                res.mlatTime = MLAT::sampleIndexToMlatTime<SamplerType::NumStreams>(sampleIndex);
+                res.sampleIndex = sampleIndex;
+                res.rssi = decoder.m_sampleStream->getRSSI();
+                res.numBytes = numBytes;
+                return res;
+            }
+        };
+
+        void countDF(const Frame& frame) noexcept {
+            m_framesPerDF[frame.downlinkFormat()].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        DecoderConfig m_config;
+        FrameCallback m_callback;
+        PipelineType m_pipeline;
+        InputPushReader<RawFormatType, SamplerType::InputBufferSize, PipelineType> m_reader;
+        std::unique_ptr<SampleStream<SamplerType>> m_sampleStream;
+        CallbackHandler m_handler;
+        std::thread m_thread;
+        std::atomic<uint64_t> m_numValues{0};
+        std::atomic<uint64_t> m_shortFrames{0};
+        std::atomic<uint64_t> m_longFrames{0};
+        std::array<std::atomic<uint64_t>, 32> m_framesPerDF{};
+        bool m_finished = false;
+    };
+
+    InputFormatType toInputFormatType(Format format) {
+        switch (format) {
+            case Format::IQ_UINT16:  return InputFormatType::IQ_UINT16_RAW_AIRSPY;
+            case Format::IQ_FLOAT32: return InputFormatType::IQ_FLOAT32;
+            default:                 return InputFormatType::IQ_UINT8_RTL_SDR;
+        }
+    }
+
+    // the same choice main.cpp makes for the command line
+    IQPipelineOptions pipelineOption(const DecoderConfig& config) {
+        const bool rtlSdr = (config.format == Format::IQ_UINT8);
+        if (!config.filterTaps.empty())
+            return rtlSdr ? IQPipelineOptions::IQ_FIR_RTL_SDR_FILE : IQPipelineOptions::IQ_FIR_FILE;
+        if (config.iqFilter)
+            return rtlSdr ? IQPipelineOptions::IQ_FIR_RTL_SDR : IQPipelineOptions::IQ_FIR;
+        return IQPipelineOptions::NONE;
+    }
+
+    // the lowest output rate of the input rate, 0 if there is none
+    uint32_t defaultOutputRate(InputFormatType format, uint32_t inputRate) {
+        uint32_t res = 0;
+        for_each_in_tuple(presets, [&](auto const& p) {
+            using P = std::decay_t<decltype(p)>;
+            if (P::RawFormatType::id == format && uint32_t(P::inputRate) == inputRate
+                && (res == 0 || uint32_t(P::outputRate) < res))
+                res = uint32_t(P::outputRate);
+            return false;
+        });
+        return res;
+    }
+
+} // end of anonymous namespace
+
+std::unique_ptr<Decoder> Decoder::create(const DecoderConfig& config, FrameCallback callback, std::string* error) {
+    const InputFormatType format = toInputFormatType(config.format);
+    const IQPipelineOptions option = pipelineOption(config);
+    const uint32_t outputRate = config.outputRate > 0 ? config.outputRate
+                                                      : defaultOutputRate(format, config.inputRate);
+
+    std::unique_ptr<Decoder> res;
+    for_each_in_tuple(presets, [&](auto const& p) {
+        using P = std::decay_t<decltype(p)>;
+        if (P::RawFormatType::id      == format &&
+            uint32_t(P::inputRate)    == config.inputRate &&
+            uint32_t(P::outputRate)   == outputRate &&
+            P::pipelineOption         == option)
+        {
+            res = std::make_unique<PresetDecoder<P>>(config, std::move(callback));
+            return true;
+        }
+        return false;
+    });
+
+    if (!res && error) {
+        *error = "configuration is not supported: " + std::to_string(config.inputRate) + " -> "
+               + std::to_string(outputRate) + " Hz";
+    }
+    return res;
+}
+
+} // end of namespace Stream1090
@@ -0,0 +1,268 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Python bindings of libstream1090 for the analysis scripts. The module has a
+// single function that decodes an IQ array in-process:
+//
+//   import numpy as np, stream1090
+//   iq = np.fromfile("rec.bin", dtype=np.uint8)
+//   res = stream1090.decode(iq, 2400000, 8000000, iq_filter=True, magnitudes=True)
+//   res["mlat_time"], res["rssi"], res["frames"], res["stats"], res["magnitudes"]
+//
+// The IQ values are taken with the buffer protocol and pushed into the decoder
+// without a copy. The results are NumPy arrays, or memoryviews if NumPy is not
+// installed, which np.asarray() takes without a copy as well.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Stream1090Decoder.hpp"
+
+namespace {
+
+    // the frames and buffers collected while decoding
+    struct DecodeResult {
+        std::vector<uint64_t> mlatTime;
+        std::vector<uint64_t> sampleIndex;
+        std::vector<uint8_t>  rssi;
+        std::vector<uint8_t>  numBytes;
+        std::vector<uint8_t>  df;
+        // 14 bytes per frame, short frames end with zeros
+        std::vector<uint8_t>  frames;
+        std::vector<float>    magnitudes;
+    };
+
+    // the raw format of a buffer from its struct format character
+    bool formatOf(const Py_buffer& view, Stream1090::Format& format) {
+        const char* f = view.format ? view.format : "B";
+        // skip the byte order, only native is supported
+        if (*f == '@' || *f == '=' || *f == '<')
+            f++;
+        if (std::strcmp(f, "B") == 0 && view.itemsize == 1) { format = Stream1090::Format::IQ_UINT8;   return true; }
+        if (std::strcmp(f, "H") == 0 && view.itemsize == 2) { format = Stream1090::Format::IQ_UINT16;  return true; }
+        if (std::strcmp(f, "f") == 0 && view.itemsize == 4) { format = Stream1090::Format::IQ_FLOAT32; return true; }
+        return false;
+    }
+
+    // Wraps the bytes of a vector into a 1D array of the given type. shape0 > 0
+    // makes it 2D with rows of shape1 elements.
+    template<typename T>
+    PyObject* toArray(const std::vector<T>& values, const char* typeCode, const char* numpyType,
+                      Py_ssize_t shape0 = 0, Py_ssize_t shape1 = 0) {
+        PyObject* bytes = PyBytes_FromStringAndSize(reinterpret_cast<const char*>(values.data()),
+                                                    Py_ssize_t(values.size() * sizeof(T)));
+        if (!bytes)
+            return nullptr;
+
+        PyObject* res = nullptr;
+        if (PyObject* numpy = PyImport_ImportModule("numpy")) {
+            res = PyObject_CallMethod(numpy, "frombuffer", "Os", bytes, numpyType);
+            if (res && shape0 > 0) {
+                PyObject* reshaped = PyObject_CallMethod(res, "reshape", "nn", shape0, shape1);
+                Py_DECREF(res);
+                res = reshaped;
+            }
+            Py_DECREF(numpy);
+        } else {
+            PyErr_Clear();
+            PyObject* view = PyMemoryView_FromObject(bytes);
+            if (view) {
+                if (shape0 > 0) {
+                    res = PyObject_CallMethod(view, "cast", "s(nn)", typeCode, shape0, shape1);
+                } else {
+                    res = PyObject_CallMethod(view, "cast", "s", typeCode);
+                }
+                Py_DECREF(view);
+            }
+        }
+        Py_DECREF(bytes);
+        return res;
+    }
+
+    // sets key of dict to value and releases value, false if value is null
+    bool setItem(PyObject* dict, const char* key, PyObject* value) {
+        if (!value)
+            return false;
+        const int res = PyDict_SetItemString(dict, key, value);
+        Py_DECREF(value);
+        return res == 0;
+    }
+
+    PyObject* statsToDict(const Stream1090::DecoderStats& stats) {
+        PyObject* res = PyDict_New();
+        if (!res)
+            return nullptr;
+        bool ok = setItem(res, "input_samples",  PyLong_FromUnsignedLongLong(stats.inputSamples))
+               && setItem(res, "blocks",         PyLong_FromUnsignedLongLong(stats.blocks))
+               && setItem(res, "output_samples", PyLong_FromUnsignedLongLong(stats.outputSamples))
+               && setItem(res, "short_frames",   PyLong_FromUnsignedLongLong(stats.shortFrames))
+               && setItem(res, "long_frames",    PyLong_FromUnsignedLongLong(stats.longFrames));
+        if (ok) {
+            std::vector<uint64_t> perDF(stats.framesPerDF.begin(), stats.framesPerDF.end());
+            ok = setItem(res, "frames_per_df", toArray(perDF, "Q", "uint64"));
+        }
+        if (!ok) {
+            Py_DECREF(res);
+            return nullptr;
+        }
+        return res;
+    }
+
+    PyObject* decode(PyObject*, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {
+            "iq", "input_rate", "output_rate", "iq_filter", "taps", "block_size",
+            "chunk_size", "magnitudes", "upsampled", nullptr
+        };
+
+        PyObject* iqObject = nullptr;
+        unsigned long inputRate = 0;
+        unsigned long outputRate = 0;
+        int iqFilter = 0;
+        PyObject* tapsObject = Py_None;
+        Py_ssize_t blockSize = 0;
+        Py_ssize_t chunkSize = 1 << 20;
+        int wantMagnitudes = 0;
+        int wantUpsampled = 0;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Ok|kpOnnpp", const_cast<char**>(keywords),
+                                         &iqObject, &inputRate, &outputRate, &iqFilter, &tapsObject,
+                                         &blockSize, &chunkSize, &wantMagnitudes, &wantUpsampled))
+            return nullptr;
+
+        if (blockSize < 0 || chunkSize <= 0) {
+            PyErr_SetString(PyExc_ValueError, "block_size must not be negative and chunk_size must be positive");
+            return nullptr;
+        }
+
+        Stream1090::DecoderConfig config;
+        config.inputRate = uint32_t(inputRate);
+        config.outputRate = uint32_t(outputRate);
+        config.iqFilter = iqFilter != 0;
+        config.blockSize = size_t(blockSize);
+
+        if (tapsObject != Py_None) {
+            PyObject* seq = PySequence_Fast(tapsObject, "taps must be a sequence of floats");
+            if (!seq)
+                return nullptr;
+            const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+            for (Py_ssize_t i = 0; i < n; i++) {
+                const double tap = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, i));
+                if (tap == -1.0 && PyErr_Occurred()) {
+                    Py_DECREF(seq);
+                    return nullptr;
+                }
+                config.filterTaps.push_back(float(tap));
+            }
+            Py_DECREF(seq);
+        }
+
+        Py_buffer view;
+        if (PyObject_GetBuffer(iqObject, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0)
+            return nullptr;
+
+        if (!formatOf(view, config.format)) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_TypeError, "iq must be an array of uint8, uint16 or float32");
+            return nullptr;
+        }
+
+        DecodeResult result;
+        std::string error;
+        auto decoder = Stream1090::Decoder::create(config, [&](const Stream1090::Frame& frame) {
+            result.mlatTime.push_back(frame.mlatTime);
+            result.sampleIndex.push_back(frame.sampleIndex);
+            result.rssi.push_back(frame.rssi);
+            result.numBytes.push_back(frame.numBytes);
+            result.df.push_back(frame.downlinkFormat());
+            result.frames.insert(result.frames.end(), frame.bytes, frame.bytes + 14);
+        }, &error);
+        if (!decoder) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, error.c_str());
+            return nullptr;
+        }
+
+        if (wantMagnitudes || wantUpsampled) {
+            decoder->setMagnitudeCallback([&](const float* magnitudes, size_t numSamples) {
+                result.magnitudes.insert(result.magnitudes.end(), magnitudes, magnitudes + numSamples);
+            });
+        }
+
+        // the decoder does not touch Python objects, the buffer stays valid until released
+        std::vector<float> upsampled;
+        const size_t valueSize = size_t(view.itemsize);
+        const size_t totalBytes = size_t(view.len) / (2 * valueSize) * (2 * valueSize);
+        const size_t chunkBytes = size_t(chunkSize) * 2 * valueSize;
+        Py_BEGIN_ALLOW_THREADS
+        const char* data = static_cast<const char*>(view.buf);
+        for (size_t pos = 0; pos < totalBytes; pos += chunkBytes)
+            decoder->push(data + pos, std::min(chunkBytes, totalBytes - pos));
+        decoder->finish();
+        if (wantUpsampled)
+            upsampled = decoder->upsample(result.magnitudes.data(), result.magnitudes.size());
+        Py_END_ALLOW_THREADS
+        PyBuffer_Release(&view);
+
+        // the padded last block has no samples behind it
+        const size_t numInput = size_t(decoder->numSamples());
+        if (result.magnitudes.size() > numInput)
+            result.magnitudes.resize(numInput);
+        const uint64_t numOutput = uint64_t(numInput) * decoder->config().outputRate / decoder->config().inputRate;
+        if (upsampled.size() > numOutput)
+            upsampled.resize(size_t(numOutput));
+
+        PyObject* res = PyDict_New();
+        if (!res)
+            return nullptr;
+        const Py_ssize_t numFrames = Py_ssize_t(result.mlatTime.size());
+        bool ok = setItem(res, "mlat_time",    toArray(result.mlatTime, "Q", "uint64"))
+               && setItem(res, "sample_index", toArray(result.sampleIndex, "Q", "uint64"))
+               && setItem(res, "rssi",         toArray(result.rssi, "B", "uint8"))
+               && setItem(res, "num_bytes",    toArray(result.numBytes, "B", "uint8"))
+               && setItem(res, "df",           toArray(result.df, "B", "uint8"))
+               && setItem(res, "frames",       toArray(result.frames, "B", "uint8", numFrames, 14))
+               && setItem(res, "stats",        statsToDict(decoder->stats()))
+               && setItem(res, "output_rate",  PyLong_FromUnsignedLong(decoder->config().outputRate))
+               && setItem(res, "block_size",   PyLong_FromSize_t(decoder->config().blockSize));
+        if (ok && wantMagnitudes)
+            ok = setItem(res, "magnitudes", toArray(result.magnitudes, "f", "float32"));
+        if (ok && wantUpsampled)
+            ok = setItem(res, "upsampled", toArray(upsampled, "f", "float32"));
+        if (!ok) {
+            Py_DECREF(res);
+            return nullptr;
+        }
+        return res;
+    }
+
+    PyMethodDef methods[] = {
+        { "decode", reinterpret_cast<PyCFunction>(reinterpret_cast<void(*)(void)>(decode)), METH_VARARGS | METH_KEYWORDS,
+          "decode(iq, input_rate, output_rate=0, iq_filter=False, taps=None, block_size=0,\n"
+          "       chunk_size=1048576, magnitudes=False, upsampled=False) -> dict\n\n"
+          "Decodes interleaved IQ values (uint8, uint16 or float32) at input_rate Hz.\n"
+          "output_rate 0 is the default of the input rate. chunk_size IQ pairs are\n"
+          "pushed at once. Returns the frames as arrays with one entry per frame\n"
+          "(mlat_time, sample_index, rssi, num_bytes, df and frames with 14 bytes\n"
+          "per row), the stats of the stages and on request the magnitudes after\n"
+          "the IQ pipeline and the upsampled magnitudes the slicer compares." },
+        { nullptr, nullptr, 0, nullptr }
+    };
+
+    PyModuleDef moduleDef = {
+        PyModuleDef_HEAD_INIT, "stream1090", "In-process decoding with libstream1090", -1, methods,
+        nullptr, nullptr, nullptr, nullptr
+    };
+
+} // end of anonymous namespace
+
+PyMODINIT_FUNC PyInit_stream1090() {
+    return PyModule_Create(&moduleDef);
+}
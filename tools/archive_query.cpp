@@ -0,0 +1,299 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Queries the frame archive written by stream1090 -a. Selects the frames by
+// time range, address and downlink format and writes them as AVR or Beast.
+// Only the blocks the segment index points to are read and decompressed.
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Global.hpp"
+#include "AVRWriter.hpp"
+#include "BeastWriter.hpp"
+#include "FrameArchive.hpp"
+
+namespace {
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  archive_query [options] <segment file or directory>...\n\n"
+    "Options:\n"
+    "  --from <time>        Only frames at or after this time\n"
+    "  --to <time>          Only frames before this time\n"
+    "                       Times are unix seconds or YYYY-MM-DDTHH:MM:SS (UTC)\n"
+    "  --icao <hex,...>     Only frames of these addresses\n"
+    "  --df <n,...>         Only these downlink formats\n"
+    "  --format <avr|beast> Output format (default: avr)\n"
+    "  --list               Print a summary of the segments instead of the frames\n";
+}
+
+struct QueryArgs {
+    std::vector<std::string> inputs;
+    int64_t fromMicros = INT64_MIN;
+    int64_t toMicros = INT64_MAX;
+    std::vector<uint32_t> icaos;
+    uint32_t dfMask = 0xffffffff;
+    bool beast = false;
+    bool list = false;
+};
+
+bool parse_time(const std::string& s, int64_t& micros) {
+    std::tm tm{};
+    std::istringstream in(s);
+    in >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if (!in.fail()) {
+        micros = int64_t(timegm(&tm)) * 1'000'000;
+        return true;
+    }
+    try {
+        micros = int64_t(std::stod(s) * 1e6);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+template<typename F>
+bool parse_list(const std::string& s, F&& parseOne) {
+    std::istringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (item.empty())
+            continue;
+        try {
+            parseOne(item);
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_args(int argc, char** argv, QueryArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--from" && i + 1 < argc) {
+            if (!parse_time(argv[++i], out.fromMicros)) return false;
+            continue;
+        }
+        if (arg == "--to" && i + 1 < argc) {
+            if (!parse_time(argv[++i], out.toMicros)) return false;
+            continue;
+        }
+        if (arg == "--icao" && i + 1 < argc) {
+            if (!parse_list(argv[++i], [&](const std::string& s) { out.icaos.push_back(uint32_t(std::stoul(s, nullptr, 16))); }))
+                return false;
+            continue;
+        }
+        if (arg == "--df" && i + 1 < argc) {
+            out.dfMask = 0;
+            if (!parse_list(argv[++i], [&](const std::string& s) { out.dfMask |= uint32_t(1) << (std::stoul(s) & 0x1f); }))
+                return false;
+            continue;
+        }
+        if (arg == "--format" && i + 1 < argc) {
+            const std::string f = argv[++i];
+            if (f != "avr" && f != "beast") return false;
+            out.beast = (f == "beast");
+            continue;
+        }
+        if (arg == "--list") { out.list = true; continue; }
+        if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+            return false;
+        }
+        out.inputs.push_back(arg);
+    }
+    std::sort(out.icaos.begin(), out.icaos.end());
+    return !out.inputs.empty();
+}
+
+// the segment files, directories are expanded and sorted by name, i.e. by time
+std::vector<std::string> collect_segments(const std::vector<std::string>& inputs) {
+    std::vector<std::string> result;
+    for (const auto& in : inputs) {
+        if (!std::filesystem::is_directory(in)) {
+            result.push_back(in);
+            continue;
+        }
+        std::vector<std::string> files;
+        for (const auto& e : std::filesystem::directory_iterator(in)) {
+            if (e.is_regular_file() && e.path().extension() == FrameArchive::FileExtension)
+                files.push_back(e.path().string());
+        }
+        std::sort(files.begin(), files.end());
+        result.insert(result.end(), files.begin(), files.end());
+    }
+    return result;
+}
+
+std::string format_time(int64_t micros) {
+    const std::time_t t = std::time_t(micros / 1'000'000);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+    return buf;
+}
+
+struct QueryStats {
+    uint64_t numSegments = 0;
+    uint64_t numBlocks = 0;
+    uint64_t numBlocksRead = 0;
+    uint64_t numFrames = 0;
+};
+
+class Query {
+public:
+    Query(const QueryArgs& args) : m_args(args), m_avr(std::cout), m_beast(std::cout) {}
+
+    void run(const std::string& path) {
+        FrameArchive::SegmentReader reader;
+        if (!reader.open(path)) {
+            std::cerr << "[archive_query] Cannot read segment " << path << std::endl;
+            return;
+        }
+        m_stats.numSegments++;
+        m_stats.numBlocks += reader.blocks().size();
+
+        if (m_args.list) {
+            list(path, reader);
+            return;
+        }
+
+        const int64_t epoch = reader.header().epochMicros;
+        for (size_t b : candidates(reader)) {
+            const auto& block = reader.blocks()[b];
+            if (!(block.dfMask & m_args.dfMask)
+                || wallClock(epoch, block.maxMlat) < m_args.fromMicros
+                || wallClock(epoch, block.minMlat) >= m_args.toMicros)
+                continue;
+
+            if (!reader.readBlock(b, m_records)) {
+                std::cerr << "[archive_query] Block " << b << " of " << path << " is corrupt" << std::endl;
+                continue;
+            }
+            m_stats.numBlocksRead++;
+            for (const auto& r : m_records) {
+                if (matches(epoch, r))
+                    write(r);
+            }
+        }
+    }
+
+    const QueryStats& stats() const noexcept { return m_stats; }
+
+private:
+    static int64_t wallClock(int64_t epochMicros, uint64_t mlat) {
+        return epochMicros + int64_t(mlat / 12);
+    }
+
+    // the blocks that may contain the requested addresses, ascending
+    std::vector<size_t> candidates(const FrameArchive::SegmentReader& reader) const {
+        std::vector<size_t> result;
+        if (m_args.icaos.empty() || !reader.hasIcaoIndex()) {
+            for (size_t b = 0; b < reader.blocks().size(); b++)
+                result.push_back(b);
+            return result;
+        }
+        for (uint32_t icao : m_args.icaos) {
+            for (uint32_t b : reader.blocksOf(icao))
+                result.push_back(b);
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    bool matches(int64_t epoch, const FrameArchive::Record& r) const {
+        const int64_t t = wallClock(epoch, r.mlat);
+        if (t < m_args.fromMicros || t >= m_args.toMicros)
+            return false;
+        if (!(m_args.dfMask & (uint32_t(1) << FrameArchive::downlinkFormat(r))))
+            return false;
+        if (!m_args.icaos.empty()
+            && !std::binary_search(m_args.icaos.begin(), m_args.icaos.end(), FrameArchive::address(r)))
+            return false;
+        return true;
+    }
+
+    void write(const FrameArchive::Record& r) {
+        m_stats.numFrames++;
+        if (m_args.beast) {
+            if (r.isLong)
+                m_beast.write_long(r.mlat, r.frame, r.rssi);
+            else
+                m_beast.write_short(r.mlat, r.frame.low(), r.rssi);
+        } else {
+            if (r.isLong)
+                m_avr.write_long_MLAT_RSSI(r.mlat, r.frame, r.rssi);
+            else
+                m_avr.write_short_MLAT_RSSI(r.mlat, r.frame.low(), r.rssi);
+        }
+    }
+
+    void list(const std::string& path, const FrameArchive::SegmentReader& reader) {
+        const auto& blocks = reader.blocks();
+        uint64_t numFrames = 0;
+        uint64_t minMlat = UINT64_MAX;
+        uint64_t maxMlat = 0;
+        for (const auto& b : blocks) {
+            numFrames += b.numFrames;
+            minMlat = std::min(minMlat, b.minMlat);
+            maxMlat = std::max(maxMlat, b.maxMlat);
+        }
+        const int64_t epoch = reader.header().epochMicros;
+        std::cout << path << ": " << blocks.size() << " blocks, " << numFrames << " frames";
+        if (!blocks.empty())
+            std::cout << ", " << format_time(wallClock(epoch, minMlat)) << " - " << format_time(wallClock(epoch, maxMlat));
+        if (!reader.hasIcaoIndex())
+            std::cout << ", no index (not closed properly)";
+        std::cout << std::endl;
+    }
+
+    const QueryArgs& m_args;
+    AVRWriter m_avr;
+    BeastWriter m_beast;
+    std::vector<FrameArchive::Record> m_records;
+    QueryStats m_stats;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QueryArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    const auto segments = collect_segments(args.inputs);
+    if (segments.empty()) {
+        std::cerr << "[archive_query] No segments found" << std::endl;
+        return 1;
+    }
+
+    Query query(args);
+    for (const auto& s : segments) {
+        query.run(s);
+    }
+    std::cout.flush();
+
+    const auto& stats = query.stats();
+    std::cerr << "[archive_query] " << stats.numFrames << " frames from " << stats.numBlocksRead << " of "
+              << stats.numBlocks << " blocks in " << stats.numSegments << " segments" << std::endl;
+    return 0;
+}
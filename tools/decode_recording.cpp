@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Decodes a raw IQ recording with libstream1090, the example for embedding
+// the decoder. The recording is read in chunks and pushed into the decoder,
+// the frames are printed in the AVR format with MLAT timestamp and RSSI, the
+// same lines stream1090 prints for the recording.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Stream1090Decoder.hpp"
+
+namespace {
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  decode_recording -s <rate> [-u <rate>] [-q] [-c <bytes>] <recording>\n\n"
+    "Options:\n"
+    "  -s <rate>     Input sample rate in MHz (required), uint8 IQ below 6, uint16 IQ from 6\n"
+    "  -u <rate>     Output sample rate in MHz, the default of the input rate if omitted\n"
+    "  -q            Enable the IQ low pass filter\n"
+    "  -c <bytes>    Bytes pushed at once (default 1000000)\n";
+}
+
+struct DecodeArgs {
+    double inputRate = 0.0;
+    double outputRate = 0.0;
+    bool iqFilter = false;
+    size_t chunkSize = 1000000;
+    std::string recording;
+};
+
+bool parse_args(int argc, char** argv, DecodeArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-s" && i + 1 < argc) { out.inputRate = std::atof(argv[++i]); continue; }
+        if (arg == "-u" && i + 1 < argc) { out.outputRate = std::atof(argv[++i]); continue; }
+        if (arg == "-q") { out.iqFilter = true; continue; }
+        if (arg == "-c" && i + 1 < argc) { out.chunkSize = std::strtoull(argv[++i], nullptr, 10); continue; }
+        if (arg[0] != '-' && out.recording.empty()) { out.recording = arg; continue; }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    return out.inputRate > 0.0 && out.chunkSize > 0 && !out.recording.empty();
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char** argv) {
+    DecodeArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    Stream1090::DecoderConfig config;
+    config.inputRate = uint32_t(args.inputRate * 1e6 + 0.5);
+    config.outputRate = uint32_t(args.outputRate * 1e6 + 0.5);
+    config.format = (config.inputRate < 6000000) ? Stream1090::Format::IQ_UINT8 : Stream1090::Format::IQ_UINT16;
+    config.iqFilter = args.iqFilter;
+
+    size_t numFrames = 0;
+    std::string error;
+    auto decoder = Stream1090::Decoder::create(config, [&](const Stream1090::Frame& frame) {
+        std::printf("<%012llX%02X", (unsigned long long)(frame.mlatTime & 0xffffffffffffull), frame.rssi);
+        for (int i = 0; i < frame.numBytes; i++)
+            std::printf("%02X", frame.bytes[i]);
+        std::printf(";\n");
+        numFrames++;
+    }, &error);
+    if (!decoder) {
+        std::cerr << "[decode_recording] " << error << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(args.recording, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "[decode_recording] Cannot open " << args.recording << std::endl;
+        return 1;
+    }
+
+    // a partial value at the end of a chunk is pushed with the next one
+    const size_t valueSize = (config.format == Stream1090::Format::IQ_UINT8) ? 1 : 2;
+    std::vector<char> chunk(args.chunkSize + valueSize);
+    size_t carry = 0;
+    while (file) {
+        file.read(chunk.data() + carry, std::streamsize(args.chunkSize));
+        const size_t numBytes = carry + size_t(file.gcount());
+        const size_t n = numBytes / valueSize * valueSize;
+        decoder->push(chunk.data(), n);
+        carry = numBytes - n;
+        std::copy(chunk.begin() + n, chunk.begin() + numBytes, chunk.begin());
+    }
+    decoder->finish();
+
+    std::cerr << "[decode_recording] " << numFrames << " frames in "
+              << double(decoder->numSamples()) / double(config.inputRate) << " s, "
+              << double(decoder->config().outputRate) / 1e6 << " MHz output, block of "
+              << decoder->config().blockSize << " samples" << std::endl;
+    return 0;
+}
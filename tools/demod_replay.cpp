@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Replays a bit capture (stream1090 -b) through the demodulator only.
+// Neither the IQ pipeline nor the sampler is involved, hence experiments
+// with DemodCore run much faster and are reproducible bit by bit.
+// The output is the same AVR output stream1090 produced while capturing.
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "Presets.hpp"
+#include "DemodCore.hpp"
+#include "BitCapture.hpp"
+#include "MessageHandler.hpp"
+
+namespace {
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  demod_replay -i <capture file> [-c] [--coarse]\n\n"
+    "Options:\n"
+    "  -i <capture file>    Bit capture written by stream1090 -b (required)\n"
+    "  -c                   Only count the frames. Prints\n"
+    "                       <total> <long> <DF 0 count> ... <DF 31 count>\n"
+    "  --coarse             Demodulate the coarse phases only and refine the others\n"
+    "                       around likely frames, as stream1090 --coarse\n";
+}
+
+struct ReplayArgs {
+    std::string captureFile;
+    bool countOnly = false;
+    bool coarsePhases = false;
+};
+
+bool parse_args(int argc, char** argv, ReplayArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-i" && i + 1 < argc) { out.captureFile = argv[++i]; continue; }
+        if (arg == "-c") { out.countOnly = true; continue; }
+        if (arg == "--coarse") { out.coarsePhases = true; continue; }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    return !out.captureFile.empty();
+}
+
+// hands out the RSSI that was recorded for the current tick
+struct ReplayRssi {
+    uint8_t rssi = 0;
+    uint8_t getRSSI() const noexcept { return rssi; }
+};
+
+template<int NumStreams, typename Handler, int PhaseStep = 1>
+uint64_t replay(BitCapture::Reader& reader, Handler& handler, ReplayRssi& rssi) {
+    // the demodulator is large, keep it off the stack
+    auto demodCore = std::make_unique<DemodCore<NumStreams, Handler, DefaultDemodPolicy, PhaseStep>>(handler);
+    uint32_t bits[NumStreams];
+    uint64_t numTicks = 0;
+    while (reader.next(bits, rssi.rssi)) {
+        demodCore->shiftInNewBits(bits);
+        numTicks++;
+    }
+    return numTicks;
+}
+
+// replays with the coarse phases if requested and the number of streams allows them
+template<int NumStreams, typename Handler>
+uint64_t replay(BitCapture::Reader& reader, Handler& handler, ReplayRssi& rssi, bool coarsePhases) {
+    constexpr int PhaseStep = coarsePhaseStep(NumStreams);
+    if constexpr (PhaseStep > 1) {
+        if (coarsePhases)
+            return replay<NumStreams, Handler, PhaseStep>(reader, handler, rssi);
+    }
+    return replay<NumStreams>(reader, handler, rssi);
+}
+
+template<typename Sampler>
+int run(BitCapture::Reader& reader, const ReplayArgs& args) {
+    constexpr int NumStreams = Sampler::NumStreams;
+    ReplayRssi rssi;
+    uint64_t numTicks = 0;
+    if (args.coarsePhases && coarsePhaseStep(NumStreams) == 1)
+        std::cerr << "[demod_replay] Too few streams for coarse phases, demodulating all" << std::endl;
+
+    const auto start = std::chrono::steady_clock::now();
+    if (args.countOnly) {
+        CountingMessageHandler handler;
+        numTicks = replay<NumStreams>(reader, handler, rssi, args.coarsePhases);
+        std::cout << handler.total() << " " << handler.numLong();
+        for (int df = 0; df < 32; df++) {
+            std::cout << " " << handler.perDF(df);
+        }
+        std::cout << "\n";
+    } else if constexpr (GlobalOptions::RSSIEnabled) {
+        RssiStdOutMessageHandler<Sampler, ReplayRssi> handler(rssi);
+        numTicks = replay<NumStreams>(reader, handler, rssi, args.coarsePhases);
+    } else {
+        StdOutMessageHandler<Sampler> handler;
+        numTicks = replay<NumStreams>(reader, handler, rssi, args.coarsePhases);
+    }
+    std::cout.flush();
+    const auto end = std::chrono::steady_clock::now();
+
+    const double secs = std::chrono::duration<double>(end - start).count();
+    std::cerr << "[demod_replay] Replayed " << numTicks << " ticks (" << double(numTicks) / 1e6
+              << "s of signal) in " << secs << "s" << std::endl;
+    return 0;
+}
+
+} // end of namespace
+
+int main(int argc, char** argv) {
+    ReplayArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    BitCapture::Reader reader;
+    if (!reader.open(args.captureFile)) {
+        std::cerr << "[demod_replay] Cannot open bit capture " << args.captureFile << std::endl;
+        return 1;
+    }
+
+    const auto& header = reader.header();
+    std::cerr << "[demod_replay] Capture " << header.inputRate / 1e6 << " -> " << header.outputRate / 1e6
+              << " MHz, " << header.numStreams << " streams" << std::endl;
+
+    // DemodCore only depends on the number of streams. Any preset with
+    // a matching sampler will do.
+    int res = 1;
+    const bool found = for_each_in_tuple(presets, [&](auto const& p) {
+        using P = std::decay_t<decltype(p)>;
+        if (P::SamplerType::NumStreams == int(header.numStreams)) {
+            res = run<typename P::SamplerType>(reader, args);
+            return true;
+        }
+        return false;
+    });
+
+    if (!found) {
+        std::cerr << "[demod_replay] No preset with " << header.numStreams << " streams" << std::endl;
+        return 1;
+    }
+    return res;
+}
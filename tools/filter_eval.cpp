@@ -0,0 +1,196 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Batch evaluation of FIR tap candidates. The recording is loaded once,
+// candidates are decoded in parallel and the per DF counts are reported.
+// Used by filter_utils/filter_opt.py instead of spawning stream1090 for
+// every single candidate.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "FilterEvaluator.hpp"
+#include "CliHelpers.hpp"
+
+namespace {
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  filter_eval -s <rate> [-u <rate>] -i <recording> [-j <threads>] [-f <taps file>]...\n\n"
+    "Options:\n"
+    "  -s <rate>            Input sample rate in MHz (required)\n"
+    "  -u <rate>            Upsample rate in MHz\n"
+    "  -i <recording>       Raw recording to decode (required)\n"
+    "  -j <threads>         Number of worker threads (default: all cores)\n"
+    "  -f <taps file>       Evaluate this taps file. May be given multiple times.\n\n"
+    "Without -f, candidates are read from stdin, one per line. A line holds the taps\n"
+    "separated by commas or whitespace, or the word 'builtin' for the built-in taps.\n"
+    "A line with a single '.' evaluates all candidates read so far in parallel.\n"
+    "For every candidate one line is written to stdout:\n"
+    "  <total> <long> <DF 0 count> ... <DF 31 count>\n";
+}
+
+struct EvalArgs {
+    std::string sampleRate;
+    std::string upsampleRate;
+    std::string recording;
+    std::vector<std::string> tapsFiles;
+    size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+bool parse_args(int argc, char** argv, EvalArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-s" && i + 1 < argc) { out.sampleRate = argv[++i]; continue; }
+        if (arg == "-u" && i + 1 < argc) { out.upsampleRate = argv[++i]; continue; }
+        if (arg == "-i" && i + 1 < argc) { out.recording = argv[++i]; continue; }
+        if (arg == "-f" && i + 1 < argc) { out.tapsFiles.push_back(argv[++i]); continue; }
+        if (arg == "-j" && i + 1 < argc) { out.numThreads = std::max(1, std::stoi(argv[++i])); continue; }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    return !out.sampleRate.empty() && !out.recording.empty();
+}
+
+// parses a line of taps. Returns false if the line is malformed.
+bool parse_taps_line(const std::string& line, std::vector<float>& taps) {
+    std::string s = line;
+    std::replace(s.begin(), s.end(), ',', ' ');
+    std::istringstream iss(s);
+    double v;
+    while (iss >> v) {
+        taps.push_back((float)v);
+    }
+    return iss.eof() && !taps.empty() && taps.size() <= MaxNumTapsFromFile;
+}
+
+void print_counts(const DecodeCounts& c) {
+    std::cout << c.total << " " << c.numLong;
+    for (auto n : c.perDF) {
+        std::cout << " " << n;
+    }
+    std::cout << "\n";
+}
+
+template<typename P>
+int run(const EvalArgs& args) {
+    using Evaluator = FilterEvaluator<P>;
+    using RawType = typename Evaluator::RawType;
+
+    const auto recording = loadRecording<RawType>(args.recording);
+    if (recording.empty()) {
+        std::cerr << "[filter_eval] Cannot load recording " << args.recording << std::endl;
+        return 1;
+    }
+    std::cerr << "[filter_eval] Loaded " << recording.size() / 2 << " IQ pairs ("
+              << double(recording.size() / 2) / double(Evaluator::rawRate) << "s) from "
+              << args.recording << std::endl;
+
+    const auto builtin = LowPassTaps::getCustomTaps<Evaluator::inputRate, Evaluator::outputRate>();
+    const std::vector<float> builtinTaps(builtin.begin(), builtin.end());
+
+    Evaluator evaluator(recording);
+
+    // evaluate the given files and leave
+    if (!args.tapsFiles.empty()) {
+        std::vector<std::vector<float>> candidates;
+        for (const auto& f : args.tapsFiles) {
+            candidates.push_back(load_taps_from_file(f));
+            if (candidates.back().empty()) {
+                std::cerr << "[filter_eval] Error loading taps from " << f << std::endl;
+                return 1;
+            }
+        }
+        for (const auto& c : evaluator.evaluateBatch(candidates, args.numThreads)) {
+            print_counts(c);
+        }
+        return 0;
+    }
+
+    // otherwise serve batches from stdin
+    std::vector<std::vector<float>> candidates;
+    auto flush = [&]() {
+        for (const auto& c : evaluator.evaluateBatch(candidates, args.numThreads)) {
+            print_counts(c);
+        }
+        std::cout.flush();
+        candidates.clear();
+    };
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line == ".") {
+            flush();
+            continue;
+        }
+
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        if (line == "builtin") {
+            candidates.push_back(builtinTaps);
+            continue;
+        }
+
+        std::vector<float> taps;
+        if (!parse_taps_line(line, taps)) {
+            std::cerr << "[filter_eval] Malformed taps line: " << line << std::endl;
+            return 1;
+        }
+        candidates.push_back(std::move(taps));
+    }
+    flush();
+    return 0;
+}
+
+} // end of namespace
+
+int main(int argc, char** argv) {
+    EvalArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    const SampleRate inputRate = parse_sample_rate(args.sampleRate);
+    const SampleRate outputRate = args.upsampleRate.empty() ? SampleRate(0) : parse_sample_rate(args.upsampleRate);
+
+    // same format selection as stream1090 itself. Candidates are always
+    // evaluated with the dynamic filter that is also used for -f
+    InputFormatType rawFormat = InputFormatType::IQ_FLOAT32;
+    IQPipelineOptions option = IQPipelineOptions::NONE;
+    if (!GlobalOptions::CustomInputMode) {
+        const bool isRtlSdr = (inputRate < Rate_6_0_Mhz);
+        rawFormat = isRtlSdr ? InputFormatType::IQ_UINT8_RTL_SDR : InputFormatType::IQ_UINT16_RAW_AIRSPY;
+        option = isRtlSdr ? IQPipelineOptions::IQ_FIR_RTL_SDR_FILE : IQPipelineOptions::IQ_FIR_FILE;
+    }
+
+    int res = 1;
+    const bool found = for_each_in_tuple(presets, [&](auto const& p) {
+        using P = std::decay_t<decltype(p)>;
+        if (P::RawFormatType::id == rawFormat &&
+            P::inputRate         == inputRate &&
+            (outputRate == 0 || P::outputRate == outputRate) &&
+            P::pipelineOption    == option)
+        {
+            res = run<P>(args);
+            return true;
+        }
+        return false;
+    });
+
+    if (!found) {
+        std::cerr << "[filter_eval] Configuration is not supported: " << args.sampleRate
+                  << " -> " << (args.upsampleRate.empty() ? "default" : args.upsampleRate) << std::endl;
+        return 1;
+    }
+    return res;
+}
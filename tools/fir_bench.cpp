@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Measures the cost of the custom FIR filter (IQLowPassDynamic) per IQ pair,
+// once with the direct convolution and once with the FFT, for a range of tap
+// counts. Both filter the same random IQ pairs in blocks like InputReaderBase.
+// The largest difference between the two outputs is printed as well.
+//
+// IQLowPassDynamic::FFTCrossoverTaps is the first tap count of this table at
+// which the FFT is faster.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CpuDispatch.hpp"
+#include "LowPassFilter.hpp"
+
+namespace {
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  fir_bench [options]\n\n"
+    "Options:\n"
+    "  -n <pairs>       IQ pairs filtered per measurement (default: 4000000)\n"
+    "  --taps <list>    Comma separated tap counts (default: 8,16,32,48,64,96,128,192,256,384,512,768,1024)\n"
+    "  --isa <name>     Caps the kernels: baseline, avx2 or avx512 (default: best)\n";
+}
+
+using Filter = IQLowPassDynamic<>;
+
+struct BenchArgs {
+    size_t numPairs = 4000000;
+    std::vector<size_t> numTaps { 8, 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+};
+
+bool parse_args(int argc, char** argv, BenchArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const bool hasValue = (i + 1 < argc);
+        if (arg == "-n" && hasValue) { out.numPairs = std::stoull(argv[++i]); continue; }
+        if (arg == "--taps" && hasValue) {
+            out.numTaps.clear();
+            std::istringstream in(argv[++i]);
+            for (std::string item; std::getline(in, item, ','); )
+                out.numTaps.push_back(std::stoull(item));
+            continue;
+        }
+        if (arg == "--isa" && hasValue) {
+            CpuDispatch::Isa isa;
+            if (!CpuDispatch::parse(argv[++i], isa))
+                return false;
+            CpuDispatch::limit(isa);
+            continue;
+        }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    for (const auto n : out.numTaps) {
+        if (n == 0 || n > Filter().maxNumTaps())
+            return false;
+    }
+    return out.numPairs > 0 && !out.numTaps.empty();
+}
+
+// a windowed sinc low pass, symmetric like the ones of filter_opt.py
+std::vector<float> makeTaps(size_t numTaps) {
+    std::vector<float> taps(numTaps);
+    const double center = double(numTaps - 1) / 2.0;
+    const double cutoff = 0.2;
+    for (size_t k = 0; k < numTaps; k++) {
+        const double x = double(k) - center;
+        const double sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        const double window = (numTaps > 1) ? 0.54 - 0.46 * std::cos(2.0 * M_PI * double(k) / double(numTaps - 1)) : 1.0;
+        taps[k] = float(sinc * window);
+    }
+    return taps;
+}
+
+// the same blocks InputReaderBase hands to a pipeline with this filter
+constexpr size_t ChunkSize = Filter::PreferredBlockSize;
+
+STREAM1090_FORCE_INLINE void filterLoop(Filter& filter, float* I, float* Q, size_t n) {
+    for (size_t pos = 0; pos < n; pos += ChunkSize)
+        filter.applyBlock(I + pos, Q + pos, std::min(ChunkSize, n - pos));
+}
+
+STREAM1090_TARGET_AVX2 void filterAVX2(Filter& filter, float* I, float* Q, size_t n) {
+    filterLoop(filter, I, Q, n);
+}
+
+STREAM1090_TARGET_AVX512 void filterAVX512(Filter& filter, float* I, float* Q, size_t n) {
+    filterLoop(filter, I, Q, n);
+}
+
+void filterBlocks(Filter& filter, float* I, float* Q, size_t n) {
+    switch (CpuDispatch::selected()) {
+        case CpuDispatch::Isa::AVX512: filterAVX512(filter, I, Q, n); break;
+        case CpuDispatch::Isa::AVX2:   filterAVX2(filter, I, Q, n);   break;
+        default:                       filterLoop(filter, I, Q, n);   break;
+    }
+}
+
+// filters a copy of the input, returns the nanoseconds per pair
+double measure(Filter& filter, const std::vector<float>& inI, const std::vector<float>& inQ,
+               std::vector<float>& I, std::vector<float>& Q) {
+    I = inI;
+    Q = inQ;
+    const auto start = std::chrono::steady_clock::now();
+    filterBlocks(filter, I.data(), Q.data(), I.size());
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / double(I.size());
+}
+
+} // end of namespace
+
+int main(int argc, char** argv) {
+    BenchArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    std::mt19937 rng(1090);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> inI(args.numPairs), inQ(args.numPairs);
+    for (size_t i = 0; i < args.numPairs; i++) {
+        inI[i] = dist(rng);
+        inQ[i] = dist(rng);
+    }
+
+    std::cout << "# kernels: " << CpuDispatch::name(CpuDispatch::selected()) << ", "
+              << args.numPairs << " IQ pairs in blocks of " << ChunkSize << "\n"
+              << "#  taps   direct ns/pair   fft ns/pair   max diff\n";
+    std::vector<float> directI, directQ, fftI, fftQ;
+    for (const auto numTaps : args.numTaps) {
+        const auto taps = makeTaps(numTaps);
+        // the filters are too large for the stack
+        auto direct = std::make_unique<Filter>(taps);
+        auto fft = std::make_unique<Filter>(taps);
+        direct->setEngine(Filter::Engine::Direct);
+        fft->setEngine(Filter::Engine::FFT);
+
+        const double directNs = measure(*direct, inI, inQ, directI, directQ);
+        const double fftNs = measure(*fft, inI, inQ, fftI, fftQ);
+        float maxDiff = 0.0f;
+        for (size_t i = 0; i < args.numPairs; i++)
+            maxDiff = std::max({ maxDiff, std::fabs(directI[i] - fftI[i]), std::fabs(directQ[i] - fftQ[i]) });
+
+        std::cout << std::setw(7) << numTaps << std::fixed << std::setprecision(2)
+                  << std::setw(17) << directNs << std::setw(14) << fftNs
+                  << std::scientific << std::setprecision(1) << std::setw(11) << maxDiff
+                  << (fft->usesFFT() ? "" : "   (no fft)") << "\n" << std::defaultfloat;
+    }
+    return 0;
+}
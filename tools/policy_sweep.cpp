@@ -0,0 +1,324 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Parameter sweep over the demodulator policy (see DemodPolicy.hpp).
+// A bit capture (stream1090 -b) is loaded once and replayed with every
+// combination of the given values in parallel. The combinations are
+// ranked by decoded frames minus duplicates minus likely false positives.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Presets.hpp"
+#include "DemodCore.hpp"
+#include "DemodPolicy.hpp"
+#include "BitCapture.hpp"
+
+namespace {
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  policy_sweep -i <capture file> [options]\n\n"
+    "Options:\n"
+    "  -i <capture file>          Bit capture written by stream1090 -b (required)\n"
+    "  -j <threads>               Number of worker threads (default: all cores)\n"
+    "  --ttl <list>               Values for TTL_not_trusted in seconds\n"
+    "  --ttl-trusted <list>       Values for TTL_trusted in seconds\n"
+    "  --alt <list>               Values for ALT_delta_ft\n"
+    "  --dup <list>               Values for the dup window in microseconds\n"
+    "  --df17 <list>              DF17 error table: basic, experimental\n"
+    "  --ap-repair <list>         Repair of DF 0, 4, 5, 16, 20, 21: off, on\n"
+    "  --min-frames <n>           Addresses with less frames count as false positives (default: 3)\n"
+    "  --dup-check <us>           Identical frames closer than this count as duplicates (default: 1000)\n\n"
+    "Lists are comma separated. Options that are not given use the default of stream1090.\n";
+}
+
+struct SweepArgs {
+    std::string captureFile;
+    size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<uint16_t> ttl { DefaultDemodPolicy::TTL_not_trusted };
+    std::vector<uint16_t> ttlTrusted { DefaultDemodPolicy::TTL_trusted };
+    std::vector<int> altDelta { DefaultDemodPolicy::ALT_delta_ft };
+    std::vector<uint64_t> dupWindow { DefaultDemodPolicy::DupWindowTicks };
+    std::vector<bool> df17Experimental { DefaultDemodPolicy::DF17Experimental };
+    std::vector<bool> apRepair { DefaultDemodPolicy::AddressParityRepair };
+    uint32_t minFrames = 3;
+    uint64_t dupCheckMicros = 1000;
+};
+
+template<typename T>
+bool parse_list(const std::string& str, std::vector<T>& out) {
+    out.clear();
+    std::string s = str;
+    std::replace(s.begin(), s.end(), ',', ' ');
+    std::istringstream iss(s);
+    long long v;
+    while (iss >> v) {
+        if (v < 0)
+            return false;
+        out.push_back(T(v));
+    }
+    return iss.eof() && !out.empty();
+}
+
+bool parse_df17_list(const std::string& str, std::vector<bool>& out) {
+    out.clear();
+    std::string s = str;
+    std::replace(s.begin(), s.end(), ',', ' ');
+    std::istringstream iss(s);
+    std::string v;
+    while (iss >> v) {
+        if (v == "basic") out.push_back(false);
+        else if (v == "experimental") out.push_back(true);
+        else return false;
+    }
+    return !out.empty();
+}
+
+bool parse_on_off_list(const std::string& str, std::vector<bool>& out) {
+    out.clear();
+    std::string s = str;
+    std::replace(s.begin(), s.end(), ',', ' ');
+    std::istringstream iss(s);
+    std::string v;
+    while (iss >> v) {
+        if (v == "off") out.push_back(false);
+        else if (v == "on") out.push_back(true);
+        else return false;
+    }
+    return !out.empty();
+}
+
+bool parse_args(int argc, char** argv, SweepArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const bool hasValue = (i + 1 < argc);
+        if (arg == "-i" && hasValue) { out.captureFile = argv[++i]; continue; }
+        if (arg == "-j" && hasValue) { out.numThreads = std::max(1, std::stoi(argv[++i])); continue; }
+        if (arg == "--ttl" && hasValue && parse_list(argv[++i], out.ttl)) continue;
+        if (arg == "--ttl-trusted" && hasValue && parse_list(argv[++i], out.ttlTrusted)) continue;
+        if (arg == "--alt" && hasValue && parse_list(argv[++i], out.altDelta)) continue;
+        if (arg == "--dup" && hasValue && parse_list(argv[++i], out.dupWindow)) continue;
+        if (arg == "--df17" && hasValue && parse_df17_list(argv[++i], out.df17Experimental)) continue;
+        if (arg == "--ap-repair" && hasValue && parse_on_off_list(argv[++i], out.apRepair)) continue;
+        if (arg == "--min-frames" && hasValue) { out.minFrames = std::stoul(argv[++i]); continue; }
+        if (arg == "--dup-check" && hasValue) { out.dupCheckMicros = std::stoull(argv[++i]); continue; }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    return !out.captureFile.empty();
+}
+
+struct SweepResult {
+    RuntimeDemodPolicy policy;
+    uint64_t decoded = 0;
+    uint64_t duplicates = 0;
+    uint64_t fpFrames = 0;
+    uint64_t fpAddresses = 0;
+
+    int64_t score() const noexcept {
+        return int64_t(decoded) - int64_t(duplicates) - int64_t(fpFrames);
+    }
+};
+
+// Collects what the demodulator emits. A frame that is identical to one emitted
+// less than dupCheck samples before is a duplicate. Addresses with only very few
+// frames over the whole capture are most likely the result of a bad crc that
+// happened to match, so their frames are counted as false positives.
+template<int NumStreams>
+class SweepMessageHandler {
+public:
+    explicit SweepMessageHandler(uint64_t dupCheckMicros) : m_dupCheck(dupCheckMicros * NumStreams) { }
+
+    void handleShort(uint64_t sampleIndex, const uint64_t frame) {
+        const uint8_t df = (frame >> 51) & 0x1f;
+        const uint32_t address = (df == 11) ? (ModeS::extractICAOWithCA_Short(frame) & 0xffffff)
+                                            : CRC::compute<56>(Bits128(frame));
+        handle(sampleIndex, Bits128(frame), address);
+    }
+
+    void handleLong(uint64_t sampleIndex, const Bits128& frame) {
+        const uint8_t df = (frame.high() >> 43) & 0x1f;
+        const uint32_t address = (df == 17 || df == 18) ? (ModeS::extractICAOWithCA_Long(frame) & 0xffffff)
+                                                        : CRC::compute<112>(frame);
+        handle(sampleIndex, frame, address);
+    }
+
+    void finish(SweepResult& res, uint32_t minFrames) const {
+        res.decoded = m_decoded;
+        res.duplicates = m_duplicates;
+        for (const auto& [address, count] : m_perAddress) {
+            if (count < minFrames) {
+                res.fpAddresses++;
+                res.fpFrames += count;
+            }
+        }
+    }
+
+private:
+    struct Recent {
+        uint64_t time;
+        Bits128 frame;
+    };
+    static constexpr size_t NumRecent = 64;
+
+    void handle(uint64_t sampleIndex, const Bits128& frame, uint32_t address) {
+        m_decoded++;
+        m_perAddress[address]++;
+        // compare against the recently emitted frames, newest first
+        for (size_t k = 1; k <= std::min<uint64_t>(NumRecent, m_numRecent); k++) {
+            const auto& r = m_recent[(m_numRecent - k) % NumRecent];
+            if (sampleIndex - r.time >= m_dupCheck)
+                break;
+            if (r.frame == frame) {
+                m_duplicates++;
+                break;
+            }
+        }
+        m_recent[m_numRecent % NumRecent] = Recent{ sampleIndex, frame };
+        m_numRecent++;
+    }
+
+    uint64_t m_dupCheck;
+    uint64_t m_decoded = 0;
+    uint64_t m_duplicates = 0;
+    std::unordered_map<uint32_t, uint32_t> m_perAddress;
+    std::array<Recent, NumRecent> m_recent;
+    uint64_t m_numRecent = 0;
+};
+
+template<int NumStreams>
+SweepResult evaluate(const BitCapture::Capture& capture, const RuntimeDemodPolicy& policy, const SweepArgs& args) {
+    using Handler = SweepMessageHandler<NumStreams>;
+    Handler handler(args.dupCheckMicros);
+    {
+        // the demodulator is large, keep it off the stack
+        auto demodCore = std::make_unique<DemodCore<NumStreams, Handler, RuntimeDemodPolicy>>(handler, policy);
+        uint32_t bits[NumStreams];
+        uint8_t rssi;
+        for (size_t t = 0; t < capture.numTicks(); t++) {
+            capture.unpack(t, bits, rssi);
+            demodCore->shiftInNewBits(bits);
+        }
+    }
+    SweepResult res;
+    res.policy = policy;
+    handler.finish(res, args.minFrames);
+    return res;
+}
+
+std::vector<RuntimeDemodPolicy> make_grid(const SweepArgs& args) {
+    std::vector<RuntimeDemodPolicy> grid;
+    for (auto ttl : args.ttl)
+    for (auto ttlTrusted : args.ttlTrusted)
+    for (auto alt : args.altDelta)
+    for (auto dup : args.dupWindow)
+    for (auto df17 : args.df17Experimental)
+    for (auto apRepair : args.apRepair) {
+        RuntimeDemodPolicy p;
+        p.TTL_not_trusted = ttl;
+        p.TTL_trusted = ttlTrusted;
+        p.ALT_delta_ft = alt;
+        p.DupWindowTicks = dup;
+        p.DF17Experimental = df17;
+        p.AddressParityRepair = apRepair;
+        grid.push_back(p);
+    }
+    return grid;
+}
+
+template<int NumStreams>
+int run(const BitCapture::Capture& capture, const SweepArgs& args) {
+    const auto grid = make_grid(args);
+    std::vector<SweepResult> results(grid.size());
+    std::atomic<size_t> next{0};
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < grid.size(); i = next++) {
+            results[i] = evaluate<NumStreams>(capture, grid[i], args);
+        }
+    };
+
+    const size_t numThreads = std::max<size_t>(1, std::min(args.numThreads, grid.size()));
+    std::cerr << "[policy_sweep] Evaluating " << grid.size() << " policies on "
+              << numThreads << " threads" << std::endl;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < numThreads; t++) {
+        threads.emplace_back(worker);
+    }
+    // the calling thread helps out
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::stable_sort(results.begin(), results.end(), [](const auto& a, const auto& b) {
+        return a.score() > b.score();
+    });
+
+    std::cout << "# ttl ttl_trusted alt_ft dup_us df17 ap_repair decoded duplicates fp_frames fp_addresses score\n";
+    for (const auto& r : results) {
+        std::cout << std::setw(5) << r.policy.TTL_not_trusted
+                  << std::setw(12) << r.policy.TTL_trusted
+                  << std::setw(7) << r.policy.ALT_delta_ft
+                  << std::setw(7) << r.policy.DupWindowTicks
+                  << (r.policy.DF17Experimental ? "  experimental" : "         basic")
+                  << (r.policy.AddressParityRepair ? "        on" : "       off")
+                  << std::setw(8) << r.decoded
+                  << std::setw(11) << r.duplicates
+                  << std::setw(10) << r.fpFrames
+                  << std::setw(13) << r.fpAddresses
+                  << std::setw(6) << r.score() << "\n";
+    }
+    return 0;
+}
+
+} // end of namespace
+
+int main(int argc, char** argv) {
+    SweepArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    BitCapture::Capture capture;
+    if (!BitCapture::loadCapture(args.captureFile, capture)) {
+        std::cerr << "[policy_sweep] Cannot load bit capture " << args.captureFile << std::endl;
+        return 1;
+    }
+    std::cerr << "[policy_sweep] Loaded " << capture.numTicks() << " ticks with "
+              << capture.header.numStreams << " streams" << std::endl;
+
+    // DemodCore only depends on the number of streams
+    int res = 1;
+    const bool found = for_each_in_tuple(presets, [&](auto const& p) {
+        using P = std::decay_t<decltype(p)>;
+        if (P::SamplerType::NumStreams == int(capture.header.numStreams)) {
+            res = run<P::SamplerType::NumStreams>(capture, args);
+            return true;
+        }
+        return false;
+    });
+
+    if (!found) {
+        std::cerr << "[policy_sweep] No preset with " << capture.header.numStreams << " streams" << std::endl;
+        return 1;
+    }
+    return res;
+}
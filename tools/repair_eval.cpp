@@ -0,0 +1,312 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Measures the repair of frames with address parity (DF 0, 4, 5, 16, 20, 21)
+// on synthetic bits. A set of aircraft is made trusted with DF17 frames, then
+// their replies are fed through DemodCore, either clean, with one or with two
+// flipped bits. Random bits in between show how often noise is "repaired" into
+// a frame. Every setting runs once without and once with the repair.
+//
+// A reply counts as correct if the clean frame comes out, everything else
+// that comes out is a false repair.
+
+#include <array>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DemodCore.hpp"
+#include "DemodPolicy.hpp"
+
+namespace {
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  repair_eval [options]\n\n"
+    "Options:\n"
+    "  -n <count>       Number of trusted aircraft (default: 100)\n"
+    "  -f <count>       Replies per kind of error (default: 20000)\n"
+    "  --noise <bits>   Random bits fed in between (default: 20000000)\n"
+    "  --seed <n>       Seed of the random numbers (default: 1090)\n";
+}
+
+struct EvalArgs {
+    uint32_t numAircraft = 100;
+    uint32_t numFrames = 20000;
+    uint64_t noiseBits = 20000000;
+    uint32_t seed = 1090;
+};
+
+bool parse_args(int argc, char** argv, EvalArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const bool hasValue = (i + 1 < argc);
+        if (arg == "-n" && hasValue) { out.numAircraft = std::stoul(argv[++i]); continue; }
+        if (arg == "-f" && hasValue) { out.numFrames = std::stoul(argv[++i]); continue; }
+        if (arg == "--noise" && hasValue) { out.noiseBits = std::stoull(argv[++i]); continue; }
+        if (arg == "--seed" && hasValue) { out.seed = std::stoul(argv[++i]); continue; }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    return out.numAircraft > 0 && out.numAircraft < 4096;
+}
+
+// the demodulator sees one bit per tick
+constexpr int NumStreams = 1;
+
+// zeros after each frame, the frame has to pass through the whole shift register
+constexpr int GapBits = 160;
+
+struct Aircraft {
+    uint32_t icao;
+    uint16_t altitudeBits;
+    uint16_t squawkBits;
+};
+
+// a frame as it is fed in, short frames are in the low 56 bits
+struct Frame {
+    Bits128 bits;
+    bool isLong;
+};
+
+// keeps what came out of the demodulator since the last clear()
+class CollectingHandler {
+public:
+    void handleShort(uint64_t, const uint64_t frame) {
+        m_frames.push_back(Frame{ Bits128(frame), false });
+    }
+
+    void handleLong(uint64_t, const Bits128& frame) {
+        m_frames.push_back(Frame{ frame, true });
+    }
+
+    const std::vector<Frame>& frames() const noexcept {
+        return m_frames;
+    }
+
+    void clear() noexcept {
+        m_frames.clear();
+    }
+
+private:
+    std::vector<Frame> m_frames;
+};
+
+// altitude code with the Q bit set, i.e. in steps of 25 ft
+uint16_t encodeAltitude(int feet) {
+    const uint16_t n = uint16_t((feet + 1000) / 25);
+    return uint16_t((n & 0xf) | (0x1 << 4) | (((n >> 4) & 0x1) << 5) | ((n >> 5) << 7));
+}
+
+class Generator {
+public:
+    explicit Generator(uint32_t seed) : m_rng(seed) { }
+
+    uint64_t bits(int numBits) {
+        return m_rng() & ((numBits == 64) ? ~0ull : ((0x1ull << numBits) - 1));
+    }
+
+    uint32_t below(uint32_t n) {
+        return uint32_t(m_rng() % n);
+    }
+
+    Aircraft aircraft() {
+        // at least one bit in the upper half, otherwise crc's of noise are too likely
+        const uint32_t icao = uint32_t(bits(24)) | 0x800000u;
+        return Aircraft{ icao, encodeAltitude(int(1000 + below(38000))), uint16_t(bits(13) | 0x1) };
+    }
+
+    // extended squitter with a zero crc
+    Frame extendedSquitter(const Aircraft& a) {
+        const uint64_t high = (17ull << 43) | (5ull << 40) | (uint64_t(a.icao) << 16) | bits(16);
+        Bits128 frame(high, bits(64) & ~0xffffffull);
+        frame = frame ^ Bits128(uint64_t(CRC::compute<112>(frame)));
+        return Frame{ frame, true };
+    }
+
+    // a reply with address parity, DF 0, 4, 16 and 20 carry the altitude, DF 5 and 21 the squawk
+    Frame reply(const Aircraft& a, uint32_t df) {
+        const uint64_t ac = ((df == 5) || (df == 21)) ? a.squawkBits : a.altitudeBits;
+        if (df >= 16) {
+            const uint64_t high = (uint64_t(df) << 43) | (bits(14) << 29) | (ac << 16) | bits(16);
+            Bits128 frame(high, bits(64) & ~0xffffffull);
+            frame = frame ^ Bits128(uint64_t(CRC::compute<112>(frame) ^ a.icao));
+            return Frame{ frame, true };
+        }
+        uint64_t frame = (uint64_t(df) << 51) | (bits(14) << 37) | (ac << 24);
+        frame ^= CRC::compute<56>(Bits128(frame)) ^ a.icao;
+        return Frame{ Bits128(frame), false };
+    }
+
+    // flips a random bit outside of the DF field
+    void flip(Frame& frame, int& lastBit) {
+        const int numBits = frame.isLong ? 112 - 5 : 56 - 5;
+        int bit;
+        do {
+            bit = int(below(uint32_t(numBits)));
+        } while (bit == lastBit);
+        lastBit = bit;
+        CRC::applyFixOp(CRC::encodeFixOp(0x1, uint8_t(bit)), frame.bits, 0);
+    }
+
+private:
+    std::mt19937_64 m_rng;
+};
+
+// the counters of one kind of reply
+struct Result {
+    uint64_t fed = 0;
+    uint64_t correct = 0;
+    uint64_t falseRepairs = 0;
+};
+
+struct Results {
+    Result clean;
+    Result oneBit;
+    Result twoBits;
+    Result noise;
+};
+
+template<typename Core>
+class Feeder {
+public:
+    explicit Feeder(Core& core) : m_core(core) { }
+
+    void bit(uint32_t b) {
+        m_core.shiftInNewBits(&b);
+        m_ticks++;
+    }
+
+    void frame(const Frame& f) {
+        const int numBits = f.isLong ? 112 : 56;
+        for (int i = numBits - 1; i >= 0; i--)
+            bit(f.bits[i]);
+        for (int i = 0; i < GapBits; i++)
+            bit(0);
+    }
+
+    uint64_t ticks() const noexcept {
+        return m_ticks;
+    }
+
+private:
+    Core& m_core;
+    uint64_t m_ticks = 0;
+};
+
+Results evaluate(const EvalArgs& args, bool repair) {
+    RuntimeDemodPolicy policy;
+    policy.AddressParityRepair = repair;
+    using Core = DemodCore<NumStreams, CollectingHandler, RuntimeDemodPolicy>;
+    CollectingHandler handler;
+    auto core = std::make_unique<Core>(handler, policy);
+    Feeder<Core> feeder(*core);
+
+    // the same aircraft and replies for both runs
+    Generator gen(args.seed);
+    std::vector<Aircraft> aircraft;
+    for (uint32_t i = 0; i < args.numAircraft; i++)
+        aircraft.push_back(gen.aircraft());
+
+    // DF17 makes an address trusted, two clean replies of each kind confirm altitude and squawk
+    uint64_t lastRefresh = 0;
+    auto refresh = [&](bool confirm) {
+        for (const auto& a : aircraft) {
+            feeder.frame(gen.extendedSquitter(a));
+            for (int k = 0; confirm && k < 2; k++) {
+                feeder.frame(gen.reply(a, 4));
+                feeder.frame(gen.reply(a, 5));
+            }
+        }
+        // give the index time to pick up the new addresses
+        for (uint32_t i = 0; confirm && i < ICAOTableT<RuntimeDemodPolicy>::ParityIndexRebuildTicks; i++)
+            feeder.bit(0);
+        lastRefresh = feeder.ticks();
+        handler.clear();
+    };
+    refresh(true);
+
+    static constexpr std::array<uint32_t, 6> DownlinkFormats { 0, 4, 5, 16, 20, 21 };
+    auto run = [&](Result& res, int numErrors) {
+        for (uint32_t i = 0; i < args.numFrames; i++) {
+            // keep the addresses trusted
+            if (feeder.ticks() - lastRefresh > 5000000)
+                refresh(false);
+            const auto& a = aircraft[gen.below(uint32_t(aircraft.size()))];
+            const Frame clean = gen.reply(a, DownlinkFormats[gen.below(DownlinkFormats.size())]);
+            Frame broken = clean;
+            int lastBit = -1;
+            for (int k = 0; k < numErrors; k++)
+                gen.flip(broken, lastBit);
+
+            handler.clear();
+            feeder.frame(broken);
+            res.fed++;
+            for (const auto& f : handler.frames()) {
+                if ((f.isLong == clean.isLong) && (f.bits == clean.bits))
+                    res.correct++;
+                else
+                    res.falseRepairs++;
+            }
+        }
+    };
+
+    Results res;
+    run(res.clean, 0);
+    run(res.oneBit, 1);
+    run(res.twoBits, 2);
+
+    // noise, every tick is a chance to see a frame
+    handler.clear();
+    for (uint64_t i = 0; i < args.noiseBits; i++) {
+        if (feeder.ticks() - lastRefresh > 5000000) {
+            res.noise.falseRepairs += handler.frames().size();
+            refresh(false);
+        }
+        feeder.bit(uint32_t(gen.bits(1)));
+        res.noise.fed++;
+    }
+    res.noise.falseRepairs += handler.frames().size();
+    return res;
+}
+
+void print_row(const std::string& label, const Result& off, const Result& on, double scale, const std::string& unit) {
+    auto rate = [scale](uint64_t n, uint64_t fed) { return fed ? double(n) * scale / double(fed) : 0.0; };
+    std::cout << std::left << std::setw(10) << label << std::right
+              << std::setw(10) << on.fed
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << rate(off.correct, off.fed)
+              << std::setw(12) << rate(on.correct, on.fed)
+              << std::setw(12) << rate(off.falseRepairs, off.fed)
+              << std::setw(12) << rate(on.falseRepairs, on.fed)
+              << "  " << unit << "\n";
+}
+
+} // end of namespace
+
+int main(int argc, char** argv) {
+    EvalArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    const Results off = evaluate(args, false);
+    const Results on = evaluate(args, true);
+
+    std::cout << "# " << args.numAircraft << " trusted aircraft, DF 0, 4, 5, 16, 20, 21\n"
+              << "# kind           fed  correct:off          on    false:off          on\n";
+    print_row("clean", off.clean, on.clean, 100.0, "% of replies");
+    print_row("1-bit", off.oneBit, on.oneBit, 100.0, "% of replies");
+    print_row("2-bit", off.twoBits, on.twoBits, 100.0, "% of replies");
+    print_row("noise", off.noise, on.noise, 1e6, "per 1M random bits");
+    return 0;
+}
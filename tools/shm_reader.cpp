@@ -0,0 +1,157 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Example consumer of the shared memory frame ring (stream1090 -m).
+// Polls the ring, checks that the frames arrive in order and reports
+// whenever it was lapped by the writer. With -p the frames are printed
+// in the same AVR format stream1090 writes to stdout.
+
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Global.hpp"
+#include "AVRWriter.hpp"
+#include "ShmFrameRing.hpp"
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void handle_signal(int) {
+    g_stop = 1;
+}
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  shm_reader [-n <name>] [-o] [-p] [-t <seconds>]\n\n"
+    "Options:\n"
+    "  -n <name>            Name of the ring as given to stream1090 -m (default: /stream1090)\n"
+    "  -o                   Start with the oldest frame in the ring instead of the next one\n"
+    "  -p                   Print the frames as AVR to stdout\n"
+    "  -t <seconds>         Exit if there are no new frames for this long (default: run forever)\n";
+}
+
+struct ReaderArgs {
+    std::string name = "/stream1090";
+    bool fromOldest = false;
+    bool print = false;
+    double idleTimeout = 0.0;
+};
+
+bool parse_args(int argc, char** argv, ReaderArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) { out.name = argv[++i]; continue; }
+        if (arg == "-o") { out.fromOldest = true; continue; }
+        if (arg == "-p") { out.print = true; continue; }
+        if (arg == "-t" && i + 1 < argc) { out.idleTimeout = std::stod(argv[++i]); continue; }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    return true;
+}
+
+struct ReaderStats {
+    uint64_t numFrames = 0;
+    uint64_t numLapped = 0;
+    uint64_t numLost = 0;
+    uint64_t numOutOfOrder = 0;
+    uint64_t numGaps = 0;
+};
+
+void print_stats(const ReaderStats& s) {
+    std::cerr << "[shm_reader] " << s.numFrames << " frames, lapped " << s.numLapped << " times, "
+              << s.numLost << " frames lost, " << s.numGaps << " gaps, "
+              << s.numOutOfOrder << " timestamps out of order" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ReaderArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    ShmFrameRing::Reader reader;
+    if (!reader.open(args.name, args.fromOldest)) {
+        std::cerr << "[shm_reader] Cannot open ring " << args.name << std::endl;
+        return 1;
+    }
+    std::cerr << "[shm_reader] Attached to " << args.name << " (" << reader.capacity() << " slots, "
+              << reader.writeCount() << " frames written so far)" << std::endl;
+
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    AVRWriter writer(std::cout);
+    ReaderStats stats;
+    ShmFrameRing::Frame frame;
+    uint64_t lastIndex = 0;
+    uint64_t lastMlat = 0;
+    bool first = true;
+
+    using clock = std::chrono::steady_clock;
+    auto lastFrameTime = clock::now();
+    auto lastStatsTime = clock::now();
+
+    while (!g_stop) {
+        uint64_t lost = 0;
+        const auto result = reader.poll(frame, lost);
+
+        if (result == ShmFrameRing::Reader::Result::Empty) {
+            const auto now = clock::now();
+            if (args.idleTimeout > 0.0 && std::chrono::duration<double>(now - lastFrameTime).count() > args.idleTimeout)
+                break;
+            if (now - lastStatsTime > std::chrono::seconds(10)) {
+                print_stats(stats);
+                lastStatsTime = now;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if (result == ShmFrameRing::Reader::Result::Lapped) {
+            stats.numLapped++;
+            stats.numLost += lost;
+            std::cerr << "[shm_reader] Lapped by the writer, " << lost << " frames lost" << std::endl;
+            // the next frame is expected after the skipped ones
+            lastIndex = reader.next() - 1;
+            continue;
+        }
+
+        // frames are numbered without gaps, anything else is a bug in the ring
+        if (!first && frame.index != lastIndex + 1) {
+            std::cerr << "[shm_reader] Frame " << frame.index << " after frame " << lastIndex << std::endl;
+            stats.numGaps++;
+        }
+        // with several receivers the timestamps may be slightly out of order
+        if (!first && frame.mlat < lastMlat)
+            stats.numOutOfOrder++;
+
+        first = false;
+        lastIndex = frame.index;
+        lastMlat = frame.mlat;
+        lastFrameTime = clock::now();
+        stats.numFrames++;
+
+        if (args.print) {
+            if (frame.isLong)
+                writer.write_long_MLAT_RSSI(frame.mlat, frame.frame, frame.rssi);
+            else
+                writer.write_short_MLAT_RSSI(frame.mlat, frame.frame.low(), frame.rssi);
+        }
+    }
+
+    print_stats(stats);
+    return 0;
+}
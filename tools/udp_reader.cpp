@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+ * Copyright 2026 Martin Gronemann
+ *
+ * This file is part of stream1090 and is licensed under the GNU General
+ * Public License v3.0. See the top-level LICENSE file for details.
+ */
+
+// Example receiver of the UDP output (stream1090 -U). Listens on a port,
+// optionally joins a multicast group, and counts lost and reordered
+// datagrams from their sequence numbers. With -p the frames are written to
+// stdout as they came, i.e. AVR text or the Beast byte stream.
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "UdpOutput.hpp"
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void handle_signal(int) {
+    g_stop = 1;
+}
+
+void print_usage() {
+    std::cerr <<
+    "Usage:\n"
+    "  udp_reader -P <port> [-g <group>] [-p] [-t <seconds>]\n\n"
+    "Options:\n"
+    "  -P <port>            UDP port to listen on\n"
+    "  -g <group>           IPv4 multicast group to join\n"
+    "  -p                   Write the frames to stdout\n"
+    "  -t <seconds>         Exit if there are no datagrams for this long (default: run forever)\n";
+}
+
+struct ReaderArgs {
+    int port = 0;
+    std::string group;
+    bool print = false;
+    double idleTimeout = 0.0;
+};
+
+bool parse_args(int argc, char** argv, ReaderArgs& out) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-P" && i + 1 < argc) { out.port = std::stoi(argv[++i]); continue; }
+        if (arg == "-g" && i + 1 < argc) { out.group = argv[++i]; continue; }
+        if (arg == "-p") { out.print = true; continue; }
+        if (arg == "-t" && i + 1 < argc) { out.idleTimeout = std::stod(argv[++i]); continue; }
+        std::cerr << "Unknown or incomplete argument: " << arg << "\n";
+        return false;
+    }
+    return out.port > 0;
+}
+
+struct ReaderStats {
+    uint64_t numDatagrams = 0;
+    uint64_t numBytes = 0;
+    uint64_t numLost = 0;
+    uint64_t numReordered = 0;
+    uint64_t numInvalid = 0;
+};
+
+void print_stats(const ReaderStats& s) {
+    std::cerr << "[udp_reader] " << s.numDatagrams << " datagrams, " << s.numBytes << " bytes, "
+              << s.numLost << " lost, " << s.numReordered << " out of order, "
+              << s.numInvalid << " invalid" << std::endl;
+}
+
+int open_socket(const ReaderArgs& args) {
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return -1;
+
+    const int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    // wake up regularly to check the timeout and the signals
+    timeval tv{ 0, 100000 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(uint16_t(args.port));
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    if (!args.group.empty()) {
+        ip_mreq mreq{};
+        if (::inet_pton(AF_INET, args.group.c_str(), &mreq.imr_multiaddr) != 1
+            || ::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ReaderArgs args;
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return 1;
+    }
+
+    const int fd = open_socket(args);
+    if (fd < 0) {
+        std::cerr << "[udp_reader] Cannot listen on port " << args.port << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::cerr << "[udp_reader] Listening on port " << args.port << std::endl;
+
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    ReaderStats stats;
+    uint8_t buf[65536];
+    uint32_t expected = 0;
+    bool first = true;
+
+    using clock = std::chrono::steady_clock;
+    auto lastDatagramTime = clock::now();
+
+    while (!g_stop) {
+        const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (args.idleTimeout > 0.0
+                && std::chrono::duration<double>(clock::now() - lastDatagramTime).count() > args.idleTimeout)
+                break;
+            continue;
+        }
+        lastDatagramTime = clock::now();
+
+        UdpOutput::Format format;
+        uint32_t seq;
+        if (!UdpOutput::readHeader(buf, size_t(n), format, seq)) {
+            stats.numInvalid++;
+            continue;
+        }
+
+        // the difference as signed 32 bit, so the sequence number may wrap
+        const int32_t delta = first ? 0 : int32_t(seq - expected);
+        if (delta < 0) {
+            stats.numReordered++;
+            // it was counted as lost before
+            if (stats.numLost > 0)
+                stats.numLost--;
+        } else {
+            stats.numLost += uint32_t(delta);
+            expected = seq + 1;
+        }
+        first = false;
+
+        stats.numDatagrams++;
+        stats.numBytes += uint64_t(n);
+        if (args.print) {
+            std::cout.write(reinterpret_cast<const char*>(buf + UdpOutput::HeaderSize), n - UdpOutput::HeaderSize);
+        }
+    }
+
+    std::cout.flush();
+    ::close(fd);
+    print_stats(stats);
+    return 0;
+}